@@ -0,0 +1,78 @@
+// Connection-storm benchmark for the server's accept path.
+//
+// Client threads open short-lived connections (connect, one request with
+// "Connection: close", read to EOF) against a server on a per-core pool,
+// with either one shared acceptor or one SO_REUSEPORT acceptor per thread.
+// Arguments are {worker threads, reuse_port}; compare items_per_second:
+//   bin/accept_benchmark
+
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "io_context_pool.h"
+#include "server.h"
+
+namespace {
+  constexpr int kClients = 8;
+  constexpr int kConnectionsPerClient = 50;
+
+  void RunClient(unsigned short port) {
+    boost::asio::io_context io;
+    const tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+    const std::string request = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n";
+    std::string response;
+    for (int i = 0; i < kConnectionsPerClient; ++i) {
+      tcp::socket socket(io);
+      socket.connect(endpoint);
+      boost::asio::write(socket, boost::asio::buffer(request));
+      boost::system::error_code ec;
+      response.clear();
+      boost::asio::read(socket, boost::asio::dynamic_buffer(response), ec);
+      benchmark::DoNotOptimize(response.data());
+    }
+  }
+
+  void BM_ConnectionStorm(benchmark::State& state) {
+    IoContextPool pool(static_cast<std::size_t>(state.range(0)), ServerConfig::IoModel::per_core);
+    ServerConfig config;
+    config.reuse_port = state.range(1) != 0;
+    server srv(pool, 0, config);
+    std::thread runner([&pool]() { pool.run(); });
+
+    for (auto _ : state) {
+      std::vector<std::thread> clients;
+      for (int i = 0; i < kClients; ++i) {
+        clients.emplace_back(RunClient, srv.port());
+      }
+      for (auto& client : clients) {
+        client.join();
+      }
+    }
+    state.SetItemsProcessed(state.iterations() * kClients * kConnectionsPerClient);
+    state.SetLabel(config.reuse_port ? "reuse_port" : "single acceptor");
+
+    pool.stop();
+    runner.join();
+  }
+  BENCHMARK(BM_ConnectionStorm)
+      ->ArgNames({"threads", "reuse_port"})
+      ->Args({1, 0})->Args({1, 1})
+      ->Args({2, 0})->Args({2, 1})
+      ->Args({4, 0})->Args({4, 1})
+      ->Args({8, 0})->Args({8, 1})
+      ->UseRealTime()
+      ->Unit(benchmark::kMillisecond);
+} // end of namespace
+
+int main(int argc, char** argv) {
+  // Per-request logging would dominate the measurement
+  boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::error);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,76 @@
+// Microbenchmarks for DiskFileStore against a scratch directory under /tmp.
+// These include real filesystem calls, so compare runs on the same machine
+// and filesystem only:
+//   bin/disk_file_store_benchmark
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <string>
+#include "disk_file_store.h"
+
+namespace {
+  const std::string kRecord =
+    "{\"username\":\"bench-user\",\"content\":\"Anyone up for lunch at the food trucks "
+    "by Ackerman around 12:30?\",\"timestamp\":\"2026-05-14T19:30:00Z\"}";
+
+  // Removes its scratch directory on exit
+  class ScratchDir {
+  public:
+    ScratchDir() {
+      char tmpl[] = "/tmp/disk_file_store_benchmarkXXXXXX";
+      path_ = mkdtemp(tmpl) ? tmpl : "/tmp/disk_file_store_benchmark";
+    }
+    ~ScratchDir() { std::system(("rm -rf " + path_).c_str()); }
+    const std::string& path() const { return path_; }
+
+  private:
+    std::string path_;
+  };
+
+  DiskFileStore& Store(std::size_t entries) {
+    static ScratchDir dir;
+    static DiskFileStore store(dir.path());
+    static std::size_t filled = 0;
+    for (; filled < entries; ++filled) {
+      store.write("messages", static_cast<int>(filled), kRecord);
+    }
+    return store;
+  }
+
+  void BM_Write(benchmark::State& state) {
+    DiskFileStore& store = Store(0);
+    int id = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(store.write("writes", id++ % 1000, kRecord));
+    }
+  }
+  BENCHMARK(BM_Write);
+
+  void BM_Read(benchmark::State& state) {
+    DiskFileStore& store = Store(1000);
+    int id = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(store.read("messages", id++ % 1000));
+    }
+  }
+  BENCHMARK(BM_Read);
+
+  void BM_ReadMissing(benchmark::State& state) {
+    DiskFileStore& store = Store(1000);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(store.read("messages", 999999));
+    }
+  }
+  BENCHMARK(BM_ReadMissing);
+
+  void BM_ReadDirectory(benchmark::State& state) {
+    DiskFileStore& store = Store(1000);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(store.read_directory("messages"));
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+  }
+  BENCHMARK(BM_ReadDirectory);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+// Microbenchmarks for Dispatcher::match over the production route set
+// (config/gcloud.config), including a per-thread handler lookup:
+//   bin/dispatcher_benchmark
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include "dispatcher.h"
+
+namespace {
+  class StubHandler : public RequestHandler {
+  public:
+    explicit StubHandler(bool thread_safe) : thread_safe_(thread_safe) {}
+    std::unique_ptr<HttpResponse> handle_request(const HttpRequest&) override {
+      return std::make_unique<HttpResponse>();
+    }
+    std::string get_kName() override { return "StubHandler"; }
+    bool is_thread_safe() const override { return thread_safe_; }
+
+  private:
+    bool thread_safe_;
+  };
+
+  void RegisterRoutes() {
+    static bool registered = false;
+    if (registered) return;
+    registered = true;
+    auto shared = [] { return std::make_unique<StubHandler>(true); };
+    auto per_thread = [] { return std::make_unique<StubHandler>(false); };
+    for (const char* path : {"/", "/echo", "/health", "/static1", "/static2", "/api",
+                             "/api/:entity/:id", "/sleep", "/register", "/logout"}) {
+      Dispatcher::registerRoute(path, shared);
+    }
+    Dispatcher::registerRoute("/login", per_thread, {"POST"});
+    Dispatcher::registerRoute("/messages/get", shared, {"GET"});
+    Dispatcher::registerRoute("/messages/post", per_thread, {"POST"});
+  }
+
+  HttpRequest Request(const std::string& method, const std::string& path) {
+    HttpRequest req;
+    req.method = method;
+    req.path = path;
+    return req;
+  }
+
+  void BM_MatchStatic(benchmark::State& state) {
+    RegisterRoutes();
+    HttpRequest req = Request("GET", "/static1/js/app.bundle.js");
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(Dispatcher::match(req));
+    }
+  }
+  BENCHMARK(BM_MatchStatic);
+
+  void BM_MatchMessages(benchmark::State& state) {
+    RegisterRoutes();
+    HttpRequest get = Request("GET", "/messages/get");
+    HttpRequest post = Request("POST", "/messages/post");  // built per thread
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(Dispatcher::match(get));
+      benchmark::DoNotOptimize(Dispatcher::match(post));
+    }
+  }
+  BENCHMARK(BM_MatchMessages);
+
+  void BM_MatchParams(benchmark::State& state) {
+    RegisterRoutes();
+    HttpRequest req = Request("GET", "/api/shoes/42");
+    for (auto _ : state) {
+      req.path_params.clear();
+      benchmark::DoNotOptimize(Dispatcher::match(req));
+    }
+  }
+  BENCHMARK(BM_MatchParams);
+
+  void BM_MatchMiss(benchmark::State& state) {
+    RegisterRoutes();
+    HttpRequest req = Request("DELETE", "/login");  // path matches, method does not
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(Dispatcher::match(req));
+    }
+  }
+  BENCHMARK(BM_MatchMiss);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,72 @@
+// Microbenchmarks for GetMessagesHandler: listing, reading and parsing the
+// stored messages, sorting them and serializing the JSON reply. BM_Serialize
+// isolates the final json::dump over the same messages:
+//   bin/get_messages_benchmark
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "disk_file_store.h"
+#include "get_messages_handler.h"
+
+namespace {
+  nlohmann::json Message(int i) {
+    char timestamp[32];
+    std::snprintf(timestamp, sizeof(timestamp), "2026-05-14T%02d:%02d:%02dZ",
+                  (i / 3600) % 24, (i / 60) % 60, i % 60);
+    return {{"username", "user" + std::to_string(i % 50)},
+            {"content", "Message " + std::to_string(i) +
+                        ": anyone up for lunch at the food trucks by Ackerman around 12:30?"},
+            {"timestamp", timestamp}};
+  }
+
+  // A messages directory with `count` messages, written in reverse time
+  // order so the handler's sort has work to do
+  class MessageDir {
+  public:
+    explicit MessageDir(int count) {
+      char tmpl[] = "/tmp/get_messages_benchmarkXXXXXX";
+      path_ = mkdtemp(tmpl) ? tmpl : "/tmp/get_messages_benchmark";
+      DiskFileStore store(path_);
+      for (int i = 0; i < count; ++i) {
+        store.write("", i, Message(count - i).dump());
+      }
+    }
+    ~MessageDir() { std::system(("rm -rf " + path_).c_str()); }
+    const std::string& path() const { return path_; }
+
+  private:
+    std::string path_;
+  };
+
+  void BM_GetMessages(benchmark::State& state) {
+    int count = static_cast<int>(state.range(0));
+    MessageDir dir(count);
+    GetMessagesHandler handler("/messages/get", new DiskFileStore(dir.path()));
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/messages/get";
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(handler.handle_request(req));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+  BENCHMARK(BM_GetMessages)->Arg(10)->Arg(100)->Arg(1000);
+
+  void BM_Serialize(benchmark::State& state) {
+    int count = static_cast<int>(state.range(0));
+    std::vector<nlohmann::json> messages;
+    for (int i = 0; i < count; ++i) {
+      messages.push_back(Message(i));
+    }
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(nlohmann::json(messages).dump());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+  }
+  BENCHMARK(BM_Serialize)->Arg(10)->Arg(100)->Arg(1000);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,114 @@
+// Scalar vs SIMD header scanning on realistic header blocks.
+//
+// Each benchmark takes the kernel as its first argument (0 = scalar,
+// 1 = sse4.2, 2 = avx2) and the header set as its second; kernels the CPU
+// does not support are skipped.
+
+#include <benchmark/benchmark.h>
+#include <boost/system/error_code.hpp>
+#include <string>
+#include "header_scanner.h"
+#include "request_parser.h"
+
+namespace {
+  std::string CurlHeaders() {
+    return "GET /static1/index.html HTTP/1.1\r\n"
+           "Host: localhost:8080\r\n"
+           "User-Agent: curl/8.5.0\r\n"
+           "Accept: */*\r\n"
+           "\r\n";
+  }
+
+  std::string BrowserHeaders() {
+    return "GET /messages/get HTTP/1.1\r\n"
+           "Host: name-not-found-404.example.com\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:126.0) Gecko/20100101 Firefox/126.0\r\n"
+           "Accept: application/json, text/plain, */*\r\n"
+           "Accept-Language: en-US,en;q=0.5\r\n"
+           "Accept-Encoding: gzip, deflate, br\r\n"
+           "Connection: keep-alive\r\n"
+           "Referer: https://name-not-found-404.example.com/static1/messages.html\r\n"
+           "Cookie: session=4f9c2d7e1a8b3c6d5e0f9a8b7c6d5e4f; _ga=GA1.1.123456789.1700000000\r\n"
+           "Sec-Fetch-Dest: empty\r\n"
+           "Sec-Fetch-Mode: cors\r\n"
+           "Sec-Fetch-Site: same-origin\r\n"
+           "\r\n";
+  }
+
+  // Large analytics cookies and a bearer token, the case SIMD should help most
+  std::string HeavyHeaders() {
+    std::string cookie = "session=4f9c2d7e1a8b3c6d5e0f9a8b7c6d5e4f";
+    for (int i = 0; i < 24; ++i) {
+      cookie += "; _tracker_" + std::to_string(i) + "=" + std::string(64, 'a' + i % 26);
+    }
+    return "POST /api/Shoes HTTP/1.1\r\n"
+           "Host: name-not-found-404.example.com\r\n"
+           "Authorization: Bearer " + std::string(1024, 'T') + "\r\n"
+           "Cookie: " + cookie + "\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: 2\r\n"
+           "\r\n"
+           "{}";
+  }
+
+  const std::string& Input(int index) {
+    static const std::string inputs[] = {CurlHeaders(), BrowserHeaders(), HeavyHeaders()};
+    return inputs[index];
+  }
+
+  bool UseKernel(benchmark::State& state) {
+    auto kernel = static_cast<HeaderScanner::Kernel>(state.range(0));
+    if (!HeaderScanner::set_kernel(kernel)) {
+      state.SkipWithError("kernel not supported on this CPU");
+      return false;
+    }
+    state.SetLabel(HeaderScanner::kernel_name(kernel));
+    return true;
+  }
+
+  void KernelsAndInputs(benchmark::internal::Benchmark* b) {
+    for (int kernel = 0; kernel < 3; ++kernel) {
+      for (int input = 0; input < 3; ++input) {
+        b->Args({kernel, input});
+      }
+    }
+  }
+} // end of namespace
+
+static void BM_FindHeaderEnd(benchmark::State& state) {
+  if (!UseKernel(state)) return;
+  const std::string& input = Input(state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HeaderScanner::find_header_end(input.data(), input.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_FindHeaderEnd)->Apply(KernelsAndInputs);
+
+static void BM_Frame(benchmark::State& state) {
+  if (!UseKernel(state)) return;
+  const std::string& input = Input(state.range(1));
+  for (auto _ : state) {
+    std::size_t request_len = 0;
+    benchmark::DoNotOptimize(
+        RequestParser::frame(input.data(), input.size(), 64 * 1024, 1 << 20, request_len));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Frame)->Apply(KernelsAndInputs);
+
+static void BM_ParseView(benchmark::State& state) {
+  if (!UseKernel(state)) return;
+  const std::string& input = Input(state.range(1));
+  RequestParser parser;
+  RequestView view;
+  boost::system::error_code ec;
+  for (auto _ : state) {
+    parser.parse_view(input.data(), input.size(), view, ec);
+    benchmark::DoNotOptimize(view);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseView)->Apply(KernelsAndInputs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+// Microbenchmarks for HttpHeaders against the std::map it replaced.
+//
+// Each iteration builds the header set of a typical browser request and then
+// does the lookups the session and middleware make per request:
+//   bin/http_headers_benchmark
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "http_headers.h"
+
+namespace {
+  const std::vector<std::pair<std::string, std::string>> kFields = {
+    {"Host", "name-not-found-404.example.com"},
+    {"User-Agent", "Mozilla/5.0 (X11; Linux x86_64; rv:126.0) Gecko/20100101 Firefox/126.0"},
+    {"Accept", "application/json, text/plain, */*"},
+    {"Accept-Language", "en-US,en;q=0.5"},
+    {"Accept-Encoding", "gzip, deflate, br"},
+    {"Content-Type", "application/json"},
+    {"Content-Length", "34"},
+    {"Connection", "keep-alive"},
+    {"Cookie", "session=4f9c2d7e1a8b3c6d5e0f9a8b7c6d5e4f"},
+    {"Sec-Fetch-Mode", "cors"},
+  };
+
+  void BM_MapHeaders(benchmark::State& state) {
+    for (auto _ : state) {
+      std::map<std::string, std::string> headers;
+      for (const auto& field : kFields) {
+        headers[field.first] = field.second;
+      }
+      benchmark::DoNotOptimize(headers.find("Connection"));
+      benchmark::DoNotOptimize(headers.find("Cookie"));
+      benchmark::DoNotOptimize(headers.find("Authorization"));
+      for (const auto& header : headers) {
+        benchmark::DoNotOptimize(header.second.size());
+      }
+    }
+  }
+  BENCHMARK(BM_MapHeaders);
+
+  void BM_FlatHeaders(benchmark::State& state) {
+    for (auto _ : state) {
+      HttpHeaders headers;
+      for (const auto& field : kFields) {
+        headers.add(field.first, field.second);
+      }
+      benchmark::DoNotOptimize(headers.find(HeaderId::connection));
+      benchmark::DoNotOptimize(headers.find(HeaderId::cookie));
+      benchmark::DoNotOptimize(headers.find(HeaderId::authorization));
+      for (const auto& header : headers) {
+        benchmark::DoNotOptimize(header.second.size());
+      }
+    }
+  }
+  BENCHMARK(BM_FlatHeaders);
+
+  void BM_FlatHeadersByName(benchmark::State& state) {
+    for (auto _ : state) {
+      HttpHeaders headers;
+      for (const auto& field : kFields) {
+        headers.add(field.first, field.second);
+      }
+      benchmark::DoNotOptimize(headers.find("connection"));
+      benchmark::DoNotOptimize(headers.find("Sec-Fetch-Mode"));
+      benchmark::DoNotOptimize(headers.find("X-Missing"));
+    }
+  }
+  BENCHMARK(BM_FlatHeadersByName);
+} // end of namespace
+
+BENCHMARK_MAIN();
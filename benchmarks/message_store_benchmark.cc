@@ -0,0 +1,37 @@
+// Microbenchmarks for MessageStore. get_all copies the whole history, so it
+// is measured at several store sizes before BM_Add grows the store:
+//   bin/message_store_benchmark
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include "message_store.h"
+
+namespace {
+  const std::string kContent = "Anyone up for lunch at the food trucks by Ackerman around 12:30?";
+
+  void FillTo(std::size_t size) {
+    MessageStore& store = MessageStore::instance();
+    for (std::size_t n = store.get_all().size(); n < size; ++n) {
+      store.add("user" + std::to_string(n % 50), kContent);
+    }
+  }
+
+  void BM_GetAll(benchmark::State& state) {
+    FillTo(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(MessageStore::instance().get_all());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_GetAll)->Arg(10)->Arg(100)->Arg(1000);
+
+  void BM_Add(benchmark::State& state) {
+    for (auto _ : state) {
+      MessageStore::instance().add("bench-user", kContent);
+    }
+  }
+  // Bounded, since every iteration keeps its message
+  BENCHMARK(BM_Add)->Iterations(200000);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,136 @@
+// Microbenchmarks for RequestParser.
+//
+// BM_LegacyParse keeps the previous istringstream-based implementation so the
+// view parser can be compared against it on the same inputs:
+//   bin/request_parser_benchmark --benchmark_filter=Parse
+
+#include <benchmark/benchmark.h>
+#include <boost/system/error_code.hpp>
+#include <sstream>
+#include <string>
+#include "request_parser.h"
+
+namespace {
+  const std::string kSmallGet =
+    "GET /static1/index.html HTTP/1.1\r\n"
+    "Host: localhost:8080\r\n"
+    "User-Agent: curl/8.5.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+  const std::string kBrowserPost =
+    "POST /messages/post HTTP/1.1\r\n"
+    "Host: name-not-found-404.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:126.0) Gecko/20100101 Firefox/126.0\r\n"
+    "Accept: application/json, text/plain, */*\r\n"
+    "Accept-Language: en-US,en;q=0.5\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 34\r\n"
+    "Origin: https://name-not-found-404.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: https://name-not-found-404.example.com/static1/messages.html\r\n"
+    "Cookie: session=4f9c2d7e1a8b3c6d5e0f9a8b7c6d5e4f; _ga=GA1.1.123456789.1700000000; "
+    "_ga_XYZ=GS1.1.1700000000.1.1.1700000100.0.0.0\r\n"
+    "Sec-Fetch-Dest: empty\r\n"
+    "Sec-Fetch-Mode: cors\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "\r\n"
+    "{\"content\":\"hello from benchmark\"}";
+
+  // The parser as it was before the string_view rewrite.
+  HttpRequest LegacyParse(const char* data, std::size_t len, boost::system::error_code& ec) {
+    ec.clear();
+    std::string raw(data, len);
+    HttpRequest req;
+    req.raw.assign(data, len);
+    auto split = raw.find("\r\n\r\n");
+    std::string head = (split == std::string::npos ? raw : raw.substr(0, split));
+    if (split != std::string::npos) {
+      req.body = raw.substr(split + 4);
+    }
+    std::istringstream lines(head);
+    std::string request_line;
+    if (!std::getline(lines, request_line) || request_line.empty()) {
+      ec = boost::system::errc::make_error_code(boost::system::errc::protocol_error);
+      return {};
+    }
+    if (request_line.back() == '\r')
+      request_line.pop_back();
+    std::istringstream rl(request_line);
+    if (!(rl >> req.method >> req.path >> req.version)) {
+      ec = boost::system::errc::make_error_code(boost::system::errc::protocol_error);
+      return {};
+    }
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if (line.empty())
+        break;
+      auto colon = line.find(':');
+      if (colon == std::string::npos)
+        continue;
+      std::string name  = line.substr(0, colon);
+      std::string value = line.substr(colon + 1);
+      if (!value.empty() && value[0] == ' ')
+        value.erase(0,1);
+      req.headers[name] = value;
+    }
+    return req;
+  }
+
+  const std::string& Input(int index) {
+    return index == 0 ? kSmallGet : kBrowserPost;
+  }
+} // end of namespace
+
+static void BM_LegacyParse(benchmark::State& state) {
+  const std::string& input = Input(state.range(0));
+  boost::system::error_code ec;
+  for (auto _ : state) {
+    HttpRequest req = LegacyParse(input.data(), input.size(), ec);
+    benchmark::DoNotOptimize(req);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_LegacyParse)->Arg(0)->Arg(1);
+
+static void BM_Parse(benchmark::State& state) {
+  const std::string& input = Input(state.range(0));
+  RequestParser parser;
+  boost::system::error_code ec;
+  for (auto _ : state) {
+    HttpRequest req = parser.parse(input.data(), input.size(), ec);
+    benchmark::DoNotOptimize(req);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Parse)->Arg(0)->Arg(1);
+
+static void BM_ParseView(benchmark::State& state) {
+  const std::string& input = Input(state.range(0));
+  RequestParser parser;
+  RequestView view;
+  boost::system::error_code ec;
+  for (auto _ : state) {
+    parser.parse_view(input.data(), input.size(), view, ec);
+    benchmark::DoNotOptimize(view);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_ParseView)->Arg(0)->Arg(1);
+
+static void BM_Frame(benchmark::State& state) {
+  const std::string& input = Input(state.range(0));
+  for (auto _ : state) {
+    std::size_t request_len = 0;
+    auto framing = RequestParser::frame(input.data(), input.size(), 8192, 1 << 20, request_len);
+    benchmark::DoNotOptimize(framing);
+    benchmark::DoNotOptimize(request_len);
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+BENCHMARK(BM_Frame)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
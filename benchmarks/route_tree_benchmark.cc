@@ -0,0 +1,64 @@
+// Microbenchmarks for RouteTree matching as the number of locations grows.
+//
+// BM_LinearPrefixScan keeps the previous unordered_map scan for comparison:
+//   bin/route_tree_benchmark
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <unordered_map>
+#include "route_tree.h"
+
+namespace {
+  std::string RoutePath(int i) {
+    return "/service" + std::to_string(i) + "/v1";
+  }
+
+  // Probe the last registered location, plus a parameterized route
+  std::string StaticProbe(int routes) {
+    return RoutePath(routes - 1) + "/assets/app.js";
+  }
+
+  void BM_RouteTree(benchmark::State& state) {
+    int routes = static_cast<int>(state.range(0));
+    RouteTree tree;
+    tree.insert("/", "", 0);
+    for (int i = 0; i < routes; ++i) {
+      tree.insert(RoutePath(i), "", i + 1);
+    }
+    tree.insert("/api/:entity/:id", "GET", routes + 1);
+    const std::string probe = StaticProbe(routes);
+    RouteTree::Params params;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(tree.match(probe, "GET"));
+      benchmark::DoNotOptimize(tree.match("/api/shoes/42", "GET", &params));
+    }
+  }
+  BENCHMARK(BM_RouteTree)->Arg(12)->Arg(100)->Arg(1000);
+
+  void BM_LinearPrefixScan(benchmark::State& state) {
+    int routes = static_cast<int>(state.range(0));
+    std::unordered_map<std::string, int> table{{"/", 0}};
+    for (int i = 0; i < routes; ++i) {
+      table[RoutePath(i)] = i + 1;
+    }
+    table["/api"] = routes + 1;
+    const std::string probe = StaticProbe(routes);
+    auto scan = [&table](std::string path) {
+      std::string longest;
+      for (const auto& [key, value] : table) {
+        if (path.rfind(key, 0) == std::string::npos) { continue; }
+        if (key.length() > longest.length()) {
+          longest = key;
+        }
+      }
+      return table[longest];
+    };
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(scan(probe));
+      benchmark::DoNotOptimize(scan("/api/shoes/42"));
+    }
+  }
+  BENCHMARK(BM_LinearPrefixScan)->Arg(12)->Arg(100)->Arg(1000);
+} // end of namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+// Microbenchmarks for session handling: SessionStore lookups and inserts,
+// and SessionMiddlewareHandler's token extraction, measured through
+// handle_request around a no-op handler since extract_session_token is
+// private:
+//   bin/session_benchmark
+
+#include <benchmark/benchmark.h>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "session_middleware_handler.h"
+#include "session_store.h"
+
+namespace {
+  constexpr int kLiveSessions = 10000;
+
+  // Tokens of kLiveSessions sessions, created once
+  const std::vector<std::string>& Tokens() {
+    static std::vector<std::string> tokens = [] {
+      std::vector<std::string> out;
+      for (int i = 0; i < kLiveSessions; ++i) {
+        out.push_back(SessionStore::get_instance().create_session("user" + std::to_string(i)));
+      }
+      return out;
+    }();
+    return tokens;
+  }
+
+  class NoopHandler : public RequestHandler {
+  public:
+    std::unique_ptr<HttpResponse> handle_request(const HttpRequest&) override {
+      auto res = std::make_unique<HttpResponse>();
+      res->status_code = 200;
+      return res;
+    }
+    std::string get_kName() override { return "NoopHandler"; }
+  };
+
+  void BM_GetSessionHit(benchmark::State& state) {
+    const auto& tokens = Tokens();
+    std::size_t i = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(SessionStore::get_instance().get_session(tokens[i++ % tokens.size()]));
+    }
+  }
+  BENCHMARK(BM_GetSessionHit);
+
+  void BM_GetSessionMiss(benchmark::State& state) {
+    Tokens();
+    const std::string token = "0123456789abcdef0123456789abcdef";
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(SessionStore::get_instance().get_session(token));
+    }
+  }
+  BENCHMARK(BM_GetSessionMiss);
+
+  void BM_CreateSession(benchmark::State& state) {
+    std::vector<std::string> created;
+    created.reserve(state.max_iterations);
+    for (auto _ : state) {
+      created.push_back(SessionStore::get_instance().create_session("bench-user"));
+    }
+    // Untimed: the loop above has ended
+    for (const auto& token : created) {
+      SessionStore::get_instance().invalidate_session(token);
+    }
+  }
+  BENCHMARK(BM_CreateSession);
+
+  // A browser request's cookies, with the session cookie between analytics ones
+  void BM_MiddlewareCookie(benchmark::State& state) {
+    SessionMiddlewareHandler handler(std::make_unique<NoopHandler>());
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/messages/get";
+    req.headers.add("Cookie", "_ga=GA1.1.123456789.1700000000; session=" + Tokens()[42] +
+                              "; _ga_XYZ=GS1.1.1700000000.1.1.1700000100.0.0.0");
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(handler.handle_request(req));
+    }
+  }
+  BENCHMARK(BM_MiddlewareCookie);
+
+  void BM_MiddlewareBearer(benchmark::State& state) {
+    SessionMiddlewareHandler handler(std::make_unique<NoopHandler>());
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/messages/get";
+    req.headers.add("Authorization", "Bearer " + Tokens()[42]);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(handler.handle_request(req));
+    }
+  }
+  BENCHMARK(BM_MiddlewareBearer);
+
+  void BM_MiddlewareAnonymous(benchmark::State& state) {
+    SessionMiddlewareHandler handler(std::make_unique<NoopHandler>());
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/messages/get";
+    req.headers.add("Accept", "application/json");
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(handler.handle_request(req));
+    }
+  }
+  BENCHMARK(BM_MiddlewareAnonymous);
+}
+
+int main(int argc, char** argv) {
+  // SessionStore logs every session it creates or invalidates at info, which
+  // would dominate the measurement
+  boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::error);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,156 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <boost/asio/ip/address.hpp>
+
+// On-disk layout of an access log segment, host byte order (little-endian
+// on every platform we run on). A segment is a SegmentHeader followed by
+// 8-byte aligned entries, each starting with a 16-bit kind:
+//
+//   kString: StringEntry then `length` bytes, padded to a multiple of 8.
+//            Defines `id` for the paths, methods and handler names used
+//            by later records in the same segment.
+//   kRequest: one RequestRecord (64 bytes).
+//
+// A kind of 0 marks the end of the written data. Every segment defines its
+// own strings, so each one decodes on its own.
+namespace access_log {
+  constexpr char kMagic[8] = {'S', 'R', 'V', 'A', 'C', 'C', 'L', '1'};
+  constexpr std::uint32_t kVersion = 1;
+
+  enum Kind : std::uint16_t { kEnd = 0, kString = 1, kRequest = 2 };
+
+  struct SegmentHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size;
+    std::uint64_t created_us;  // microseconds since the epoch
+    std::uint8_t reserved[40];
+  };
+  static_assert(sizeof(SegmentHeader) == 64, "segment header layout");
+
+  struct StringEntry {
+    std::uint16_t kind;  // kString
+    std::uint16_t length;
+    std::uint32_t id;
+  };
+  static_assert(sizeof(StringEntry) == 8, "string entry layout");
+
+  struct RequestRecord {
+    std::uint16_t kind;  // kRequest
+    std::uint16_t status;
+    std::uint32_t latency_us;
+    std::uint64_t timestamp_us;  // when the response was ready, since the epoch
+    std::uint64_t bytes_in;      // request line, headers and body
+    std::uint64_t bytes_out;     // response head and body
+    std::uint32_t path_id;
+    std::uint32_t handler_id;
+    std::uint32_t method_id;
+    std::uint8_t client_addr[16];  // IPv6, or IPv4-mapped IPv6
+    std::uint16_t client_port;
+    std::uint16_t reserved;
+  };
+  static_assert(sizeof(RequestRecord) == 64, "request record layout");
+}
+
+// Binary access log. Each request becomes one fixed-size record copied into
+// a memory-mapped segment file under a mutex; paths, methods and handler
+// names are interned per segment and written once. When a segment is full
+// it is truncated to its used length and the next one is started, so a
+// directory holds a series of access-<time>-<pid>-<n>.bin files. Decode them
+// with the access_log_decode tool.
+class AccessLog {
+public:
+  static AccessLog& instance();
+
+  AccessLog() = default;
+  ~AccessLog();
+
+  AccessLog(const AccessLog&) = delete;
+  AccessLog& operator=(const AccessLog&) = delete;
+
+  // Start writing segments of `segment_size` bytes into `dir`. Returns
+  // false, leaving the log disabled, if the first segment cannot be created.
+  bool open(const std::string& dir, std::size_t segment_size);
+
+  // Finish the current segment and stop logging.
+  void close();
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  struct Request {
+    std::chrono::system_clock::time_point time;
+    std::chrono::microseconds latency{0};
+    int status = 0;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    boost::asio::ip::address client;
+    std::uint16_t client_port = 0;
+    std::string_view method;
+    std::string_view path;
+    std::string_view handler;
+  };
+
+  // Append one request. Does nothing while the log is disabled.
+  void record(const Request& request);
+
+  // Number of segments started since open().
+  std::size_t segments() const;
+
+private:
+  bool start_segment_locked();
+  void finish_segment_locked();
+  std::size_t space_locked(std::string_view value) const;
+  std::uint32_t intern_locked(std::string_view value);
+
+  mutable std::mutex mutex_;
+  std::atomic<bool> enabled_{false};
+  std::string dir_;
+  std::size_t segment_size_ = 0;
+  std::size_t segments_ = 0;
+  int fd_ = -1;
+  char* base_ = nullptr;
+  std::size_t used_ = 0;
+  // Interned strings of the current segment; the keys view the segment itself
+  std::unordered_map<std::string_view, std::uint32_t> strings_;
+};
+
+// One decoded request record.
+struct AccessLogEntry {
+  std::uint64_t timestamp_us = 0;
+  std::uint32_t latency_us = 0;
+  int status = 0;
+  std::uint64_t bytes_in = 0;
+  std::uint64_t bytes_out = 0;
+  std::string client;
+  std::uint16_t client_port = 0;
+  std::string method;
+  std::string path;
+  std::string handler;
+};
+
+class AccessLogReader {
+public:
+  // Call `visit` for every request in the segment at `file`, in order.
+  // Returns false with `error` set if the file is not a segment or is
+  // corrupt; records before the damage are still visited.
+  static bool read(const std::string& file, const std::function<void(const AccessLogEntry&)>& visit,
+                   std::string& error);
+
+  // One line of text, like a common log format line with latency and handler.
+  static std::string to_text(const AccessLogEntry& entry);
+
+  // One JSON object.
+  static std::string to_json(const AccessLogEntry& entry);
+};
+
+#endif
@@ -15,6 +15,7 @@ public:
  std::unique_ptr<HttpResponse> handle_request(const HttpRequest& req) override;
  static const std::string kName;
  std::string get_kName() { return kName; };
+ bool is_thread_safe() const override { return true; }
 private:
  std::string mount_;
  std::shared_ptr<FileStore> store_;
@@ -0,0 +1,111 @@
+#ifndef ASYNC_LOG_BACKEND_H
+#define ASYNC_LOG_BACKEND_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/log/core/record_view.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/basic_sink_frontend.hpp>
+#include <boost/shared_ptr.hpp>
+
+// Boost.Log sink backend that takes records off the logging thread. Each
+// thread that logs gets its own bounded single-producer ring, so logging is
+// a refcount bump and two atomic stores with no shared lock. One writer
+// thread drains every ring and hands each batch to `Writer`, which formats
+// and writes it. When a thread's ring is full, the record is dropped or the
+// thread waits for the writer, per `Overflow`; the writer is told how many
+// records were dropped since its last batch. The writer thread never logs
+// through the core itself, since core::flush() holds the core's lock while
+// it waits for the writer.
+//
+// Install it with AsyncLogSink below.
+class AsyncLogBackend
+    : public boost::log::sinks::basic_sink_backend<boost::log::sinks::combine_requirements<
+          boost::log::sinks::concurrent_feeding, boost::log::sinks::flushing>::type> {
+public:
+  enum class Overflow { drop, block };
+  using Batch = std::vector<boost::log::record_view>;
+  // Writes `batch`; `dropped` records were lost before it.
+  using Writer = std::function<void(const Batch& batch, std::uint64_t dropped)>;
+
+  // `ring_size` records per thread, rounded up to a power of two.
+  AsyncLogBackend(Writer writer, std::size_t ring_size, Overflow overflow);
+  ~AsyncLogBackend();
+
+  AsyncLogBackend(const AsyncLogBackend&) = delete;
+  AsyncLogBackend& operator=(const AsyncLogBackend&) = delete;
+
+  void consume(const boost::log::record_view& rec);
+
+  // Wait until every record consumed before the call has been written.
+  void flush();
+
+  // Records dropped because a ring was full.
+  std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  class Ring;
+
+  Ring& local_ring();
+  void wake();
+  bool collect(Batch& batch);
+  void run();
+
+  Writer writer_;
+  std::size_t ring_size_;
+  Overflow overflow_;
+  std::uint64_t id_;  // tells this backend's thread-local rings from another's
+
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable flushed_cv_;
+  std::atomic<bool> sleeping_{false};
+  std::atomic<bool> stop_{false};
+  std::atomic<std::uint64_t> flush_requested_{0};
+  std::uint64_t flush_done_ = 0;  // guarded by wake_mutex_
+  std::atomic<std::uint64_t> dropped_{0};
+
+  std::thread thread_;
+};
+
+// Frontend for AsyncLogBackend. Like sinks::unlocked_sink it feeds the
+// backend without a lock, but it registers as a cross-thread sink so the
+// core detaches thread-specific values (thread id, severity) from each
+// record before it is handed to the writer thread.
+class AsyncLogSink : public boost::log::sinks::basic_sink_frontend {
+public:
+  explicit AsyncLogSink(boost::shared_ptr<AsyncLogBackend> backend)
+    : basic_sink_frontend(true), backend_(std::move(backend)) {}
+
+  void consume(const boost::log::record_view& rec) override {
+    NoLock lock;
+    feed_record(rec, lock, *backend_);
+  }
+
+  void flush() override {
+    NoLock lock;
+    flush_backend(lock, *backend_);
+  }
+
+  AsyncLogBackend& backend() { return *backend_; }
+
+private:
+  struct NoLock {
+    void lock() {}
+    void unlock() {}
+  };
+
+  boost::shared_ptr<AsyncLogBackend> backend_;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef BYTE_RANGE_H
+#define BYTE_RANGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// An inclusive span of bytes [first, last] of a representation.
+struct ByteRange {
+  std::uint64_t first;
+  std::uint64_t last;
+
+  std::uint64_t length() const { return last - first + 1; }
+  bool operator==(const ByteRange& o) const { return first == o.first && last == o.last; }
+};
+
+// Parser for the `Range: bytes=...` request header (RFC 9110 section 14).
+class ByteRangeParser {
+public:
+  enum class Result {
+    ignored,        // no usable Range header; send the whole representation (200)
+    satisfiable,    // at least one range overlaps the representation (206)
+    unsatisfiable,  // valid, but no range overlaps it (416)
+  };
+
+  // Most ranges honoured in one request; more are ignored, so a single
+  // request cannot make the server assemble an unbounded multipart body.
+  static constexpr std::size_t kMaxRanges = 16;
+
+  // Resolve `header` against a representation of `size` bytes. On
+  // `satisfiable`, `ranges` holds the overlapping ranges in request order,
+  // clamped to the representation. Malformed headers, units other than
+  // bytes, more than kMaxRanges ranges, or overlapping ranges are `ignored`.
+  static Result parse(std::string_view header, std::uint64_t size,
+                      std::vector<ByteRange>& ranges);
+
+  // Content-Range value for `range`, e.g. "bytes 0-499/1234".
+  static std::string content_range(const ByteRange& range, std::uint64_t size);
+
+  // Content-Range value for a 416, e.g. "bytes */1234".
+  static std::string unsatisfied_range(std::uint64_t size);
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Content codings the server can produce, in order of preference.
+enum class ContentCoding { br, gzip };
+
+// Accept-Encoding negotiation plus gzip (zlib) and brotli encoders, shared
+// by StaticHandler and CompressionMiddlewareHandler.
+class Compression {
+public:
+  // How hard to compress: `fast` for responses compressed on every request,
+  // `best` for results that are cached and reused.
+  enum class Level { fast, best };
+
+  // Codings the client accepts per `accept_encoding`, most preferred first.
+  // Higher q-values win, brotli wins ties, q=0 excludes and `*` stands for
+  // any coding not listed.
+  static std::vector<ContentCoding> accepted(std::string_view accept_encoding);
+
+  // Whether a body of `content_type` is worth compressing (text, JSON, XML,
+  // JavaScript, SVG); already-compressed formats like images and archives are not.
+  static bool compressible(std::string_view content_type);
+
+  // Encode `input` into `out`. Returns false if the encoder fails.
+  static bool compress(ContentCoding coding, std::string_view input, std::string& out,
+                       Level level = Level::fast);
+
+  // Content-Encoding token, e.g. "br".
+  static const char* token(ContentCoding coding);
+
+  // File name suffix of a precompressed sibling, e.g. ".br".
+  static const char* extension(ContentCoding coding);
+
+  // Distinct strong ETag for an encoded variant of the representation tagged `etag`.
+  static std::string variant_etag(const std::string& etag, ContentCoding coding);
+};
+
+#endif
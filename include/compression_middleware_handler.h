@@ -0,0 +1,39 @@
+#ifndef COMPRESSION_MIDDLEWARE_HANDLER_H
+#define COMPRESSION_MIDDLEWARE_HANDLER_H
+
+#include "request_handler.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Wraps a handler and compresses its responses with the best coding the
+// client accepts. Only in-memory 2xx bodies of a compressible Content-Type
+// and at least `min_size` bytes are compressed, and only if that makes them
+// smaller; `Vary: Accept-Encoding` is added to every compressible response.
+class CompressionMiddlewareHandler : public RequestHandler {
+public:
+  static constexpr std::size_t kDefaultMinSize = 1024;
+
+  explicit CompressionMiddlewareHandler(std::unique_ptr<RequestHandler> next,
+                                        std::size_t min_size = kDefaultMinSize);
+
+  std::unique_ptr<HttpResponse> handle_request(const HttpRequest& request) override;
+  void handle_request_async(const HttpRequest& request,
+                            boost::asio::any_io_executor executor,
+                            ResponseCallback done) override;
+  std::string get_kName() override { return next_handler_->get_kName(); }
+  bool is_thread_safe() const override { return next_handler_->is_thread_safe(); }
+  bool needs_raw_request() const override { return next_handler_->needs_raw_request(); }
+
+  RequestHandler* next() const { return next_handler_.get(); }
+
+  // Compress `res` in place for `request` under the rules above.
+  static void compress_response(const HttpRequest& request, HttpResponse& res,
+                                std::size_t min_size);
+
+private:
+  std::unique_ptr<RequestHandler> next_handler_;
+  std::size_t min_size_;
+};
+
+#endif // COMPRESSION_MIDDLEWARE_HANDLER_H
@@ -8,8 +8,11 @@
 #include "echo_handler.h"
 #include "static_handler.h"
 #include "not_found_handler.h"
+#include "server_config.h"
 
 bool parseConfig(const char* config_file, int& port);
+// Same as above, additionally filling server-wide settings into `server_config`.
+bool parseConfig(const char* config_file, int& port, ServerConfig& server_config);
 
 class NginxConfig;
 
@@ -1,16 +1,56 @@
 #pragma once
 
 #include "request_handler.h"
+#include "route_tree.h"
+#include <cstdint>
 #include <functional>
-#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <vector>
 
+// Maps URL patterns to handlers through a RouteTree, so matching costs one
+// walk of the request path regardless of how many locations are configured.
+// Routes may be limited to a set of methods and may capture ":name" segments,
+// which are exposed as HttpRequest::path_params.
+//
+// Handlers are built when their route is registered (at config load), not per
+// request: a thread-safe handler is shared by every worker thread, while any
+// other handler is built lazily once per worker thread from the route's factory.
 class Dispatcher {
 public:
   using HandlerFactory = std::function<std::unique_ptr<RequestHandler>()>;
   
-  static void registerRoute(std::string path, HandlerFactory factory);
-  static std::unique_ptr<RequestHandler> match(std::string path);
+  // Route `path` to the handler built by `factory` for `methods`, or for any
+  // method when `methods` is empty. Re-registering a path and method replaces
+  // the earlier route. Returns false if `factory` built no handler.
+  static bool registerRoute(std::string path, HandlerFactory factory,
+                            const std::vector<std::string>& methods = {});
+
+  // Handler for the longest registered pattern matching `path`, or nullptr
+  // if none does or it does not accept `method`; in the latter case the
+  // methods it accepts are written to `allowed` when it is non-null. The
+  // Dispatcher owns the handler; it stays valid until its route is
+  // registered again. Captures are written to `params` when it is non-null,
+  // and the path the matched route was registered under to `route`.
+  static RequestHandler* match(std::string_view path, std::string_view method = {},
+                               RouteTree::Params* params = nullptr,
+                               std::vector<std::string>* allowed = nullptr,
+                               std::string* route = nullptr);
+
+  // As above for `req`'s path and method, filling in `req.path_params`.
+  static RequestHandler* match(HttpRequest& req);
 
 private:
-  static std::unordered_map<std::string, HandlerFactory> routes;  
-};
\ No newline at end of file
+  struct Route {
+    std::uint64_t id;                        // keys the per-thread instances
+    std::string path;                        // as registered, for metrics
+    HandlerFactory factory;
+    std::unique_ptr<RequestHandler> shared;  // set for thread-safe handlers
+    bool per_thread = false;
+  };
+
+  static RequestHandler* instance(std::size_t index);
+
+  static std::vector<Route> routes;  // indexed by the values stored in `tree`
+  static RouteTree tree;
+};
@@ -13,6 +13,8 @@ public:
   std::unique_ptr<HttpResponse> handle_request(const HttpRequest& req) override;
   static const std::string kName;
   std::string get_kName() { return kName; };
+  bool is_thread_safe() const override { return true; }
+  bool needs_raw_request() const override { return true; }
 
 protected:
   std::string path_;
@@ -0,0 +1,58 @@
+#ifndef FILE_BODY_H
+#define FILE_BODY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A response body that is a byte range of an open file. The session sends it
+// with sendfile(2), so the contents go from the page cache to the socket
+// without being copied through userspace.
+class FileBody {
+public:
+  // Open `path` read-only; nullptr if it cannot be opened or is not a regular file.
+  static std::shared_ptr<FileBody> open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      return nullptr;
+    }
+    return std::shared_ptr<FileBody>(
+        new FileBody(fd, 0, static_cast<std::uint64_t>(st.st_size), st));
+  }
+
+  ~FileBody() { ::close(fd_); }
+
+  // Send only `size` bytes starting at `offset`, e.g. for a Range request.
+  void set_range(std::uint64_t offset, std::uint64_t size) {
+    offset_ = offset;
+    size_ = size;
+  }
+
+  FileBody(const FileBody&) = delete;
+  FileBody& operator=(const FileBody&) = delete;
+
+  int fd() const { return fd_; }
+  std::uint64_t offset() const { return offset_; }  // first byte to send
+  std::uint64_t size() const { return size_; }      // bytes to send
+  std::uint64_t file_size() const { return static_cast<std::uint64_t>(stat_.st_size); }
+  const struct stat& stat() const { return stat_; }
+
+private:
+  FileBody(int fd, std::uint64_t offset, std::uint64_t size, const struct stat& st)
+    : fd_(fd), offset_(offset), size_(size), stat_(st) {}
+
+  int fd_;
+  std::uint64_t offset_;
+  std::uint64_t size_;
+  struct stat stat_;
+};
+
+#endif
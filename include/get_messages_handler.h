@@ -14,6 +14,7 @@ class GetMessagesHandler : public RequestHandler {
 public:
     static const std::string kName;
     std::string get_kName() override { return kName; }
+    bool is_thread_safe() const override { return true; }
 
     GetMessagesHandler(const std::string& path, FileStore* store);
 
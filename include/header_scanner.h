@@ -0,0 +1,33 @@
+#ifndef HEADER_SCANNER_H
+#define HEADER_SCANNER_H
+
+#include <cstddef>
+
+// Byte-scanning primitives used by RequestParser, in the style of
+// picohttpparser. Each primitive has a scalar (memchr-based) implementation
+// plus 128-bit SSE4.2 and 256-bit AVX2 kernels; the widest kernel the CPU
+// supports is picked at startup from CPUID.
+class HeaderScanner {
+public:
+  enum class Kernel { scalar, sse42, avx2 };
+
+  // Offset of the first "\r\n\r\n" in [data, data + len), or `len` if absent.
+  static std::size_t find_header_end(const char* data, std::size_t len);
+
+  // Offset of the first `c` in [data, data + len), or `len` if absent.
+  static std::size_t find_char(const char* data, std::size_t len, char c);
+
+  // The kernel currently in use.
+  static Kernel kernel();
+
+  // Whether this CPU can run `k`.
+  static bool supported(Kernel k);
+
+  // Switch kernels, e.g. to compare them in benchmarks. Returns false and
+  // leaves the current kernel in place if `k` is unsupported.
+  static bool set_kernel(Kernel k);
+
+  static const char* kernel_name(Kernel k);
+};
+
+#endif
@@ -19,6 +19,7 @@ public:
 
     static const std::string kName;
     std::string get_kName() { return kName; };
+    bool is_thread_safe() const override { return true; }
 private:
     std::string uri_prefix_;
 };
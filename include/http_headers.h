@@ -0,0 +1,225 @@
+#ifndef HTTP_HEADERS_H
+#define HTTP_HEADERS_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <boost/container/small_vector.hpp>
+
+// Headers the server looks up on hot paths. Names are interned to an id when
+// a field is added so that lookups by these names compare a byte, not a string.
+enum class HeaderId : std::uint8_t {
+  other,
+  authorization,
+  connection,
+  content_length,
+  content_type,
+  cookie,
+  host,
+  set_cookie,
+  transfer_encoding,
+};
+
+// Header fields of a request or response, stored flat in arrival order.
+//
+// Requests rarely carry more than a handful of headers, so fields live inline
+// in a small_vector and lookups are a linear scan. Name comparison is
+// case-insensitive and repeated fields (e.g. Set-Cookie) are kept as separate
+// entries. Iteration yields std::pair<name, value> like the std::map this
+// replaces; names must not be modified through an iterator.
+class HttpHeaders {
+public:
+  using value_type = std::pair<std::string, std::string>;
+  using storage_type = boost::container::small_vector<value_type, 8>;
+  using iterator = storage_type::iterator;
+  using const_iterator = storage_type::const_iterator;
+
+  HttpHeaders() = default;
+  HttpHeaders(std::initializer_list<value_type> fields) { assign(fields); }
+
+  HttpHeaders& operator=(std::initializer_list<value_type> fields) {
+    assign(fields);
+    return *this;
+  }
+
+  // Value of the first field named `name`, appending an empty one if absent.
+  std::string& operator[](std::string_view name) {
+    auto it = find(name);
+    if (it != fields_.end()) {
+      return it->second;
+    }
+    add(std::string(name), std::string());
+    return fields_.back().second;
+  }
+
+  // First field named `name` (any case), or end().
+  iterator find(std::string_view name) { return fields_.begin() + index_of(name); }
+  const_iterator find(std::string_view name) const { return fields_.begin() + index_of(name); }
+  iterator find(HeaderId id) { return fields_.begin() + index_of(id); }
+  const_iterator find(HeaderId id) const { return fields_.begin() + index_of(id); }
+
+  std::size_t count(std::string_view name) const {
+    HeaderId id = lookup_id(name);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+      n += matches(i, id, name);
+    }
+    return n;
+  }
+
+  // Append a field, keeping any existing fields of the same name.
+  void add(std::string name, std::string value) {
+    ids_.push_back(lookup_id(name));
+    fields_.emplace_back(std::move(name), std::move(value));
+  }
+
+  // Replace every field named `name` with a single field.
+  void set(std::string_view name, std::string value) {
+    erase(name);
+    add(std::string(name), std::move(value));
+  }
+
+  // Remove every field named `name`; returns how many were removed.
+  std::size_t erase(std::string_view name) {
+    HeaderId id = lookup_id(name);
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+      if (matches(i, id, name)) {
+        continue;
+      }
+      if (kept != i) {
+        fields_[kept] = std::move(fields_[i]);
+        ids_[kept] = ids_[i];
+      }
+      ++kept;
+    }
+    std::size_t removed = fields_.size() - kept;
+    fields_.resize(kept);
+    ids_.resize(kept);
+    return removed;
+  }
+
+  // Values of every field named `name`, in arrival order.
+  std::vector<std::string_view> values(std::string_view name) const {
+    HeaderId id = lookup_id(name);
+    std::vector<std::string_view> out;
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+      if (matches(i, id, name)) {
+        out.emplace_back(fields_[i].second);
+      }
+    }
+    return out;
+  }
+
+  HeaderId id_at(std::size_t index) const { return ids_[index]; }
+
+  iterator begin() { return fields_.begin(); }
+  iterator end() { return fields_.end(); }
+  const_iterator begin() const { return fields_.begin(); }
+  const_iterator end() const { return fields_.end(); }
+  std::size_t size() const { return fields_.size(); }
+  bool empty() const { return fields_.empty(); }
+  void reserve(std::size_t n) { fields_.reserve(n); ids_.reserve(n); }
+  void clear() { fields_.clear(); ids_.clear(); }
+
+  // Same fields in the same order; names compare case-insensitively.
+  friend bool operator==(const HttpHeaders& a, const HttpHeaders& b) {
+    if (a.fields_.size() != b.fields_.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.fields_.size(); ++i) {
+      if (!iequals(a.fields_[i].first, b.fields_[i].first) ||
+          a.fields_[i].second != b.fields_[i].second) {
+        return false;
+      }
+    }
+    return true;
+  }
+  friend bool operator!=(const HttpHeaders& a, const HttpHeaders& b) { return !(a == b); }
+
+  static bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      if (lower(a[i]) != lower(b[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Interned id for a well-known header name, HeaderId::other otherwise.
+  static HeaderId lookup_id(std::string_view name) {
+    switch (name.size()) {
+      case 4:
+        if (iequals(name, "host")) return HeaderId::host;
+        break;
+      case 6:
+        if (iequals(name, "cookie")) return HeaderId::cookie;
+        break;
+      case 10:
+        if (iequals(name, "connection")) return HeaderId::connection;
+        if (iequals(name, "set-cookie")) return HeaderId::set_cookie;
+        break;
+      case 12:
+        if (iequals(name, "content-type")) return HeaderId::content_type;
+        break;
+      case 13:
+        if (iequals(name, "authorization")) return HeaderId::authorization;
+        break;
+      case 14:
+        if (iequals(name, "content-length")) return HeaderId::content_length;
+        break;
+      case 17:
+        if (iequals(name, "transfer-encoding")) return HeaderId::transfer_encoding;
+        break;
+    }
+    return HeaderId::other;
+  }
+
+private:
+  static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+
+  bool matches(std::size_t i, HeaderId id, std::string_view name) const {
+    if (id != HeaderId::other) {
+      return ids_[i] == id;
+    }
+    return ids_[i] == HeaderId::other && iequals(fields_[i].first, name);
+  }
+
+  std::size_t index_of(std::string_view name) const {
+    HeaderId id = lookup_id(name);
+    std::size_t i = 0;
+    while (i < fields_.size() && !matches(i, id, name)) {
+      ++i;
+    }
+    return i;
+  }
+
+  std::size_t index_of(HeaderId id) const {
+    std::size_t i = 0;
+    while (i < ids_.size() && ids_[i] != id) {
+      ++i;
+    }
+    return i;
+  }
+
+  void assign(std::initializer_list<value_type> fields) {
+    clear();
+    reserve(fields.size());
+    for (const auto& field : fields) {
+      add(field.first, field.second);
+    }
+  }
+
+  storage_type fields_;
+  boost::container::small_vector<HeaderId, 8> ids_;
+};
+
+#endif
@@ -1,23 +1,31 @@
 #ifndef HTTP_TYPES_H
 #define HTTP_TYPES_H
 
-#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include "file_body.h"
+#include "http_headers.h"
+#include "shared_bytes.h"
 #include "session_context.h"
 
 struct HttpRequest {
   std::string method;
   std::string path;
-  std::map<std::string, std::string> headers;
+  std::string version;
+  HttpHeaders headers;
   std::string body;
   std::string raw;
   std::string client_ip;
+  std::unordered_map<std::string, std::string> path_params;  // ":name" captures from the route
   SessionContext session_context;
 };
 
 struct HttpResponse {
   int status_code;
-  std::map<std::string, std::string> headers;
+  HttpHeaders headers;
   std::string body;
+  std::shared_ptr<FileBody> file;  // when set, sent with sendfile(2) in place of `body`
+  SharedBytes shared_body;  // when set, sent in place of `body` without a copy
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef IO_CONTEXT_POOL_H
+#define IO_CONTEXT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include "server_config.h"
+
+// The worker threads and the io_contexts they run.
+//
+// In the shared model all threads run a single io_context, so any thread may
+// pick up any connection's work. In the per-core model each thread owns an
+// io_context and is pinned to a core; a connection handed to one context
+// stays on that thread for its lifetime.
+class IoContextPool {
+public:
+  // `threads` of 0 means std::thread::hardware_concurrency().
+  IoContextPool(std::size_t threads, ServerConfig::IoModel model);
+  ~IoContextPool();
+
+  IoContextPool(const IoContextPool&) = delete;
+  IoContextPool& operator=(const IoContextPool&) = delete;
+
+  // Context for the next new connection, round-robin across the pool.
+  boost::asio::io_context& next();
+
+  boost::asio::io_context& context(std::size_t index) { return *contexts_[index]; }
+  std::size_t contexts() const { return contexts_.size(); }
+  std::size_t threads() const { return threads_; }
+  ServerConfig::IoModel model() const { return model_; }
+
+  // Start the worker threads and block until every context has stopped.
+  void run();
+
+  // Stop every context; run() returns once the threads exit.
+  void stop();
+
+  static std::size_t resolve_threads(std::size_t threads);
+
+private:
+  using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  std::size_t threads_;
+  ServerConfig::IoModel model_;
+  std::vector<std::unique_ptr<boost::asio::io_context>> contexts_;
+  std::vector<WorkGuard> work_;  // keeps idle contexts running until stop()
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> next_{0};
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef LOADGEN_H
+#define LOADGEN_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// HTTP load generator for end-to-end benchmarks of the server over loopback.
+// Each simulated client is a thread with its own connection, sending a
+// weighted mix of requests:
+//
+//   static    GET of one static file
+//   echo      GET /echo
+//   api       a create, read, update, delete cycle on /api, one step per request
+//   messages  alternating POST /messages/post and GET /messages/get, after
+//             an untimed register and login
+//
+// In closed-loop mode each client sends its next request as soon as the
+// previous response arrives. With a target rate the run is open-loop: every
+// request has an intended send time on a fixed schedule, and its latency is
+// measured from that time, not from when it was actually sent. A stalled
+// server therefore shows up in the percentiles instead of silently lowering
+// the request rate (coordinated omission).
+namespace loadgen {
+  enum class Kind { static_file, echo, api, messages };
+  constexpr Kind kKinds[] = {Kind::static_file, Kind::echo, Kind::api, Kind::messages};
+
+  const char* kind_name(Kind kind);
+
+  // Request kinds with relative weights.
+  using Mix = std::vector<std::pair<Kind, unsigned>>;
+
+  // Parse "static=4,echo=1,api=1": weights must be positive integers and
+  // each kind may appear once. Returns false with `error` set otherwise.
+  bool parse_mix(const std::string& text, Mix& mix, std::string& error);
+
+  struct Options {
+    std::string host = "127.0.0.1";
+    unsigned short port = 8080;
+    std::size_t connections = 16;
+    double duration_s = 10;
+    double warmup_s = 1;  // requests sent during the warmup are not counted
+    // Requests per connection before reconnecting; 0 keeps each connection
+    // for the whole run.
+    std::size_t requests_per_connection = 0;
+    double rate = 0;  // requests per second over all connections; 0 is closed-loop
+    Mix mix = {{Kind::echo, 1}};
+    std::string static_path = "/static1/index.html";
+    std::uint32_t seed = 1;  // the request sequence is the same for the same seed
+    // Start this server binary with this config for the run, then stop it
+    std::string server;
+    std::string server_config;
+    std::string out;  // write the report here instead of stdout
+  };
+
+  // Parse command line flags into `options`; see kUsage.
+  bool parse_options(int argc, const char* const argv[], Options& options, std::string& error);
+  extern const char* const kUsage;
+
+  // Intended send times for one connection in open-loop mode: every
+  // `interval`, from `start`.
+  class Schedule {
+  public:
+    using Clock = std::chrono::steady_clock;
+    Schedule(Clock::time_point start, Clock::duration interval) : next_(start), interval_(interval) {}
+    Clock::time_point next() {
+      auto t = next_;
+      next_ += interval_;
+      return t;
+    }
+
+  private:
+    Clock::time_point next_;
+    Clock::duration interval_;
+  };
+
+  // Counts and latencies for one kind of request, or for all of them.
+  struct Stats {
+    std::uint64_t requests = 0;
+    std::uint64_t errors = 0;  // transport failures and 4xx/5xx responses
+    std::uint64_t latency_sum_us = 0;
+    std::uint64_t latency_max_us = 0;
+    std::vector<std::uint64_t> latency;  // LatencyHistogram bucket counts
+
+    void record(std::uint64_t micros, bool error);
+    void merge(const Stats& other);
+  };
+
+  struct Result {
+    double elapsed_s = 0;  // measured time, excluding the warmup
+    std::uint64_t connections_opened = 0;
+    std::uint64_t connect_errors = 0;
+    Stats total;
+    std::map<Kind, Stats> by_kind;
+  };
+
+  // Run the load described by `options` against a running server.
+  Result run(const Options& options);
+
+  // The options and result as one JSON object.
+  std::string report(const Options& options, const Result& result);
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef LOG_LEVEL_HANDLER_H
+#define LOG_LEVEL_HANDLER_H
+
+#include <memory>
+#include <string>
+#include "http_types.h"
+#include "request_handler.h"
+
+// Admin endpoint for the log level and request log sampling. GET shows both;
+// PUT or POST with a body such as "level=debug&sample_every=100" changes
+// either or both while the server runs.
+class LogLevelHandler : public RequestHandler {
+public:
+  std::unique_ptr<HttpResponse> handle_request(const HttpRequest& request) override;
+
+  static const std::string kName;
+  std::string get_kName() { return kName; };
+  bool is_thread_safe() const override { return true; }
+};
+
+#endif
@@ -1,2 +1,48 @@
 #pragma once
-void init_logging();
\ No newline at end of file
+#include <cstddef>
+#include <string>
+#include <boost/log/trivial.hpp>
+
+// How log records reach the console and the log file.
+struct LogOptions {
+  // Hand records to a writer thread instead of formatting and writing them
+  // on the thread that logs (see async_log_backend.h).
+  bool async = false;
+
+  // Records each logging thread may have queued in async mode.
+  std::size_t queue_size = 8192;
+
+  // What a thread does when its queue is full: drop the record, or wait.
+  enum class Overflow { drop, block };
+  Overflow overflow = Overflow::drop;
+
+  // Least severe level written.
+  boost::log::trivial::severity_level level = boost::log::trivial::trace;
+
+  // Keep the per-request info lines of one request in `sample_every`;
+  // responses with an error status are always logged.
+  unsigned sample_every = 1;
+};
+
+// Set up synchronous console and file sinks.
+void init_logging();
+
+// Replace any existing sinks with console and file sinks set up per `options`.
+void init_logging(const LogOptions& options);
+
+// Write out queued records and remove the sinks.
+void shutdown_logging();
+
+// Least severe level written; may be changed while the server runs.
+void set_log_level(boost::log::trivial::severity_level level);
+boost::log::trivial::severity_level log_level();
+
+// Parse a level name such as "info"; false if it is not one.
+bool parse_log_level(const std::string& name, boost::log::trivial::severity_level& level);
+
+// Log the per-request lines of one request in `every`; 0 or 1 logs every request.
+void set_log_sampling(unsigned every);
+unsigned log_sampling();
+
+// Whether the request being started is one whose per-request lines are logged.
+bool sample_request_log();
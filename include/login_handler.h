@@ -15,6 +15,7 @@ public:
     std::unique_ptr<HttpResponse> handle_request(const HttpRequest& request) override;
 
     std::string get_kName() override { return kName; }
+    bool is_thread_safe() const override { return true; }
 
 private:
     std::string path_;
@@ -16,6 +16,7 @@ public:
 
     static const std::string kName;
     std::string get_kName() override { return kName; }
+    bool is_thread_safe() const override { return true; }
 
 private:
     std::string path_;
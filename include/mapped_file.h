@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <memory>
+#include <string_view>
+#include <sys/mman.h>
+#include "file_body.h"
+
+// A read-only mapping of a whole file, shared by every response that sends
+// from it. The mapped bytes are only ever handed to the kernel (socket
+// writes), never read in userspace: if the file is truncated underneath,
+// a write fails with EFAULT, whereas reading the mapping directly would
+// raise SIGBUS. Use the open file (source()) for reads in userspace.
+class MappedFile {
+public:
+  // Map all of `file`; nullptr if it is empty or mmap fails.
+  static std::shared_ptr<const MappedFile> map(std::shared_ptr<const FileBody> file) {
+    std::size_t size = static_cast<std::size_t>(file->file_size());
+    if (size == 0) {
+      return nullptr;
+    }
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file->fd(), 0);
+    if (addr == MAP_FAILED) {
+      return nullptr;
+    }
+    return std::shared_ptr<const MappedFile>(new MappedFile(std::move(file), addr, size));
+  }
+
+  ~MappedFile() { ::munmap(addr_, size_); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  std::string_view bytes() const { return std::string_view(static_cast<const char*>(addr_), size_); }
+  const FileBody& source() const { return *file_; }
+
+private:
+  MappedFile(std::shared_ptr<const FileBody> file, void* addr, std::size_t size)
+    : file_(std::move(file)), addr_(addr), size_(size) {}
+
+  std::shared_ptr<const FileBody> file_;
+  void* addr_;
+  std::size_t size_;
+};
+
+#endif
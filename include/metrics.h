@@ -0,0 +1,84 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "request_timing.h"
+
+// Latency histogram with log-linear buckets, as in HdrHistogram: every
+// power of two is split into kSubBuckets equal buckets, so a recorded value
+// lands in a bucket no wider than 1/kSubBuckets of it (12.5%) from one
+// microsecond up to days. Counts are relaxed atomics written by one thread.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 3;
+  static constexpr std::size_t kSubBuckets = std::size_t(1) << kSubBits;
+  static constexpr std::size_t kBuckets = (40 - kSubBits + 1) * kSubBuckets;
+
+  void record(std::uint64_t micros);
+
+  // Add this histogram's counts to `into`.
+  void add_to(std::vector<std::uint64_t>& into) const;
+
+  static std::size_t bucket(std::uint64_t micros);
+  // Largest value that falls in bucket `index`.
+  static std::uint64_t upper_bound(std::size_t index);
+  // Value at quantile `q` of merged `counts`: the upper bound of the bucket
+  // holding it, so never an underestimate by more than one bucket width.
+  static std::uint64_t quantile(const std::vector<std::uint64_t>& counts, double q);
+
+private:
+  std::array<std::atomic<std::uint64_t>, kBuckets> counts_{};
+};
+
+// Process-wide request metrics, rendered in the Prometheus text format by
+// MetricsHandler. Each thread that records gets its own shard, padded to
+// whole cache lines, and only ever writes its own shard with relaxed
+// atomics; nothing is shared on the request path. A scrape walks every
+// shard and adds them up.
+class Metrics {
+public:
+  static Metrics& instance();
+
+  Metrics();
+
+  Metrics(const Metrics&) = delete;
+  Metrics& operator=(const Metrics&) = delete;
+
+  // Count one response from `handler` serving the location `route`.
+  void record_request(const std::string& handler, const std::string& route, int status,
+                      std::chrono::microseconds latency,
+                      std::uint64_t bytes_in, std::uint64_t bytes_out);
+
+  // Add the stages of one written response from `handler` on `route` to
+  // its per-stage histograms.
+  void record_stages(const std::string& handler, const std::string& route,
+                     const RequestTiming& timing);
+
+  void connection_opened();
+  void connection_closed();
+
+  // Every metric in the Prometheus text exposition format.
+  std::string scrape() const;
+
+private:
+  struct HandlerStats;
+  struct Shard;
+
+  Shard& local_shard();
+  HandlerStats& local_stats(const std::string& handler, const std::string& route);
+
+  std::uint64_t id_;  // tells this instance's thread-local shards from another's
+  mutable std::mutex shards_mutex_;
+  std::vector<std::shared_ptr<Shard>> shards_;  // kept after their thread exits
+};
+
+#endif
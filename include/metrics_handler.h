@@ -0,0 +1,19 @@
+#ifndef METRICS_HANDLER_H
+#define METRICS_HANDLER_H
+
+#include <memory>
+#include <string>
+#include "http_types.h"
+#include "request_handler.h"
+
+// Serves Metrics::instance() in the Prometheus text format on GET.
+class MetricsHandler : public RequestHandler {
+public:
+  std::unique_ptr<HttpResponse> handle_request(const HttpRequest& request) override;
+
+  static const std::string kName;
+  std::string get_kName() { return kName; };
+  bool is_thread_safe() const override { return true; }
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef MIME_TYPES_H
+#define MIME_TYPES_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Maps file extensions to Content-Types for StaticHandler. A sorted
+// built-in table covers common web, font, image, media and archive types;
+// the `types {}` config block adds to or overrides it. Extensions are
+// matched case-insensitively. Entries are added at startup, before
+// requests are served, so lookups need no lock.
+class MimeTypes {
+public:
+  static MimeTypes& instance();
+
+  MimeTypes() = default;
+
+  // Map `extension` (without the dot) to `type`, overriding the built-in table.
+  void add(std::string_view extension, std::string type);
+
+  // Content-Type of the file at `path` by its extension; "" if it has none
+  // or it is unknown.
+  std::string lookup(std::string_view path) const;
+
+  // Built-in type of a lower-case `extension`; "" if there is none.
+  static std::string_view builtin(std::string_view extension);
+
+private:
+  std::unordered_map<std::string, std::string> types_;
+};
+
+#endif
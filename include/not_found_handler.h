@@ -9,6 +9,7 @@ public:
   std::unique_ptr<HttpResponse> handle_request(const HttpRequest& req);
   static const std::string kName;
   std::string get_kName() { return kName; };
+  bool is_thread_safe() const override { return true; }
 protected:
 std::string path_;
 };
\ No newline at end of file
@@ -7,6 +7,7 @@ class PostMessageHandler : public RequestHandler {
 public:
   static const std::string kName;
   std::string get_kName() override { return kName; }
+  bool is_thread_safe() const override { return true; }
   
   explicit PostMessageHandler(const std::string& data_path);
   virtual ~PostMessageHandler() = default;
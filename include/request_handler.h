@@ -6,12 +6,36 @@
 #include <map>
 #include <functional>
 #include <memory>
+#include <boost/asio/any_io_executor.hpp>
+
+// Receives a handler's response. It may be called from any thread.
+using ResponseCallback = std::function<void(std::unique_ptr<HttpResponse>)>;
 
 class RequestHandler {
 public:
   virtual ~RequestHandler() = default;
   virtual std::unique_ptr<HttpResponse> handle_request(const HttpRequest& req) = 0;
+
+  // Asynchronous entry point used by the session. Handlers that wait on
+  // timers or I/O override this, start the wait on `executor` (the
+  // connection's executor) and return at once, calling `done` exactly once
+  // when the response is ready. `req` stays valid until `done` is called.
+  // The default answers synchronously through handle_request.
+  virtual void handle_request_async(const HttpRequest& req,
+                                    boost::asio::any_io_executor /*executor*/,
+                                    ResponseCallback done) {
+    done(handle_request(req));
+  }
   virtual std::string get_kName() = 0;
+
+  // Whether one instance may serve concurrent requests from several threads.
+  // The Dispatcher shares thread-safe handlers across workers and gives each
+  // worker thread its own instance of any other handler.
+  virtual bool is_thread_safe() const { return false; }
+
+  // Whether the handler reads HttpRequest::raw. The session copies a
+  // request's raw bytes out of its read buffer only for handlers that do.
+  virtual bool needs_raw_request() const { return false; }
 };
 
 using RequestHandlerFactory = std::function<RequestHandler*(
@@ -2,11 +2,55 @@
 #define REQUEST_PARSER_H
 
 #include "http_types.h"
+#include <boost/container/small_vector.hpp>
 #include <boost/system/error_code.hpp>
+#include <string_view>
+
+// A parsed request whose fields are slices of the caller's buffer. Nothing
+// is copied, so a RequestView is only valid while that buffer is unchanged.
+struct RequestView {
+  struct Header {
+    std::string_view name;
+    std::string_view value;
+  };
+
+  std::string_view method;
+  std::string_view target;
+  std::string_view version;
+  boost::container::small_vector<Header, 16> headers;
+  std::string_view body;
+  std::string_view raw;
+
+  // Copy the slices into an owned HttpRequest for handlers. `raw` is left
+  // empty unless `with_raw` is set.
+  HttpRequest materialize(bool with_raw = true) const;
+};
 
 class RequestParser {
 public:
+  // Outcome of locating a request's boundaries at the front of a buffer.
+  enum class Framing {
+    incomplete,        // need more bytes before the request can be parsed
+    complete,          // `request_len` bytes hold one full request
+    header_too_large,  // header block exceeds the cap (431)
+    body_too_large,    // declared Content-Length exceeds the cap (413)
+    unsupported,       // Transfer-Encoding bodies are not supported (501)
+    malformed,         // Content-Length is not a number (400)
+  };
+
   // Parse up to `len` bytes in `data`. On success, return a filled Request. On parse error, set `ec`.
   HttpRequest parse(const char* data, std::size_t len, boost::system::error_code& ec);
+
+  // Parse up to `len` bytes in `data` into `view` without allocating.
+  // Returns false and sets `ec` on a malformed request.
+  bool parse_view(const char* data, std::size_t len, RequestView& view,
+                  boost::system::error_code& ec);
+
+  // Inspect the bytes buffered so far and report whether a full request
+  // (headers plus Content-Length bytes of body) is present. Only the header
+  // block is scanned, so oversized requests are rejected before their body is read.
+  static Framing frame(const char* data, std::size_t len,
+                       std::size_t max_header_bytes, std::size_t max_body_bytes,
+                       std::size_t& request_len);
 };
-#endif
\ No newline at end of file
+#endif
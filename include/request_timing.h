@@ -0,0 +1,83 @@
+#ifndef REQUEST_TIMING_H
+#define REQUEST_TIMING_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Timestamps of one request's trip through the session. steady_clock is
+// read through the vDSO from the CPU's timestamp counter on Linux, so a
+// mark costs tens of nanoseconds and needs no calibration of its own.
+// Marks that were never set are skipped: only a connection's first request
+// has kAccepted, and a request no handler matched has no handler marks.
+class RequestTiming {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum Mark {
+    kAccepted,      // the connection was accepted
+    kFirstByte,     // the read holding the request's first byte completed
+    kReceived,      // the whole request was buffered
+    kParseStart,    // the parser was called, after the per-connection bookkeeping
+    kParsed,
+    kRouted,
+    kHandlerStart,
+    kHandlerEnd,
+    kReady,         // the response was serialized and queued
+    kWritten,       // the last byte of the response was written
+    kMarkCount
+  };
+
+  // Spans between marks, as reported in Server-Timing and by /metrics.
+  enum Stage { kWait, kRecv, kParse, kRoute, kHandler, kWrite, kStageCount };
+
+  static const char* stage_name(Stage stage) {
+    static const char* const kNames[kStageCount] = {"wait", "recv", "parse", "route", "handler", "write"};
+    return kNames[stage];
+  }
+
+  void mark(Mark m) { marks_[m] = Clock::now(); }
+  void set(Mark m, Clock::time_point t) { marks_[m] = t; }
+  bool has(Mark m) const { return marks_[m] != Clock::time_point(); }
+  Clock::time_point at(Mark m) const { return marks_[m]; }
+
+  // Length of `stage`, or false if either of its marks is unset.
+  bool duration(Stage stage, std::chrono::microseconds& out) const {
+    static const Mark kBounds[kStageCount][2] = {
+      {kAccepted, kFirstByte}, {kFirstByte, kReceived}, {kParseStart, kParsed},
+      {kParsed, kRouted}, {kHandlerStart, kHandlerEnd}, {kReady, kWritten},
+    };
+    Mark from = kBounds[stage][0];
+    Mark to = kBounds[stage][1];
+    if (!has(from) || !has(to)) {
+      return false;
+    }
+    out = std::chrono::duration_cast<std::chrono::microseconds>(marks_[to] - marks_[from]);
+    return true;
+  }
+
+  // Server-Timing header value for every stage measured so far, in
+  // milliseconds, e.g. "recv;dur=0.012, parse;dur=0.004, handler;dur=1.250".
+  std::string server_timing() const {
+    std::string out;
+    for (int s = 0; s < kStageCount; ++s) {
+      std::chrono::microseconds span;
+      if (!duration(static_cast<Stage>(s), span)) {
+        continue;
+      }
+      char buf[48];
+      std::snprintf(buf, sizeof(buf), "%s%s;dur=%.3f", out.empty() ? "" : ", ",
+                    stage_name(static_cast<Stage>(s)), span.count() / 1000.0);
+      out += buf;
+    }
+    return out;
+  }
+
+private:
+  std::array<Clock::time_point, kMarkCount> marks_{};
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef ROUTE_TREE_H
+#define ROUTE_TREE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Prefix tree of URL patterns keyed by path segment. A pattern such as
+// "/api/:entity/:id" matches any path whose leading segments fit it, so
+// "/api/shoes/3/extra" matches with entity=shoes, id=3. Segments starting
+// with ':' capture one non-empty segment. Matching walks the path once,
+// preferring literal segments over captures and the longest pattern overall.
+//
+// Values are opaque indices chosen by the caller (the Dispatcher's route table).
+class RouteTree {
+public:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  // Captured (name, value) pairs; values are slices of the matched path.
+  using Params = std::vector<std::pair<std::string_view, std::string_view>>;
+
+  // Map `pattern` to `value` for requests with `method`, or for any method
+  // when `method` is empty. Returns the value this replaced, or npos.
+  std::size_t insert(std::string_view pattern, std::string_view method, std::size_t value);
+
+  // Value of the longest pattern matching `path` on segment boundaries, or
+  // npos if none does. Anything after a '?' is ignored. Captures for the
+  // chosen pattern are written to `params` when it is non-null. When that
+  // pattern does not accept `method`, the result is npos rather than a
+  // shorter pattern's value, and the methods it does accept are written to
+  // `allowed` when it is non-null.
+  std::size_t match(std::string_view path, std::string_view method, Params* params = nullptr,
+                    std::vector<std::string>* allowed = nullptr) const;
+
+private:
+  struct Node {
+    std::string segment;                          // literal text, or capture name
+    std::vector<std::unique_ptr<Node>> children;  // literal children, sorted by segment
+    std::unique_ptr<Node> capture;                // the ":name" child, if any
+    std::vector<std::pair<std::string, std::size_t>> values;  // method ("" = any) -> value
+
+    std::size_t value_for(std::string_view method) const;
+    // First child whose segment is not less than `segment`
+    std::vector<std::unique_ptr<Node>>::iterator find_child(std::string_view segment);
+    std::vector<std::unique_ptr<Node>>::const_iterator find_child(std::string_view segment) const;
+  };
+
+  struct Best {
+    std::size_t value = npos;
+    int depth = -1;
+    Params params;
+    const Node* deepest = nullptr;  // longest matching pattern, for any method
+    int deepest_depth = -1;
+  };
+
+  static void walk(const Node& node, std::string_view rest, int depth,
+                   std::string_view method, Params& captured, Best& best);
+
+  Node root_;
+};
+
+#endif
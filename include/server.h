@@ -3,27 +3,47 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
-#include <boost/asio/thread_pool.hpp>
 
 using boost::asio::ip::tcp;
 
+#include "io_context_pool.h"
 #include "session.h"
+#include "server_config.h"
 
 class server
 {
 public:
-    server(boost::asio::io_service& io_service, short port);
+    // Serve every connection on `io_service`.
+    server(boost::asio::io_service& io_service, short port,
+           const ServerConfig& config = ServerConfig());
 
-    void start_accept();
-    void handle_accept(session* new_session, const boost::system::error_code& error);
-    void join_pool();
+    // Serve connections on the pool's worker threads. With `reuse_port` set,
+    // each worker thread gets its own SO_REUSEPORT acceptor on its context and
+    // keeps the connections it accepts. Otherwise one acceptor on the first
+    // context hands connections to the pool's contexts round-robin.
+    server(IoContextPool& pool, short port,
+           const ServerConfig& config = ServerConfig());
+
+    void start_accept(std::size_t acceptor = 0);
+    void handle_accept(std::shared_ptr<session> new_session, const boost::system::error_code& error,
+                       std::size_t acceptor = 0);
+
+    // The bound port, useful when constructed with port 0.
+    unsigned short port() const;
+    std::size_t acceptors() const { return acceptors_.size(); }
 
 private:
+  void open_acceptor(boost::asio::io_service& io_service, unsigned short port, bool reuse_port);
+
   boost::asio::io_service& io_service_;
-  tcp::acceptor acceptor_;
-  boost::asio::thread_pool thread_pool_{4};
+  IoContextPool* pool_ = nullptr;
+  std::vector<std::unique_ptr<tcp::acceptor>> acceptors_;
+  std::vector<boost::asio::io_service*> acceptor_contexts_;  // context of each acceptor
+  std::shared_ptr<const ServerConfig> config_;  // shared with every session
   friend class ServerTest;
 };
 #endif
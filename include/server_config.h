@@ -0,0 +1,65 @@
+#ifndef SERVER_CONFIG_H
+#define SERVER_CONFIG_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include "logger.h"
+
+// Server-wide settings parsed from the top level of the config file.
+// Every field has a default so a config with only `port` still works.
+struct ServerConfig {
+  // Seconds an idle keep-alive connection is held open waiting for the next request.
+  int keepalive_timeout = 5;
+
+  // Maximum number of requests served on one connection before it is closed.
+  int keepalive_requests = 100;
+
+  // Largest accepted request line plus headers, in bytes; larger requests get a 431.
+  std::size_t max_header_size = 8 * 1024;
+
+  // Largest accepted request body, in bytes; larger Content-Lengths get a 413.
+  std::size_t max_body_size = 1024 * 1024;
+
+  // Pipelined requests dispatched per connection before earlier responses must drain.
+  std::size_t max_pipelined_requests = 16;
+
+  // How worker threads share io_contexts.
+  enum class IoModel {
+    shared,    // every thread runs one io_context
+    per_core,  // one io_context per thread, each thread pinned to a core
+  };
+  IoModel io_model = IoModel::shared;
+
+  // Worker threads; 0 means std::thread::hardware_concurrency().
+  std::size_t threads = 0;
+
+  // Open one SO_REUSEPORT acceptor per worker thread so the kernel spreads
+  // new connections across them instead of funnelling through one accept queue.
+  bool reuse_port = false;
+
+  // Byte budget of the in-memory static file cache; 0 disables it.
+  std::size_t static_cache_size = 64 * 1024 * 1024;
+
+  // Largest static file the cache maps with mmap; 0 turns mapping off.
+  std::size_t static_mmap_max_size = 64 * 1024 * 1024;
+
+  // Extension and Content-Type pairs from the `types {}` block, added to the
+  // built-in MIME table (see mime_types.h).
+  std::vector<std::pair<std::string, std::string>> mime_types;
+
+  // Synchronous or asynchronous logging, and the async queue's size and policy.
+  LogOptions log;
+
+  // Add a Server-Timing header with each request's phase durations.
+  bool server_timing = false;
+
+  // Directory for binary access log segments; empty disables the access log.
+  std::string access_log_dir;
+
+  // Size of each access log segment file before the next one is started.
+  std::size_t access_log_segment_size = 64 * 1024 * 1024;
+};
+
+#endif
@@ -1,10 +1,16 @@
 #ifndef SESSION_H
 #define SESSION_H
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/http.hpp>
 
 using boost::asio::ip::tcp;
@@ -13,27 +19,86 @@ namespace http = boost::beast::http;
 
 #include "echo_handler.h"
 #include "static_handler.h"
-#include "request_parser.h" 
+#include "request_parser.h"
 #include "request_handler.h"
+#include "request_timing.h"
+#include "server_config.h"
 
-class session
+// One client connection. Sessions are owned through shared_ptr so that the
+// pending read, write and idle-timer handlers keep the connection alive; the
+// socket and timer share a strand so those handlers never run concurrently.
+//
+// Requests may be pipelined: every complete request in the read buffer is
+// dispatched in one pass and its response is queued in `outbox_`, which is
+// written strictly in request order.
+class session : public std::enable_shared_from_this<session>
 {
 public:
-  session(boost::asio::io_service& io_service);
+  // `config` is shared by every session of a server rather than copied per
+  // connection; null means the defaults.
+  session(boost::asio::io_service& io_service,
+          std::shared_ptr<const ServerConfig> config = nullptr);
   tcp::socket& socket();
   virtual void start();
-  virtual ~session() = default;
-  //void start();
-  
+  virtual ~session();
+
 private:
+  // A serialized response waiting for its turn on the wire.
+  struct Outgoing {
+    std::string head;
+    std::string body;
+    SharedBytes shared_body;  // sent in place of `body`
+    std::shared_ptr<FileBody> file;  // sent with sendfile after `head`
+    std::uint64_t file_sent = 0;
+    bool ready = false;
+    bool close_after = false;
+    bool deferred = false;  // answered asynchronously, after the dispatch pass
+    bool log_sampled = false;  // this request's per-request info lines are logged
+    std::uint64_t bytes_in = 0;  // size of the request on the wire
+    RequestTiming timing;
+    std::string handler;  // name of the handler that answered, for metrics
+    std::string route = "None";  // location path it was routed by, for metrics
+  };
+
+  void do_read();
   void handle_read(const boost::system::error_code& error, size_t bytes_transferred);
-  void handle_write(const boost::system::error_code& error);
+  void process_buffer();
+  void stamp_arrival(RequestTiming& timing);
+  void handle_request(const char* data, std::size_t len, Outgoing& slot);
+  // Answer the unframeable request at `offset` in the buffer and close.
+  void reject(int status_code, const std::string& reason, std::size_t offset);
+  void finish_response(Outgoing& slot, std::unique_ptr<HttpResponse> app_res,
+                       const HttpRequest& req, const std::string& handler_name);
+  void flush();
+  void handle_write(const boost::system::error_code& error, std::size_t responses);
+  void send_file(std::size_t responses);
+  void handle_file_writable(const boost::system::error_code& error, std::size_t responses);
+  void complete_write(std::size_t responses);
+  void handle_idle_timeout(const boost::system::error_code& error);
+  void close();
+
+  // HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close; `Connection` overrides both.
+  static bool wants_keep_alive(const HttpRequest& req);
 
   tcp::socket socket_;
-  enum { max_length = 1024 };
-  char data_[max_length];
-  http::response<http::string_body> response;
+  tcp::endpoint remote_;  // the client, looked up with the first request
+  bool remote_known_ = false;
+  boost::asio::steady_timer idle_timer_;
+  std::shared_ptr<const ServerConfig> config_;
+  enum { read_chunk = 4096 };
+  std::vector<char> buffer_;  // pooled per thread; bytes [0, filled_) are unparsed input
+  std::size_t filled_ = 0;
+  std::deque<Outgoing> outbox_;
+  std::vector<boost::asio::const_buffer> write_buffers_;
   RequestParser parser_;
-  RequestHandler* handler_;
+  int requests_parsed_ = 0;
+  bool read_pending_ = false;
+  bool write_pending_ = false;
+  bool closing_ = false;           // a response that ends the connection is queued
+  bool awaiting_request_ = false;  // true while the idle timer guards a read
+  bool started_ = false;           // counted as an open connection in Metrics
+  RequestTiming::Clock::time_point accepted_;    // cleared once the first request takes it
+  RequestTiming::Clock::time_point first_byte_;  // first read of the next unframed request
+  RequestTiming::Clock::time_point last_read_;
 };
 #endif
@@ -12,6 +12,8 @@ public:
   explicit SessionMiddlewareHandler(std::unique_ptr<RequestHandler> next);
   std::unique_ptr<HttpResponse> handle_request(const HttpRequest& request) override;
   std::string get_kName() override { return "SessionMiddlewareHandler"; }
+  bool is_thread_safe() const override { return next_handler_->is_thread_safe(); }
+  bool needs_raw_request() const override { return next_handler_->needs_raw_request(); }
 
 private:
   std::unique_ptr<RequestHandler> next_handler_;
@@ -0,0 +1,50 @@
+#ifndef SHARED_BYTES_H
+#define SHARED_BYTES_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Immutable bytes shared by every response that sends them, such as a file
+// held in memory by the static file cache or a view into a file mapping.
+// Copies share ownership and slicing makes a narrower view, so neither
+// copies the bytes. An empty SharedBytes (no owner) is false.
+class SharedBytes {
+public:
+  SharedBytes() = default;
+
+  // Take ownership of `bytes`.
+  explicit SharedBytes(std::string bytes) {
+    auto owned = std::make_shared<const std::string>(std::move(bytes));
+    view_ = *owned;
+    owner_ = std::move(owned);
+  }
+
+  // `view` into memory kept alive by `owner`.
+  SharedBytes(std::shared_ptr<const void> owner, std::string_view view)
+    : owner_(std::move(owner)), view_(view) {}
+
+  const char* data() const { return view_.data(); }
+  std::size_t size() const { return view_.size(); }
+  std::string_view view() const { return view_; }
+  explicit operator bool() const { return owner_ != nullptr; }
+
+  // `length` bytes starting at `offset`, sharing this owner.
+  SharedBytes slice(std::size_t offset, std::size_t length) const {
+    return SharedBytes(owner_, view_.substr(offset, length));
+  }
+
+  // Same bytes at the same address: one is a copy of the other.
+  friend bool operator==(const SharedBytes& a, const SharedBytes& b) {
+    return a.owner_ == b.owner_ && a.view_.data() == b.view_.data() &&
+           a.view_.size() == b.view_.size();
+  }
+  friend bool operator!=(const SharedBytes& a, const SharedBytes& b) { return !(a == b); }
+
+private:
+  std::shared_ptr<const void> owner_;
+  std::string_view view_;
+};
+
+#endif
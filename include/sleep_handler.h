@@ -1,10 +1,27 @@
 #pragma once
+
 #include "request_handler.h"
+#include <chrono>
 #include <memory>
 
+// Responds after a fixed delay. The session uses the asynchronous path, which
+// waits on a steady_timer and so holds no thread while sleeping.
 class SleepHandler : public RequestHandler {
  public:
   static const std::string kName;
+
+  explicit SleepHandler(std::chrono::milliseconds delay = std::chrono::seconds(3));
+
+  // Blocks the calling thread for the delay; kept for synchronous callers.
   std::unique_ptr<HttpResponse> handle_request(const HttpRequest& req) override;
+  void handle_request_async(const HttpRequest& req,
+                            boost::asio::any_io_executor executor,
+                            ResponseCallback done) override;
   std::string get_kName() { return kName; };
-};
\ No newline at end of file
+  bool is_thread_safe() const override { return true; }
+
+ private:
+  static std::unique_ptr<HttpResponse> make_response();
+
+  std::chrono::milliseconds delay_;
+};
@@ -0,0 +1,166 @@
+#ifndef STATIC_FILE_CACHE_H
+#define STATIC_FILE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include "file_body.h"
+#include "http_headers.h"
+#include "mapped_file.h"
+#include "shared_bytes.h"
+
+// A static file held in memory or mapped, together with the response headers
+// that describe it, so a hit is served without opening the file.
+struct CachedFile {
+  SharedBytes body;
+  HttpHeaders headers;  // Content-Type, Accept-Ranges, ETag, Last-Modified, ...
+  struct stat stat;     // metadata of the file when it was read
+  std::shared_ptr<const MappedFile> mapping;  // set when `body` is a view of a mapping
+};
+
+// In-process cache of static file contents shared by every StaticHandler.
+//
+// Entries are keyed by the path a request resolved to. Files up to a
+// sixteenth of the byte budget are copied into memory, which the budget
+// bounds with least-recently-used eviction. Larger files up to the mmap
+// limit are mapped instead and shared by every response that sends them;
+// mappings get their own LRU list, bounded to sixteen times the limit in
+// address space. Anything larger is not cached and keeps being sent with
+// sendfile. Every directory holding a cached file is watched with inotify,
+// and a background thread drops entries as soon as their file is written,
+// replaced or removed.
+class StaticFileCache {
+public:
+  static StaticFileCache& instance();
+
+  // A cache with a byte budget of `capacity`; 0 disables caching.
+  explicit StaticFileCache(std::size_t capacity = 0);
+  ~StaticFileCache();
+
+  StaticFileCache(const StaticFileCache&) = delete;
+  StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+  // Change the byte budget, evicting as needed. 0 disables and empties the cache.
+  void set_capacity(std::size_t bytes);
+  std::size_t capacity() const;
+
+  // Largest file that will be copied into memory.
+  std::size_t max_entry_size() const;
+
+  // Largest file that will be mapped; 0 turns mapping off.
+  void set_mmap_limit(std::size_t bytes);
+  std::size_t mmap_limit() const;
+
+  // Bytes of file contents copied into memory, bytes mapped, and the number of entries.
+  std::size_t size() const;
+  std::size_t mapped_size() const;
+  std::size_t entries() const;
+
+  // The entry for `key`, marking it most recently used; nullptr on a miss.
+  std::shared_ptr<const CachedFile> find(const std::string& key);
+
+  // Read or map `file`, opened from `path`, and cache it under `key` with
+  // response `headers` (see file_headers). Returns the new entry, or nullptr
+  // when caching is off, the file is too large, or it changed while being
+  // read; the caller then serves `file` directly. A mapped entry keeps `file`
+  // open, so the caller must not modify it afterwards.
+  std::shared_ptr<const CachedFile> insert(const std::string& key, const std::string& path,
+                                           const std::shared_ptr<FileBody>& file,
+                                           HttpHeaders headers);
+
+  // Cache `variant`, derived from `identity` (e.g. by compressing it), under
+  // `key`. It is invalidated together with the file `identity` was read from.
+  // Returns nullptr if `identity` is no longer the entry at `identity_key` or
+  // the variant does not fit.
+  std::shared_ptr<const CachedFile> insert_variant(const std::string& key,
+                                                   const std::string& identity_key,
+                                                   const std::shared_ptr<const CachedFile>& identity,
+                                                   std::shared_ptr<const CachedFile> variant);
+
+  // Whether `key` was recorded by insert_missing and none of its paths has
+  // appeared since; such a key needs no open() calls to know it is absent.
+  bool missing(const std::string& key);
+
+  // Watch the directories of `paths` (or, for one that does not exist, its
+  // nearest existing ancestor) before probing them, and return in
+  // `generation` the value insert_missing needs. False when caching is off
+  // or a directory cannot be watched; the miss is then not recorded.
+  bool watch_paths(const std::vector<std::string>& paths, std::uint64_t& generation);
+
+  // Record that no file could be opened at any of `paths` for `key`. A file
+  // appearing at one of them later drops the record, along with any entry
+  // at `key`. Ignored if anything was invalidated since `generation`.
+  void insert_missing(const std::string& key, const std::vector<std::string>& paths,
+                      std::uint64_t generation);
+
+  // Drop every entry read from `path`.
+  void invalidate(const std::string& path);
+  void clear();
+
+  // Response headers describing a file with metadata `st`.
+  static HttpHeaders file_headers(const struct stat& st, const std::string& content_type);
+
+  // Strong validator derived from the file's inode, modification time and size.
+  static std::string make_etag(const struct stat& st);
+
+  // IMF-fixdate (RFC 9110 section 5.6.7), e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+  static std::string http_date(std::time_t t);
+
+  // Parse an HTTP date in any of the three formats RFC 9110 requires
+  // recipients to accept. Returns false if `value` is none of them.
+  static bool parse_http_date(const std::string& value, std::time_t& t);
+
+private:
+  struct Entry {
+    std::shared_ptr<const CachedFile> file;
+    std::string path;
+    std::list<std::string>::iterator lru_pos;  // in lru_ or, if mapped, mapped_lru_
+  };
+
+  bool start_watcher();
+  void stop_watcher();
+  void watch_loop();
+  bool watch_directory(const std::string& dir);
+  void invalidate_locked(const std::string& path);
+  void invalidate_prefix_locked(const std::string& prefix);
+  void evict_locked(std::size_t incoming, bool mapped);
+  void clear_locked();
+  void erase_locked(std::unordered_map<std::string, Entry>::iterator it);
+  void drop_missing_locked(const std::string& key);
+  void store_locked(const std::string& key, const std::string& path,
+                    std::shared_ptr<const CachedFile> file);
+
+  mutable std::mutex mutex_;
+  std::size_t capacity_ = 0;
+  std::size_t bytes_ = 0;
+  std::size_t mmap_limit_ = 0;
+  std::size_t mapped_bytes_ = 0;
+  std::uint64_t generation_ = 0;  // bumped by every invalidation
+  std::unordered_map<std::string, Entry> entries_;
+  std::list<std::string> lru_;         // in-memory entries, most recently used first
+  std::list<std::string> mapped_lru_;  // mapped entries, most recently used first
+  // File path -> keys of the entries read from it, so an inotify event only
+  // touches those entries. Ordered, so a directory's files form one range.
+  std::map<std::string, std::vector<std::string>> keys_by_path_;
+  // Keys known to have no file, with the paths probed for them, and the
+  // reverse index the watcher uses when a file is created.
+  std::unordered_map<std::string, std::vector<std::string>> missing_;
+  std::map<std::string, std::string> missing_by_path_;
+
+  int inotify_fd_ = -1;
+  int stop_fd_ = -1;
+  std::unordered_map<int, std::vector<std::string>> watched_dirs_;  // watch descriptor -> directory
+  std::unordered_map<std::string, int> dir_watches_;
+  std::thread watcher_;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include <boost/beast/http.hpp>
 #include <string>
 #include <map>
+#include <vector>
 #include "http_types.h"
 #include "request_handler.h"
 
@@ -18,8 +19,16 @@ public:
 
   static const std::string kName;
   std::string get_kName() { return kName; };
+  bool is_thread_safe() const override { return true; }
 
 protected:
+  // Open the file for `path`, trying the build-directory fallback; sets
+  // `file_path` to the path that was opened.
+  std::shared_ptr<FileBody> open_file(const std::string& path, std::string& file_path) const;
+
+  // The paths open_file tries for `path`, in order.
+  std::vector<std::string> candidate_paths(const std::string& path) const;
+
   std::string path_;
   std::string root_dir_;
 };
@@ -0,0 +1,296 @@
+#include "access_log.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <boost/asio/ip/address_v6.hpp>
+#include <boost/log/trivial.hpp>
+#include <nlohmann/json.hpp>
+
+using namespace access_log;
+
+namespace {
+  // Smallest segment, so that a record with three maximum-length new strings fits
+  constexpr std::size_t kMinSegmentSize = 256 * 1024;
+  constexpr std::size_t kMaxString = 0xffff;
+
+  std::size_t Pad8(std::size_t n) { return (n + 7) & ~std::size_t(7); }
+
+  std::string_view Clip(std::string_view value) {
+    return value.substr(0, kMaxString);
+  }
+
+  std::uint64_t Micros(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+  }
+}
+
+// LCOV_EXCL_START
+AccessLog& AccessLog::instance() {
+  static AccessLog log;
+  return log;
+}
+// LCOV_EXCL_STOP
+
+AccessLog::~AccessLog() {
+  close();
+}
+
+bool AccessLog::open(const std::string& dir, std::size_t segment_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  finish_segment_locked();
+  dir_ = dir;
+  segment_size_ = std::max(segment_size, kMinSegmentSize);
+  segments_ = 0;
+  bool started = start_segment_locked();
+  enabled_.store(started, std::memory_order_relaxed);
+  return started;
+}
+
+void AccessLog::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_.store(false, std::memory_order_relaxed);
+  finish_segment_locked();
+}
+
+std::size_t AccessLog::segments() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return segments_;
+}
+
+bool AccessLog::start_segment_locked() {
+  auto now = std::chrono::system_clock::now();
+  std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+  std::tm utc;
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", gmtime_r(&seconds, &utc));
+  std::string path = dir_ + "/access-" + stamp + "-" + std::to_string(::getpid()) + "-" +
+                     std::to_string(segments_) + ".bin";
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    BOOST_LOG_TRIVIAL(error) << "Cannot create access log " << path << ": " << std::strerror(errno);
+    return false;
+  }
+  void* base = MAP_FAILED;
+  if (::ftruncate(fd_, static_cast<off_t>(segment_size_)) == 0) {
+    base = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (base == MAP_FAILED) {
+    BOOST_LOG_TRIVIAL(error) << "Cannot map access log " << path << ": " << std::strerror(errno);
+    ::close(fd_);
+    ::unlink(path.c_str());
+    fd_ = -1;
+    return false;
+  }
+  base_ = static_cast<char*>(base);
+
+  SegmentHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(SegmentHeader);
+  header.created_us = Micros(now);
+  std::memcpy(base_, &header, sizeof(header));
+  used_ = sizeof(header);
+  ++segments_;
+  return true;
+}
+
+// Unmap the segment and cut the file at the data written, so readers see no
+// trailing zeros
+void AccessLog::finish_segment_locked() {
+  strings_.clear();  // the keys point into the mapping
+  if (!base_) {
+    return;
+  }
+  ::munmap(base_, segment_size_);
+  base_ = nullptr;
+  if (::ftruncate(fd_, static_cast<off_t>(used_)) != 0) {
+    BOOST_LOG_TRIVIAL(warning) << "Cannot truncate access log segment: " << std::strerror(errno);
+  }
+  ::close(fd_);
+  fd_ = -1;
+}
+
+// Bytes `value` adds to the segment: nothing once interned
+std::size_t AccessLog::space_locked(std::string_view value) const {
+  return strings_.count(value) ? 0 : sizeof(StringEntry) + Pad8(value.size());
+}
+
+std::uint32_t AccessLog::intern_locked(std::string_view value) {
+  auto it = strings_.find(value);
+  if (it != strings_.end()) {
+    return it->second;
+  }
+  StringEntry entry = {kString, static_cast<std::uint16_t>(value.size()),
+                       static_cast<std::uint32_t>(strings_.size() + 1)};
+  char* out = base_ + used_;
+  std::memcpy(out, &entry, sizeof(entry));
+  std::memcpy(out + sizeof(entry), value.data(), value.size());
+  used_ += sizeof(entry) + Pad8(value.size());
+  strings_.emplace(std::string_view(out + sizeof(entry), value.size()), entry.id);
+  return entry.id;
+}
+
+void AccessLog::record(const Request& request) {
+  if (!enabled()) {
+    return;
+  }
+  std::string_view method = Clip(request.method);
+  std::string_view path = Clip(request.path);
+  std::string_view handler = Clip(request.handler);
+
+  RequestRecord rec = {};
+  rec.kind = kRequest;
+  rec.status = static_cast<std::uint16_t>(request.status);
+  rec.latency_us = static_cast<std::uint32_t>(
+      std::min<std::int64_t>(request.latency.count(), UINT32_MAX));
+  rec.timestamp_us = Micros(request.time);
+  rec.bytes_in = request.bytes_in;
+  rec.bytes_out = request.bytes_out;
+  auto v6 = request.client.is_v4()
+                ? boost::asio::ip::make_address_v6(boost::asio::ip::v4_mapped, request.client.to_v4())
+                : request.client.to_v6();
+  auto addr = v6.to_bytes();
+  std::memcpy(rec.client_addr, addr.data(), sizeof(rec.client_addr));
+  rec.client_port = request.client_port;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!base_) {
+    return;
+  }
+  auto needed = [&] {
+    return space_locked(method) + space_locked(path) + space_locked(handler) + sizeof(rec);
+  };
+  if (used_ + needed() > segment_size_) {
+    finish_segment_locked();
+    if (!start_segment_locked()) {
+      enabled_.store(false, std::memory_order_relaxed);
+      return;
+    }
+  }
+  rec.method_id = intern_locked(method);
+  rec.path_id = intern_locked(path);
+  rec.handler_id = intern_locked(handler);
+  std::memcpy(base_ + used_, &rec, sizeof(rec));
+  used_ += sizeof(rec);
+}
+
+bool AccessLogReader::read(const std::string& file,
+                           const std::function<void(const AccessLogEntry&)>& visit,
+                           std::string& error) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    error = "cannot open " + file;
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  SegmentHeader header;
+  if (data.size() < sizeof(header)) {
+    error = "too short for a segment header";
+    return false;
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+      header.header_size < sizeof(header) || header.header_size > data.size()) {
+    error = "not an access log segment";
+    return false;
+  }
+
+  std::unordered_map<std::uint32_t, std::string> strings;
+  auto lookup = [&](std::uint32_t id, std::string& out) {
+    auto it = strings.find(id);
+    if (it == strings.end()) return false;
+    out = it->second;
+    return true;
+  };
+
+  std::size_t offset = header.header_size;
+  while (offset + sizeof(std::uint16_t) <= data.size()) {
+    std::uint16_t kind;
+    std::memcpy(&kind, data.data() + offset, sizeof(kind));
+    if (kind == kEnd) {
+      return true;
+    }
+    if (kind == kString && offset + sizeof(StringEntry) <= data.size()) {
+      StringEntry entry;
+      std::memcpy(&entry, data.data() + offset, sizeof(entry));
+      if (offset + sizeof(entry) + entry.length > data.size()) {
+        break;
+      }
+      strings[entry.id] = data.substr(offset + sizeof(entry), entry.length);
+      offset += sizeof(entry) + Pad8(entry.length);
+    } else if (kind == kRequest && offset + sizeof(RequestRecord) <= data.size()) {
+      RequestRecord rec;
+      std::memcpy(&rec, data.data() + offset, sizeof(rec));
+      AccessLogEntry entry;
+      entry.timestamp_us = rec.timestamp_us;
+      entry.latency_us = rec.latency_us;
+      entry.status = rec.status;
+      entry.bytes_in = rec.bytes_in;
+      entry.bytes_out = rec.bytes_out;
+      boost::asio::ip::address_v6::bytes_type addr;
+      std::memcpy(addr.data(), rec.client_addr, addr.size());
+      boost::asio::ip::address_v6 v6(addr);
+      entry.client = v6.is_v4_mapped()
+                         ? boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, v6).to_string()
+                         : v6.to_string();
+      entry.client_port = rec.client_port;
+      if (!lookup(rec.method_id, entry.method) || !lookup(rec.path_id, entry.path) ||
+          !lookup(rec.handler_id, entry.handler)) {
+        error = "undefined string at offset " + std::to_string(offset);
+        return false;
+      }
+      visit(entry);
+      offset += sizeof(rec);
+    } else {
+      break;
+    }
+  }
+  if (offset == data.size()) {
+    return true;
+  }
+  error = "corrupt entry at offset " + std::to_string(offset);
+  return false;
+}
+
+namespace {
+  std::string IsoTime(std::uint64_t micros) {
+    std::time_t seconds = static_cast<std::time_t>(micros / 1000000);
+    std::tm utc;
+    char buf[48];
+    std::size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", gmtime_r(&seconds, &utc));
+    std::snprintf(buf + n, sizeof(buf) - n, ".%06uZ", static_cast<unsigned>(micros % 1000000));
+    return buf;
+  }
+}
+
+std::string AccessLogReader::to_text(const AccessLogEntry& entry) {
+  return IsoTime(entry.timestamp_us) + " " + entry.client + ":" + std::to_string(entry.client_port) +
+         " \"" + entry.method + " " + entry.path + "\" " + std::to_string(entry.status) + " " +
+         std::to_string(entry.latency_us) + "us in=" + std::to_string(entry.bytes_in) +
+         " out=" + std::to_string(entry.bytes_out) + " handler=" + entry.handler;
+}
+
+std::string AccessLogReader::to_json(const AccessLogEntry& entry) {
+  nlohmann::json j = {
+    {"time", IsoTime(entry.timestamp_us)},
+    {"client", entry.client},
+    {"port", entry.client_port},
+    {"method", entry.method},
+    {"path", entry.path},
+    {"status", entry.status},
+    {"latency_us", entry.latency_us},
+    {"bytes_in", entry.bytes_in},
+    {"bytes_out", entry.bytes_out},
+    {"handler", entry.handler},
+  };
+  // Paths are client input; replace invalid UTF-8 rather than throw
+  return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
@@ -0,0 +1,34 @@
+// Prints the requests in binary access log segments, one line per request.
+//
+//   access_log_decode [--json] segment...
+
+#include <cstring>
+#include <iostream>
+#include "access_log.h"
+
+int main(int argc, char* argv[])
+{
+  bool json = false;
+  int first = 1;
+  if (argc > 1 && std::strcmp(argv[1], "--json") == 0) {
+    json = true;
+    first = 2;
+  }
+  if (first >= argc) {
+    std::cerr << "Usage: access_log_decode [--json] segment..." << std::endl;
+    return 1;
+  }
+
+  int status = 0;
+  for (int i = first; i < argc; ++i) {
+    std::string error;
+    bool ok = AccessLogReader::read(argv[i], [json](const AccessLogEntry& entry) {
+      std::cout << (json ? AccessLogReader::to_json(entry) : AccessLogReader::to_text(entry)) << '\n';
+    }, error);
+    if (!ok) {
+      std::cerr << argv[i] << ": " << error << std::endl;
+      status = 1;
+    }
+  }
+  return status;
+}
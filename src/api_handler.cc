@@ -1,6 +1,7 @@
 #include "handler_registry.h"
 #include "disk_file_store.h"
 #include "api_handler.h"
+#include "compression_middleware_handler.h"
 #include <nlohmann/json.hpp>
 #include <regex>
 #include <vector>
@@ -168,6 +169,8 @@ static bool apiRegistered = HandlerRegistry::instance()
     [](const std::vector<std::string>& args) {
       // args[0] = mount, args[1] = data_path
       auto store = std::make_shared<DiskFileStore>(args.at(1));
-      return std::make_unique<ApiHandler>(args.at(0), store);
+      // JSON bodies are compressed for clients that accept it
+      return std::make_unique<CompressionMiddlewareHandler>(
+          std::make_unique<ApiHandler>(args.at(0), store));
     });
 // LCOV_EXCL_STOP
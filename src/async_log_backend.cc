@@ -0,0 +1,160 @@
+#include "async_log_backend.h"
+#include <chrono>
+
+// Single-producer, single-consumer ring of records. The owning thread
+// pushes; the writer thread drains.
+class AsyncLogBackend::Ring {
+public:
+  explicit Ring(std::size_t size) {
+    std::size_t capacity = 2;
+    while (capacity < size) capacity *= 2;
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+  }
+
+  bool push(const boost::log::record_view& rec) {
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & mask_] = rec;
+    // seq_cst so the writer either sees this record or the producer sees it asleep
+    tail_.store(tail + 1, std::memory_order_seq_cst);
+    return true;
+  }
+
+  bool pending() const {
+    return head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_seq_cst);
+  }
+
+  void drain(Batch& batch) {
+    std::uint64_t head = head_.load(std::memory_order_relaxed);
+    std::uint64_t tail = tail_.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+      batch.push_back(std::move(slots_[head & mask_]));
+    }
+    head_.store(head, std::memory_order_release);
+  }
+
+  std::atomic<bool> closed{false};  // set when the owning thread exits
+
+private:
+  std::vector<boost::log::record_view> slots_;
+  std::size_t mask_ = 0;
+  alignas(64) std::atomic<std::uint64_t> head_{0};
+  alignas(64) std::atomic<std::uint64_t> tail_{0};
+};
+
+namespace {
+  std::atomic<std::uint64_t> next_backend_id{1};
+}
+
+AsyncLogBackend::AsyncLogBackend(Writer writer, std::size_t ring_size, Overflow overflow)
+  : writer_(std::move(writer)), ring_size_(ring_size), overflow_(overflow),
+    id_(next_backend_id.fetch_add(1)) {
+  thread_ = std::thread([this] { run(); });
+}
+
+AsyncLogBackend::~AsyncLogBackend() {
+  stop_.store(true, std::memory_order_release);
+  wake();
+  thread_.join();
+}
+
+AsyncLogBackend::Ring& AsyncLogBackend::local_ring() {
+  struct Local {
+    std::uint64_t owner = 0;
+    std::shared_ptr<Ring> ring;
+    ~Local() {
+      if (ring) ring->closed.store(true, std::memory_order_release);
+    }
+  };
+  thread_local Local local;
+  if (local.owner != id_) {
+    if (local.ring) local.ring->closed.store(true, std::memory_order_release);
+    local.ring.reset(new Ring(ring_size_));
+    local.owner = id_;
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.push_back(local.ring);
+  }
+  return *local.ring;
+}
+
+void AsyncLogBackend::consume(const boost::log::record_view& rec) {
+  Ring& ring = local_ring();
+  while (!ring.push(rec)) {
+    if (overflow_ == Overflow::drop || stop_.load(std::memory_order_acquire)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    wake();
+    std::this_thread::yield();
+  }
+  if (sleeping_.load(std::memory_order_seq_cst)) {
+    wake();
+  }
+}
+
+void AsyncLogBackend::flush() {
+  if (std::this_thread::get_id() == thread_.get_id()) {
+    return;  // the writer cannot wait for itself
+  }
+  std::uint64_t generation = flush_requested_.fetch_add(1) + 1;
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  wake_cv_.notify_one();
+  flushed_cv_.wait(lock, [&] { return flush_done_ >= generation; });
+}
+
+void AsyncLogBackend::wake() {
+  std::lock_guard<std::mutex> lock(wake_mutex_);
+  wake_cv_.notify_one();
+}
+
+// Move every ring's records into `batch`, forgetting rings whose thread has
+// exited once they are empty. Returns whether anything was added.
+bool AsyncLogBackend::collect(Batch& batch) {
+  std::size_t before = batch.size();
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (auto it = rings_.begin(); it != rings_.end();) {
+    bool closed = (*it)->closed.load(std::memory_order_acquire);
+    (*it)->drain(batch);
+    it = closed ? rings_.erase(it) : it + 1;
+  }
+  return batch.size() > before;
+}
+
+void AsyncLogBackend::run() {
+  Batch batch;
+  std::uint64_t reported = 0;
+  for (;;) {
+    std::uint64_t flush_generation = flush_requested_.load(std::memory_order_acquire);
+    bool stopping = stop_.load(std::memory_order_acquire);
+    if (collect(batch)) {
+      std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+      writer_(batch, dropped - reported);
+      reported = dropped;
+      batch.clear();
+      continue;  // keep draining until every ring is empty
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    flush_done_ = flush_generation;
+    flushed_cv_.notify_all();
+    if (stopping) {
+      break;
+    }
+    sleeping_.store(true, std::memory_order_seq_cst);
+    bool pending = false;
+    {
+      std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+      for (const auto& ring : rings_) {
+        pending = pending || ring->pending();
+      }
+    }
+    if (!pending && !stop_.load(std::memory_order_acquire) &&
+        flush_requested_.load(std::memory_order_acquire) == flush_generation) {
+      wake_cv_.wait_for(lock, std::chrono::milliseconds(100));
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,116 @@
+#include "byte_range.h"
+#include <limits>
+
+namespace {
+  constexpr std::uint64_t kMax = std::numeric_limits<std::uint64_t>::max();
+
+  std::string_view Trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+  }
+
+  // Parse a run of digits; values past 2^64 saturate, which still compares correctly
+  bool ParseNumber(std::string_view s, std::uint64_t& value) {
+    if (s.empty()) return false;
+    value = 0;
+    for (char c : s) {
+      if (c < '0' || c > '9') return false;
+      std::uint64_t digit = static_cast<std::uint64_t>(c - '0');
+      value = value > (kMax - digit) / 10 ? kMax : value * 10 + digit;
+    }
+    return true;
+  }
+
+  bool IEqualsBytes(std::string_view unit) {
+    static const char kBytes[] = "bytes";
+    if (unit.size() != 5) return false;
+    for (std::size_t i = 0; i < 5; ++i) {
+      char c = unit[i];
+      if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+      if (c != kBytes[i]) return false;
+    }
+    return true;
+  }
+} // end of namespace
+
+ByteRangeParser::Result ByteRangeParser::parse(std::string_view header, std::uint64_t size,
+                                               std::vector<ByteRange>& ranges) {
+  ranges.clear();
+  auto eq = header.find('=');
+  if (eq == std::string_view::npos || !IEqualsBytes(Trim(header.substr(0, eq)))) {
+    return Result::ignored;
+  }
+
+  std::string_view list = header.substr(eq + 1);
+  std::size_t specs = 0;
+  while (true) {
+    auto comma = list.find(',');
+    std::string_view spec = Trim(list.substr(0, comma));
+    if (!spec.empty()) {
+      if (++specs > kMaxRanges) {
+        ranges.clear();
+        return Result::ignored;
+      }
+      auto dash = spec.find('-');
+      if (dash == std::string_view::npos) {
+        ranges.clear();
+        return Result::ignored;
+      }
+      std::uint64_t first = 0;
+      std::uint64_t last = 0;
+      if (dash == 0) {
+        // Suffix range: the final `last` bytes
+        if (!ParseNumber(spec.substr(1), last)) {
+          ranges.clear();
+          return Result::ignored;
+        }
+        if (last > 0 && size > 0) {
+          ranges.push_back({last >= size ? 0 : size - last, size - 1});
+        }
+      } else {
+        if (!ParseNumber(spec.substr(0, dash), first)) {
+          ranges.clear();
+          return Result::ignored;
+        }
+        std::string_view rest = spec.substr(dash + 1);
+        if (rest.empty()) {
+          last = kMax;
+        } else if (!ParseNumber(rest, last) || last < first) {
+          ranges.clear();
+          return Result::ignored;
+        }
+        if (first < size) {
+          ranges.push_back({first, last < size ? last : size - 1});
+        }
+      }
+    }
+    if (comma == std::string_view::npos) break;
+    list.remove_prefix(comma + 1);
+  }
+
+  if (specs == 0) {
+    return Result::ignored;
+  }
+  if (ranges.empty()) {
+    return Result::unsatisfiable;
+  }
+  for (std::size_t i = 0; i < ranges.size(); ++i) {
+    for (std::size_t j = i + 1; j < ranges.size(); ++j) {
+      if (ranges[i].first <= ranges[j].last && ranges[j].first <= ranges[i].last) {
+        ranges.clear();
+        return Result::ignored;
+      }
+    }
+  }
+  return Result::satisfiable;
+}
+
+std::string ByteRangeParser::content_range(const ByteRange& range, std::uint64_t size) {
+  return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" +
+         std::to_string(size);
+}
+
+std::string ByteRangeParser::unsatisfied_range(std::uint64_t size) {
+  return "bytes */" + std::to_string(size);
+}
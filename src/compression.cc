@@ -0,0 +1,149 @@
+#include "compression.h"
+#include <algorithm>
+#include <cstdlib>
+#include <brotli/encode.h>
+#include <zlib.h>
+
+namespace {
+  constexpr ContentCoding kCodings[] = {ContentCoding::br, ContentCoding::gzip};
+
+  std::string_view Trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+  }
+
+  bool IEquals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      char x = a[i], y = b[i];
+      if (x >= 'A' && x <= 'Z') x = static_cast<char>(x - 'A' + 'a');
+      if (y >= 'A' && y <= 'Z') y = static_cast<char>(y - 'A' + 'a');
+      if (x != y) return false;
+    }
+    return true;
+  }
+
+  bool StartsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && IEquals(s.substr(0, prefix.size()), prefix);
+  }
+
+  // q-value of a list element's parameters; 1 when absent, 0 when malformed
+  double QValue(std::string_view params) {
+    while (!params.empty()) {
+      auto semi = params.find(';');
+      std::string_view param = Trim(params.substr(0, semi));
+      params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+      if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+        std::string value(Trim(param.substr(2)));
+        char* end = nullptr;
+        double q = std::strtod(value.c_str(), &end);
+        return end && *end == '\0' && q >= 0 && q <= 1 ? q : 0;
+      }
+    }
+    return 1;
+  }
+
+  bool Gzip(std::string_view input, std::string& out, int level) {
+    z_stream zs = {};
+    // windowBits 15 + 16 selects the gzip wrapper
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      return false;
+    }
+    out.resize(deflateBound(&zs, static_cast<uLong>(input.size())));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    zs.avail_in = static_cast<uInt>(input.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+  }
+
+  bool Brotli(std::string_view input, std::string& out, int quality) {
+    std::size_t size = BrotliEncoderMaxCompressedSize(input.size());
+    out.resize(size ? size : input.size() + 1024);
+    size = out.size();
+    if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC,
+                               input.size(), reinterpret_cast<const uint8_t*>(input.data()),
+                               &size, reinterpret_cast<uint8_t*>(&out[0]))) {
+      return false;
+    }
+    out.resize(size);
+    return true;
+  }
+} // end of namespace
+
+std::vector<ContentCoding> Compression::accepted(std::string_view accept_encoding) {
+  double q[2] = {-1, -1};  // per kCodings entry; -1 = not mentioned
+  double any = -1;
+  while (!accept_encoding.empty()) {
+    auto comma = accept_encoding.find(',');
+    std::string_view element = accept_encoding.substr(0, comma);
+    accept_encoding = comma == std::string_view::npos ? std::string_view()
+                                                      : accept_encoding.substr(comma + 1);
+    auto semi = element.find(';');
+    std::string_view name = Trim(element.substr(0, semi));
+    double value = semi == std::string_view::npos ? 1 : QValue(element.substr(semi + 1));
+    if (IEquals(name, "br")) {
+      q[0] = value;
+    } else if (IEquals(name, "gzip") || IEquals(name, "x-gzip")) {
+      q[1] = value;
+    } else if (name == "*") {
+      any = value;
+    }
+  }
+
+  std::vector<ContentCoding> codings;
+  double weight[2];
+  for (int i = 0; i < 2; ++i) {
+    weight[i] = q[i] >= 0 ? q[i] : any;
+    if (weight[i] > 0) codings.push_back(kCodings[i]);
+  }
+  std::stable_sort(codings.begin(), codings.end(), [&weight](ContentCoding a, ContentCoding b) {
+    return weight[static_cast<int>(a)] > weight[static_cast<int>(b)];
+  });
+  return codings;
+}
+
+bool Compression::compressible(std::string_view content_type) {
+  content_type = Trim(content_type.substr(0, content_type.find(';')));
+  if (StartsWith(content_type, "text/")) return true;
+  static const std::string_view kTypes[] = {
+    "application/json", "application/javascript", "application/xml",
+    "application/xhtml+xml", "image/svg+xml",
+  };
+  for (auto type : kTypes) {
+    if (IEquals(content_type, type)) return true;
+  }
+  // Structured syntax suffixes such as application/problem+json
+  auto plus = content_type.rfind('+');
+  return plus != std::string_view::npos &&
+         (IEquals(content_type.substr(plus), "+json") || IEquals(content_type.substr(plus), "+xml"));
+}
+
+bool Compression::compress(ContentCoding coding, std::string_view input, std::string& out,
+                           Level level) {
+  if (coding == ContentCoding::gzip) {
+    return Gzip(input, out, level == Level::best ? 9 : 6);
+  }
+  // Quality 11 is several times slower than 9 for a few percent, even for cached results
+  return Brotli(input, out, level == Level::best ? 9 : 5);
+}
+
+const char* Compression::token(ContentCoding coding) {
+  return coding == ContentCoding::gzip ? "gzip" : "br";
+}
+
+const char* Compression::extension(ContentCoding coding) {
+  return coding == ContentCoding::gzip ? ".gz" : ".br";
+}
+
+std::string Compression::variant_etag(const std::string& etag, ContentCoding coding) {
+  std::string suffix = std::string("-") + token(coding);
+  if (etag.size() >= 2 && etag.back() == '"') {
+    return etag.substr(0, etag.size() - 1) + suffix + "\"";
+  }
+  return etag + suffix;
+}
@@ -0,0 +1,71 @@
+#include "compression_middleware_handler.h"
+#include "compression.h"
+#include <boost/log/trivial.hpp>
+
+CompressionMiddlewareHandler::CompressionMiddlewareHandler(std::unique_ptr<RequestHandler> next_handler,
+                                                           std::size_t min_size)
+    : next_handler_(std::move(next_handler)), min_size_(min_size) {}
+
+std::unique_ptr<HttpResponse> CompressionMiddlewareHandler::handle_request(const HttpRequest& request) {
+    auto response = next_handler_->handle_request(request);
+    compress_response(request, *response, min_size_);
+    return response;
+}
+
+void CompressionMiddlewareHandler::handle_request_async(const HttpRequest& request,
+                                                        boost::asio::any_io_executor executor,
+                                                        ResponseCallback done) {
+    // `request` stays valid until `done` runs, so the callback may refer to it
+    std::size_t min_size = min_size_;
+    next_handler_->handle_request_async(request, executor,
+        [&request, min_size, done = std::move(done)](std::unique_ptr<HttpResponse> response) {
+            compress_response(request, *response, min_size);
+            done(std::move(response));
+        });
+}
+
+void CompressionMiddlewareHandler::compress_response(const HttpRequest& request,
+                                                     HttpResponse& res,
+                                                     std::size_t min_size) {
+    auto type = res.headers.find(HeaderId::content_type);
+    if (type == res.headers.end() || !Compression::compressible(type->second)) {
+        return;
+    }
+    // The body depends on Accept-Encoding from here on, whatever this request sent
+    auto vary = res.headers.find("Vary");
+    if (vary == res.headers.end()) {
+        res.headers.add("Vary", "Accept-Encoding");
+    } else if (vary->second.find("Accept-Encoding") == std::string::npos && vary->second != "*") {
+        vary->second += ", Accept-Encoding";
+    }
+
+    if (res.status_code < 200 || res.status_code >= 300 || res.status_code == 204 ||
+        res.status_code == 206 || res.file || res.shared_body || res.body.size() < min_size ||
+        res.headers.find("Content-Encoding") != res.headers.end()) {
+        return;
+    }
+    auto accept = request.headers.find("Accept-Encoding");
+    if (accept == request.headers.end()) {
+        return;
+    }
+    auto codings = Compression::accepted(accept->second);
+    if (codings.empty()) {
+        return;
+    }
+
+    std::string encoded;
+    if (!Compression::compress(codings.front(), res.body, encoded)) {
+        BOOST_LOG_TRIVIAL(warning) << "Compressing a " << res.body.size() << " byte response with "
+                                   << Compression::token(codings.front()) << " failed";
+        return;
+    }
+    if (encoded.size() >= res.body.size()) {
+        return;
+    }
+    res.body = std::move(encoded);
+    res.headers.add("Content-Encoding", Compression::token(codings.front()));
+    auto etag = res.headers.find("ETag");
+    if (etag != res.headers.end()) {
+        etag->second = Compression::variant_etag(etag->second, codings.front());
+    }
+}
@@ -7,13 +7,16 @@
 // How Nginx does it:
 //   http://lxr.nginx.org/source/src/core/ngx_conf_file.c
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stack>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <boost/log/trivial.hpp>
 #include <map>
@@ -72,7 +75,59 @@ namespace {
     }
     return NginxConfigParser::TOKEN_TYPE_ERROR;
   }
-  
+
+  // Parse the value of a numeric directive such as "max_body_size 1048576;"
+  // into `out`. Logs and returns false unless it is a plain decimal integer
+  // from `min` up to the largest T.
+  template <typename T>
+  bool ParseNumber(const std::vector<std::string>& tokens, T min, T& out) {
+    const std::string& text = tokens[1];
+    T value = 0;
+    bool valid = !text.empty();
+    for (char c : text) {
+      T digit = static_cast<T>(c - '0');
+      if (c < '0' || c > '9' || value > (std::numeric_limits<T>::max() - digit) / 10) {
+        valid = false;
+        break;
+      }
+      value = value * 10 + digit;
+    }
+    if (!valid || value < min) {
+      BOOST_LOG_TRIVIAL(error) << "Invalid " << tokens[0] << ": " << text
+                               << " (expected an integer of at least " << min << ")";
+      return false;
+    }
+    out = value;
+    return true;
+  }
+
+  // Parse the value of an on/off directive such as "reuse_port on;" into
+  // `out`. Logs and returns false for anything else.
+  bool ParseSwitch(const std::vector<std::string>& tokens, bool& out) {
+    if (tokens[1] != "on" && tokens[1] != "off") {
+      BOOST_LOG_TRIVIAL(error) << "Invalid " << tokens[0] << ": " << tokens[1]
+                               << " (expected on or off)";
+      return false;
+    }
+    out = tokens[1] == "on";
+    return true;
+  }
+
+  // The route a location path occupies in the RouteTree: repeated slashes
+  // collapse and every capture is the same ":" whatever its name, so
+  // "//a/:id" and "/a/:name" have the same key.
+  std::string RouteKey(const std::string& path) {
+    std::string key;
+    std::size_t start = path.find_first_not_of('/');
+    while (start != std::string::npos) {
+      std::size_t end = std::min(path.find('/', start), path.size());
+      key += '/';
+      key += path[start] == ':' ? std::string(":") : path.substr(start, end - start);
+      start = path.find_first_not_of('/', end);
+    }
+    return key.empty() ? "/" : key;
+  }
+
 } // end of namespace
 
 // ========================================
@@ -285,6 +340,11 @@ bool NginxConfigParser::Parse(const char* file_name, NginxConfig* config) {
 
 using HandlerPtr = std::shared_ptr<RequestHandler>;
 bool parseConfig(const char* config_file, int& port) {
+    ServerConfig server_config;
+    return parseConfig(config_file, port, server_config);
+}
+
+bool parseConfig(const char* config_file, int& port, ServerConfig& server_config) {
     NginxConfigParser parser;
     NginxConfig config;
 
@@ -293,12 +353,124 @@ bool parseConfig(const char* config_file, int& port) {
         return false;
     }
 
-    std::unordered_set<std::string> seen_paths; // Track to prevent duplicate paths
+    // Track methods seen per path ("*" = any) to prevent duplicate routes
+    std::unordered_map<std::string, std::unordered_set<std::string>> seen_paths;
 
     for (const auto& stmt : config.statements_) {
         if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "port") {
             port = std::stoi(stmt->tokens_[1]);
             BOOST_LOG_TRIVIAL(info) << "Parsed port: " << port;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "keepalive_timeout") {
+            if (!ParseNumber<int>(stmt->tokens_, 0, server_config.keepalive_timeout)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed keepalive_timeout: " << server_config.keepalive_timeout;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "keepalive_requests") {
+            if (!ParseNumber<int>(stmt->tokens_, 1, server_config.keepalive_requests)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed keepalive_requests: " << server_config.keepalive_requests;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "max_header_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 1, server_config.max_header_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed max_header_size: " << server_config.max_header_size;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "max_body_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 0, server_config.max_body_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed max_body_size: " << server_config.max_body_size;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "max_pipelined_requests") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 1, server_config.max_pipelined_requests)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed max_pipelined_requests: " << server_config.max_pipelined_requests;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "threads") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 0, server_config.threads)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed threads: " << server_config.threads;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "reuse_port") {
+            if (!ParseSwitch(stmt->tokens_, server_config.reuse_port)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed reuse_port: " << stmt->tokens_[1];
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "static_cache_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 0, server_config.static_cache_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed static_cache_size: " << server_config.static_cache_size;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "static_mmap_max_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 0, server_config.static_mmap_max_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed static_mmap_max_size: " << server_config.static_mmap_max_size;
+        } else if (stmt->tokens_.size() == 1 && stmt->tokens_[0] == "types" && stmt->child_block_) {
+            // nginx syntax: one "type ext1 ext2 ...;" statement per type
+            for (const auto& type_stmt : stmt->child_block_->statements_) {
+                if (type_stmt->tokens_.size() < 2) {
+                    BOOST_LOG_TRIVIAL(error) << "types entry needs a type and extensions";
+                    return false;
+                }
+                for (std::size_t i = 1; i < type_stmt->tokens_.size(); ++i) {
+                    server_config.mime_types.emplace_back(type_stmt->tokens_[i], type_stmt->tokens_[0]);
+                }
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed types: " << server_config.mime_types.size() << " extensions";
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "log_async") {
+            if (!ParseSwitch(stmt->tokens_, server_config.log.async)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed log_async: " << stmt->tokens_[1];
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "log_queue_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 1, server_config.log.queue_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed log_queue_size: " << server_config.log.queue_size;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "log_overflow") {
+            if (stmt->tokens_[1] == "drop") {
+                server_config.log.overflow = LogOptions::Overflow::drop;
+            } else if (stmt->tokens_[1] == "block") {
+                server_config.log.overflow = LogOptions::Overflow::block;
+            } else {
+                BOOST_LOG_TRIVIAL(error) << "Unknown log_overflow: " << stmt->tokens_[1];
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed log_overflow: " << stmt->tokens_[1];
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "log_level") {
+            if (!parse_log_level(stmt->tokens_[1], server_config.log.level)) {
+                BOOST_LOG_TRIVIAL(error) << "Unknown log_level: " << stmt->tokens_[1];
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed log_level: " << stmt->tokens_[1];
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "log_sample_every") {
+            if (!ParseNumber<unsigned>(stmt->tokens_, 1, server_config.log.sample_every)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed log_sample_every: " << server_config.log.sample_every;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "server_timing") {
+            if (!ParseSwitch(stmt->tokens_, server_config.server_timing)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed server_timing: " << stmt->tokens_[1];
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "access_log") {
+            server_config.access_log_dir = stmt->tokens_[1];
+            BOOST_LOG_TRIVIAL(info) << "Parsed access_log: " << server_config.access_log_dir;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "access_log_segment_size") {
+            if (!ParseNumber<std::size_t>(stmt->tokens_, 1, server_config.access_log_segment_size)) {
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed access_log_segment_size: " << server_config.access_log_segment_size;
+        } else if (stmt->tokens_.size() == 2 && stmt->tokens_[0] == "io_model") {
+            if (stmt->tokens_[1] == "shared") {
+                server_config.io_model = ServerConfig::IoModel::shared;
+            } else if (stmt->tokens_[1] == "per_core") {
+                server_config.io_model = ServerConfig::IoModel::per_core;
+            } else {
+                BOOST_LOG_TRIVIAL(error) << "Unknown io_model: " << stmt->tokens_[1];
+                return false;
+            }
+            BOOST_LOG_TRIVIAL(info) << "Parsed io_model: " << stmt->tokens_[1];
         } else if (stmt->tokens_.size() >= 3 && stmt->tokens_[0] == "location") {
             std::string path = stmt->tokens_[1];
             std::string handler_type = stmt->tokens_[2];
@@ -309,27 +481,44 @@ bool parseConfig(const char* config_file, int& port) {
                 return false;
             }
 
-            // Check for duplicates
-            if (!seen_paths.insert(path).second) {
-                BOOST_LOG_TRIVIAL(fatal) << "Duplicate location: " << path; // Server shutdown on duplicate
-                return false;
-            }
-
-            // build args = { path, val1, val2, … } in declaration order
+            // build args = { path, val1, val2, … } in declaration order;
+            // "methods GET POST;" limits the route and is not passed on
             std::vector<std::string> args;
+            std::vector<std::string> methods;
             args.push_back(path);
             if (stmt->child_block_) {
                 for (auto const& arg_stmt : stmt->child_block_->statements_) {
-                    if (arg_stmt->tokens_.size() >= 2) {
+                    if (arg_stmt->tokens_.size() >= 2 && arg_stmt->tokens_[0] == "methods") {
+                        methods.assign(arg_stmt->tokens_.begin() + 1, arg_stmt->tokens_.end());
+                    } else if (arg_stmt->tokens_.size() >= 2) {
                         args.push_back(arg_stmt->tokens_[1]);
                     }
                 }
             }
 
+            // Check for duplicates; a path may repeat only with disjoint methods
+            auto& path_methods = seen_paths[RouteKey(path)];
+            bool duplicate = path_methods.count("*") > 0 ||
+                             (methods.empty() && !path_methods.empty());
+            for (const auto& method : methods) {
+                duplicate = !path_methods.insert(method).second || duplicate;
+            }
+            if (methods.empty()) {
+                path_methods.insert("*");
+            }
+            if (duplicate) {
+                BOOST_LOG_TRIVIAL(fatal) << "Duplicate location: " << path; // Server shutdown on duplicate
+                return false;
+            }
+
             //Add new route to dispatcher
-            Dispatcher::registerRoute(path, [=]() {
+            bool built = Dispatcher::registerRoute(path, [=]() {
               return HandlerRegistry::instance().createHandler(handler_type, args);
-            });
+            }, methods);
+            if (!built) {
+                BOOST_LOG_TRIVIAL(error) << "Could not create " << handler_type << " for " << path;
+                return false;
+            }
         }
     }
     
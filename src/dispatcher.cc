@@ -1,22 +1,73 @@
 #include "dispatcher.h"
+#include <unordered_map>
 
-std::unordered_map<std::string, Dispatcher::HandlerFactory> Dispatcher::routes;
+std::vector<Dispatcher::Route> Dispatcher::routes;
+RouteTree Dispatcher::tree;
 
-void Dispatcher::registerRoute(std::string path, HandlerFactory factory) {
-    routes[path] = std::move(factory);
+namespace {
+  std::uint64_t next_route_id = 0;
+
+  // Instances of non-thread-safe handlers owned by the current worker thread,
+  // keyed by route id. Ids are never reused, so a re-registered route simply
+  // gets a fresh instance.
+  thread_local std::unordered_map<std::uint64_t, std::unique_ptr<RequestHandler>> thread_handlers;
+} // end of namespace
+
+bool Dispatcher::registerRoute(std::string path, HandlerFactory factory,
+                               const std::vector<std::string>& methods) {
+    Route route;
+    route.id = next_route_id++;
+    route.path = path;
+    route.shared = factory();
+    bool built = route.shared != nullptr;
+    if (route.shared && !route.shared->is_thread_safe()) {
+        route.per_thread = true;
+        route.shared.reset();
+    }
+    route.factory = std::move(factory);
+
+    std::size_t index = routes.size();
+    routes.push_back(std::move(route));
+    if (methods.empty()) {
+        tree.insert(path, "", index);
+    }
+    for (const auto& method : methods) {
+        tree.insert(path, method, index);
+    }
+    return built;
+}
+
+RequestHandler* Dispatcher::instance(std::size_t index) {
+    Route& route = routes[index];
+    if (!route.per_thread) {
+        return route.shared.get();
+    }
+    auto& handler = thread_handlers[route.id];
+    if (!handler) {
+        handler = route.factory();
+    }
+    return handler.get();
 }
 
-std::unique_ptr<RequestHandler> Dispatcher::match(std::string path) {
-    std::string longestMatch = "";
-    int matchLength = 0;
-    
-    for (const auto& [key, value] : routes) {
-        if (path.rfind(key, 0) == std::string::npos) { continue; }
-        if (key.length() > matchLength) {
-            longestMatch = key;
-            matchLength = key.length();
-        }
+RequestHandler* Dispatcher::match(std::string_view path, std::string_view method,
+                                  RouteTree::Params* params, std::vector<std::string>* allowed,
+                                  std::string* route) {
+    std::size_t index = tree.match(path, method, params, allowed);
+    if (index == RouteTree::npos) {
+        return nullptr;
+    }
+    if (route) {
+        *route = routes[index].path;
     }
+    return instance(index);
+}
 
-    return routes[longestMatch]();
-}
\ No newline at end of file
+RequestHandler* Dispatcher::match(HttpRequest& req) {
+    RouteTree::Params params;
+    std::size_t index = tree.match(req.path, req.method, &params);
+    req.path_params.clear();
+    for (const auto& param : params) {
+        req.path_params.emplace(std::string(param.first), std::string(param.second));
+    }
+    return index == RouteTree::npos ? nullptr : instance(index);
+}
@@ -1,5 +1,6 @@
 #include "get_messages_handler.h"
 #include "session_middleware_handler.h"
+#include "compression_middleware_handler.h"
 #include "disk_file_store.h"
 #include "handler_registry.h"
 #include <nlohmann/json.hpp>
@@ -126,6 +127,8 @@ static const bool getMessagesRegistered =
       // build a FileStore rooted at <data_path>/messages
       FileStore* store = new DiskFileStore(args.at(1) + "/messages");
       auto realHandler = std::make_unique<GetMessagesHandler>(args.at(0), store);
-      return std::make_unique<SessionMiddlewareHandler>(std::move(realHandler));
+      // The message list grows without bound and is polled, so compress it
+      return std::make_unique<CompressionMiddlewareHandler>(
+          std::make_unique<SessionMiddlewareHandler>(std::move(realHandler)));
     });
 // LCOV_EXCL_STOP
@@ -0,0 +1,220 @@
+#include "header_scanner.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEADER_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+  using FindHeaderEndFn = std::size_t (*)(const char*, std::size_t);
+  using FindCharFn = std::size_t (*)(const char*, std::size_t, char);
+
+  bool IsTerminator(const char* p) {
+    return p[0] == '\r' && p[1] == '\n' && p[2] == '\r' && p[3] == '\n';
+  }
+
+  // ========================================
+  // Scalar kernels
+  // ========================================
+  std::size_t FindCharScalar(const char* data, std::size_t len, char c) {
+    const void* hit = std::memchr(data, c, len);
+    return hit ? static_cast<const char*>(hit) - data : len;
+  }
+
+  // Check every '\r' candidate from `pos` onwards for a full terminator
+  std::size_t FindHeaderEndFrom(const char* data, std::size_t len, std::size_t pos) {
+    while (pos + 4 <= len) {
+      pos += FindCharScalar(data + pos, len - pos - 3, '\r');
+      if (pos + 4 > len) break;
+      if (IsTerminator(data + pos)) return pos;
+      ++pos;
+    }
+    return len;
+  }
+
+  std::size_t FindHeaderEndScalar(const char* data, std::size_t len) {
+    return FindHeaderEndFrom(data, len, 0);
+  }
+
+#ifdef HEADER_SCANNER_X86
+  // ========================================
+  // 128-bit kernels (SSE4.2 baseline): 64 bytes per iteration, with blocks
+  // that contain no candidate byte skipped by a single test
+  // ========================================
+  __attribute__((target("sse4.2,bmi")))
+  std::size_t FindCharSse42(const char* data, std::size_t len, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    std::size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+      const __m128i* p = reinterpret_cast<const __m128i*>(data + i);
+      __m128i m0 = _mm_cmpeq_epi8(_mm_loadu_si128(p), needle);
+      __m128i m1 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 1), needle);
+      __m128i m2 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 2), needle);
+      __m128i m3 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 3), needle);
+      __m128i any = _mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3));
+      if (_mm_testz_si128(any, any)) continue;
+      std::uint64_t mask = static_cast<std::uint64_t>(_mm_movemask_epi8(m0)) |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m1)) << 16 |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m2)) << 32 |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m3)) << 48;
+      return i + _tzcnt_u64(mask);
+    }
+    for (; i + 16 <= len; i += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+      if (mask) return i + _tzcnt_u32(mask);
+    }
+    return i + FindCharScalar(data + i, len - i, c);
+  }
+
+  __attribute__((target("sse4.2,bmi")))
+  std::size_t FindHeaderEndSse42(const char* data, std::size_t len) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    std::size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+      const __m128i* p = reinterpret_cast<const __m128i*>(data + i);
+      __m128i m0 = _mm_cmpeq_epi8(_mm_loadu_si128(p), cr);
+      __m128i m1 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 1), cr);
+      __m128i m2 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 2), cr);
+      __m128i m3 = _mm_cmpeq_epi8(_mm_loadu_si128(p + 3), cr);
+      __m128i any = _mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3));
+      if (_mm_testz_si128(any, any)) continue;
+      std::uint64_t mask = static_cast<std::uint64_t>(_mm_movemask_epi8(m0)) |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m1)) << 16 |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m2)) << 32 |
+                           static_cast<std::uint64_t>(_mm_movemask_epi8(m3)) << 48;
+      while (mask) {
+        std::size_t pos = i + _tzcnt_u64(mask);
+        if (pos + 4 <= len && IsTerminator(data + pos)) return pos;
+        mask &= mask - 1;
+      }
+    }
+    return FindHeaderEndFrom(data, len, i);
+  }
+
+  // ========================================
+  // 256-bit kernels (AVX2): same shape with two 32-byte lanes per iteration
+  // ========================================
+  __attribute__((target("avx2,bmi")))
+  std::size_t FindCharAvx2(const char* data, std::size_t len, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    std::size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+      const __m256i* p = reinterpret_cast<const __m256i*>(data + i);
+      __m256i m0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(p), needle);
+      __m256i m1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), needle);
+      __m256i any = _mm256_or_si256(m0, m1);
+      if (_mm256_testz_si256(any, any)) continue;
+      std::uint64_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(m0)) |
+                           static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(m1))) << 32;
+      return i + _tzcnt_u64(mask);
+    }
+    for (; i + 32 <= len; i += 32) {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+      if (mask) return i + _tzcnt_u32(mask);
+    }
+    return i + FindCharScalar(data + i, len - i, c);
+  }
+
+  __attribute__((target("avx2,bmi")))
+  std::size_t FindHeaderEndAvx2(const char* data, std::size_t len) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    std::size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+      const __m256i* p = reinterpret_cast<const __m256i*>(data + i);
+      __m256i m0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(p), cr);
+      __m256i m1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), cr);
+      __m256i any = _mm256_or_si256(m0, m1);
+      if (_mm256_testz_si256(any, any)) continue;
+      std::uint64_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(m0)) |
+                           static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(m1))) << 32;
+      while (mask) {
+        std::size_t pos = i + _tzcnt_u64(mask);
+        if (pos + 4 <= len && IsTerminator(data + pos)) return pos;
+        mask &= mask - 1;
+      }
+    }
+    return FindHeaderEndFrom(data, len, i);
+  }
+#endif
+
+  // ========================================
+  // Runtime dispatch
+  // ========================================
+  struct Kernels {
+    HeaderScanner::Kernel kind;
+    FindHeaderEndFn find_header_end;
+    FindCharFn find_char;
+  };
+
+  const Kernels kScalar{HeaderScanner::Kernel::scalar, FindHeaderEndScalar, FindCharScalar};
+#ifdef HEADER_SCANNER_X86
+  const Kernels kSse42{HeaderScanner::Kernel::sse42, FindHeaderEndSse42, FindCharSse42};
+  const Kernels kAvx2{HeaderScanner::Kernel::avx2, FindHeaderEndAvx2, FindCharAvx2};
+#endif
+
+  const Kernels* KernelsFor(HeaderScanner::Kernel k) {
+#ifdef HEADER_SCANNER_X86
+    if (k == HeaderScanner::Kernel::avx2) return &kAvx2;
+    if (k == HeaderScanner::Kernel::sse42) return &kSse42;
+#endif
+    return &kScalar;
+  }
+
+  // Pick the widest kernel the CPU supports (CPUID via the compiler builtin)
+  const Kernels* DetectKernels() {
+    if (HeaderScanner::supported(HeaderScanner::Kernel::avx2)) return KernelsFor(HeaderScanner::Kernel::avx2);
+    if (HeaderScanner::supported(HeaderScanner::Kernel::sse42)) return KernelsFor(HeaderScanner::Kernel::sse42);
+    return &kScalar;
+  }
+
+  const Kernels*& Active() {
+    static const Kernels* active = DetectKernels();
+    return active;
+  }
+} // end of namespace
+
+std::size_t HeaderScanner::find_header_end(const char* data, std::size_t len) {
+  return Active()->find_header_end(data, len);
+}
+
+std::size_t HeaderScanner::find_char(const char* data, std::size_t len, char c) {
+  return Active()->find_char(data, len, c);
+}
+
+HeaderScanner::Kernel HeaderScanner::kernel() {
+  return Active()->kind;
+}
+
+bool HeaderScanner::supported(Kernel k) {
+  switch (k) {
+    case Kernel::scalar:
+      return true;
+#ifdef HEADER_SCANNER_X86
+    case Kernel::sse42:
+      return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("bmi");
+    case Kernel::avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi");
+#endif
+    default:
+      return false;
+  }
+}
+
+bool HeaderScanner::set_kernel(Kernel k) {
+  if (!supported(k)) return false;
+  Active() = KernelsFor(k);
+  return true;
+}
+
+const char* HeaderScanner::kernel_name(Kernel k) {
+  switch (k) {
+    case Kernel::scalar: return "scalar";
+    case Kernel::sse42:  return "sse4.2";
+    case Kernel::avx2:   return "avx2";
+  }
+  return "unknown";
+}
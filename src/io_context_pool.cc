@@ -0,0 +1,87 @@
+#include "io_context_pool.h"
+#include <boost/log/trivial.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+  // Pin the calling thread to `core`; failures only cost locality
+  void PinToCore(std::size_t core) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+      BOOST_LOG_TRIVIAL(warning) << "Could not pin worker thread to core " << core;
+    }
+#endif
+  }
+} // end of namespace
+
+std::size_t IoContextPool::resolve_threads(std::size_t threads) {
+  if (threads > 0) {
+    return threads;
+  }
+  unsigned hardware = std::thread::hardware_concurrency();
+  return hardware > 0 ? hardware : 1;
+}
+
+IoContextPool::IoContextPool(std::size_t threads, ServerConfig::IoModel model)
+  : threads_(resolve_threads(threads)),
+    model_(model)
+{
+  std::size_t count = model_ == ServerConfig::IoModel::per_core ? threads_ : 1;
+  for (std::size_t i = 0; i < count; ++i) {
+    // Tell asio how many threads will run each context
+    int hint = model_ == ServerConfig::IoModel::per_core ? 1 : static_cast<int>(threads_);
+    contexts_.push_back(std::make_unique<boost::asio::io_context>(hint));
+    work_.push_back(boost::asio::make_work_guard(*contexts_.back()));
+  }
+}
+
+IoContextPool::~IoContextPool()
+{
+  stop();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+boost::asio::io_context& IoContextPool::next()
+{
+  return *contexts_[next_.fetch_add(1, std::memory_order_relaxed) % contexts_.size()];
+}
+
+void IoContextPool::run()
+{
+  BOOST_LOG_TRIVIAL(info) << "Starting " << threads_ << " worker thread(s) on "
+                          << contexts_.size() << " io_context(s)";
+  bool pin = model_ == ServerConfig::IoModel::per_core;
+  std::size_t cores = resolve_threads(0);
+  for (std::size_t i = 0; i < threads_; ++i) {
+    boost::asio::io_context& ctx = *contexts_[i % contexts_.size()];
+    workers_.emplace_back([&ctx, pin, core = i % cores]() {
+      if (pin) {
+        PinToCore(core);
+      }
+      ctx.run();
+    });
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void IoContextPool::stop()
+{
+  work_.clear();
+  for (auto& ctx : contexts_) {
+    ctx->stop();
+  }
+}
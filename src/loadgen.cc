@@ -0,0 +1,449 @@
+#include "loadgen.h"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <nlohmann/json.hpp>
+#include "metrics.h"
+
+namespace http = boost::beast::http;
+using boost::asio::ip::tcp;
+
+namespace loadgen {
+
+const char* kind_name(Kind kind) {
+  switch (kind) {
+    case Kind::static_file: return "static";
+    case Kind::echo: return "echo";
+    case Kind::api: return "api";
+    case Kind::messages: return "messages";
+  }
+  return "";  // LCOV_EXCL_LINE
+}
+
+bool parse_mix(const std::string& text, Mix& mix, std::string& error) {
+  Mix parsed;
+  std::set<Kind> seen;
+  std::istringstream entries(text);
+  std::string entry;
+  while (std::getline(entries, entry, ',')) {
+    auto eq = entry.find('=');
+    std::string name = entry.substr(0, eq);
+    std::string weight = eq == std::string::npos ? "" : entry.substr(eq + 1);
+    const Kind* kind = std::find_if(std::begin(kKinds), std::end(kKinds),
+                                    [&](Kind k) { return name == kind_name(k); });
+    if (kind == std::end(kKinds)) {
+      error = "unknown request kind: " + name;
+      return false;
+    }
+    if (weight.empty() || weight.size() > 6 || weight.find_first_not_of("0123456789") != std::string::npos ||
+        std::stoul(weight) == 0) {
+      error = "bad weight for " + name + ": " + weight;
+      return false;
+    }
+    if (!seen.insert(*kind).second) {
+      error = "request kind listed twice: " + name;
+      return false;
+    }
+    parsed.emplace_back(*kind, static_cast<unsigned>(std::stoul(weight)));
+  }
+  if (parsed.empty()) {
+    error = "empty request mix";
+    return false;
+  }
+  mix = std::move(parsed);
+  return true;
+}
+
+const char* const kUsage =
+  "Usage: loadgen [options]\n"
+  "  --host ADDR                  server address (127.0.0.1)\n"
+  "  --port N                     server port (8080)\n"
+  "  --connections N              concurrent connections, one client thread each (16)\n"
+  "  --duration SECONDS           measured run time (10)\n"
+  "  --warmup SECONDS             unmeasured time before it (1)\n"
+  "  --requests-per-connection N  reconnect after N requests; 0 keeps connections open (0)\n"
+  "  --rate N                     open-loop requests per second in total; 0 is closed-loop (0)\n"
+  "  --mix KIND=W,...             weights of static, echo, api, messages (echo=1)\n"
+  "  --static-path PATH           file requested by 'static' (/static1/index.html)\n"
+  "  --seed N                     seed for the request sequence (1)\n"
+  "  --server PATH --config FILE  start this server for the run and stop it after\n"
+  "  --out FILE                   write the JSON report to FILE instead of stdout\n";
+
+bool parse_options(int argc, const char* const argv[], Options& options, std::string& error) {
+  for (int i = 1; i < argc; ++i) {
+    std::string flag = argv[i];
+    if (flag == "--help") {
+      error.clear();  // not an error: print the usage
+      return false;
+    }
+    if (i + 1 >= argc) {
+      error = "missing value for " + flag;
+      return false;
+    }
+    std::string value = argv[++i];
+    try {
+      std::size_t used = 0;
+      auto number = [&](auto parse) {
+        auto n = parse(value, &used);
+        if (used != value.size() || n < 0) throw std::invalid_argument(value);
+        return n;
+      };
+      auto to_double = [](const std::string& s, std::size_t* pos) { return std::stod(s, pos); };
+      auto to_long = [](const std::string& s, std::size_t* pos) { return std::stol(s, pos); };
+      if (flag == "--host") {
+        options.host = value;
+      } else if (flag == "--port") {
+        long port = number(to_long);
+        if (port == 0 || port > 65535) throw std::invalid_argument(value);
+        options.port = static_cast<unsigned short>(port);
+      } else if (flag == "--connections") {
+        options.connections = static_cast<std::size_t>(number(to_long));
+        if (options.connections == 0) throw std::invalid_argument(value);
+      } else if (flag == "--duration") {
+        options.duration_s = number(to_double);
+        if (options.duration_s <= 0) throw std::invalid_argument(value);
+      } else if (flag == "--warmup") {
+        options.warmup_s = number(to_double);
+      } else if (flag == "--requests-per-connection") {
+        options.requests_per_connection = static_cast<std::size_t>(number(to_long));
+      } else if (flag == "--rate") {
+        options.rate = number(to_double);
+      } else if (flag == "--mix") {
+        if (!parse_mix(value, options.mix, error)) return false;
+      } else if (flag == "--static-path") {
+        options.static_path = value;
+      } else if (flag == "--seed") {
+        options.seed = static_cast<std::uint32_t>(number(to_long));
+      } else if (flag == "--server") {
+        options.server = value;
+      } else if (flag == "--config") {
+        options.server_config = value;
+      } else if (flag == "--out") {
+        options.out = value;
+      } else {
+        error = "unknown option: " + flag;
+        return false;
+      }
+    } catch (const std::exception&) {
+      error = "bad value for " + flag + ": " + value;
+      return false;
+    }
+  }
+  if (options.server.empty() != options.server_config.empty()) {
+    error = "--server and --config go together";
+    return false;
+  }
+  return true;
+}
+
+void Stats::record(std::uint64_t micros, bool error) {
+  ++requests;
+  errors += error;
+  latency_sum_us += micros;
+  latency_max_us = std::max(latency_max_us, micros);
+  latency.resize(LatencyHistogram::kBuckets);
+  ++latency[LatencyHistogram::bucket(micros)];
+}
+
+void Stats::merge(const Stats& other) {
+  requests += other.requests;
+  errors += other.errors;
+  latency_sum_us += other.latency_sum_us;
+  latency_max_us = std::max(latency_max_us, other.latency_max_us);
+  latency.resize(LatencyHistogram::kBuckets);
+  for (std::size_t i = 0; i < other.latency.size(); ++i) {
+    latency[i] += other.latency[i];
+  }
+}
+
+namespace {
+  using Clock = Schedule::Clock;
+  using Request = http::request<http::string_body>;
+  using Response = http::response<http::string_body>;
+
+  const char* const kApiPath = "/api/LoadgenItem";
+
+  // One simulated client: a connection, its place in the api and messages
+  // sequences, and what it measured
+  class Client {
+  public:
+    Client(const Options& options, std::size_t index)
+      : options_(options), index_(index), rng_(options.seed * 7919u + static_cast<unsigned>(index)),
+        socket_(io_) {
+      std::vector<unsigned> weights;
+      for (const auto& [kind, weight] : options.mix) weights.push_back(weight);
+      pick_ = std::discrete_distribution<std::size_t>(weights.begin(), weights.end());
+      endpoint_ = *tcp::resolver(io_).resolve(options.host, std::to_string(options.port)).begin();
+    }
+
+    void run(Clock::time_point start, Clock::time_point measure_from, Clock::time_point end) {
+      bool uses_messages = std::any_of(options_.mix.begin(), options_.mix.end(),
+                                       [](const auto& entry) { return entry.first == Kind::messages; });
+      if (uses_messages) {
+        log_in();
+      }
+      std::this_thread::sleep_until(start);
+
+      bool open_loop = options_.rate > 0;
+      Clock::duration interval{0};
+      if (open_loop) {
+        interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options_.connections / options_.rate));
+      }
+      // Stagger the connections' schedules evenly across one interval
+      Schedule schedule(start + interval * index_ / options_.connections, interval);
+
+      for (;;) {
+        Clock::time_point intended = open_loop ? schedule.next() : Clock::now();
+        if (intended >= end) {
+          break;
+        }
+        std::this_thread::sleep_until(intended);
+        Kind kind = options_.mix[pick_(rng_)].first;
+        bool ok = send(kind);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - intended).count();
+        if (intended >= measure_from) {
+          result_.by_kind[kind].record(static_cast<std::uint64_t>(micros), !ok);
+        }
+      }
+      close();
+    }
+
+    const Result& result() const { return result_; }
+
+  private:
+    // One timed request of `kind`; false on a transport error or a 4xx/5xx
+    bool send(Kind kind) {
+      Response res;
+      switch (kind) {
+        case Kind::static_file:
+          return exchange(make(http::verb::get, options_.static_path), res);
+        case Kind::echo:
+          return exchange(make(http::verb::get, "/echo"), res);
+        case Kind::api:
+          return api_step(res);
+        case Kind::messages: {
+          bool post = post_next_;
+          post_next_ = !post_next_;
+          if (post) {
+            return exchange(make(http::verb::post, "/messages/post",
+                                 "{\"content\":\"loadgen message from client " + std::to_string(index_) + "\"}"),
+                            res);
+          }
+          return exchange(make(http::verb::get, "/messages/get"), res);
+        }
+      }
+      return false;  // LCOV_EXCL_LINE
+    }
+
+    // Create, read, update and delete one item, a step per call
+    bool api_step(Response& res) {
+      std::string item = std::string(kApiPath) + "/" + std::to_string(api_id_);
+      std::string body = "{\"client\":" + std::to_string(index_) + ",\"step\":" + std::to_string(api_step_) + "}";
+      bool ok = false;
+      switch (api_step_) {
+        case 0:
+          ok = exchange(make(http::verb::post, kApiPath, body), res);
+          if (ok) {
+            auto json = nlohmann::json::parse(res.body(), nullptr, false);
+            ok = json.is_object() && json.contains("id") && json["id"].is_number_integer();
+            if (ok) api_id_ = json["id"].get<int>();
+          }
+          break;
+        case 1:
+          ok = exchange(make(http::verb::get, item), res);
+          break;
+        case 2:
+          ok = exchange(make(http::verb::put, item, body), res);
+          break;
+        default:
+          ok = exchange(make(http::verb::delete_, item), res);
+          break;
+      }
+      api_step_ = ok ? (api_step_ + 1) % 4 : 0;
+      return ok;
+    }
+
+    // Register a user of our own and log in, untimed
+    void log_in() {
+      std::string user = "loadgen-" + std::to_string(::getpid()) + "-" + std::to_string(options_.seed) +
+                         "-" + std::to_string(index_);
+      std::string credentials = "{\"username\":\"" + user + "\",\"password\":\"loadgen-password\"}";
+      Response res;
+      exchange(make(http::verb::post, "/register", credentials), res);  // may already exist
+      if (exchange(make(http::verb::post, "/login", credentials), res)) {
+        auto cookie = res[http::field::set_cookie];
+        cookie_ = std::string(cookie.substr(0, cookie.find(';')));
+      }
+    }
+
+    Request make(http::verb method, const std::string& target, const std::string& body = "") {
+      Request req(method, target, 11);
+      req.set(http::field::host, options_.host + ":" + std::to_string(options_.port));
+      req.set(http::field::user_agent, "loadgen");
+      if (!cookie_.empty()) {
+        req.set(http::field::cookie, cookie_);
+      }
+      if (!body.empty()) {
+        req.set(http::field::content_type, "application/json");
+        req.body() = body;
+      }
+      req.prepare_payload();
+      return req;
+    }
+
+    bool connect() {
+      boost::system::error_code ec;
+      socket_.connect(endpoint_, ec);
+      if (ec) {
+        ++result_.connect_errors;
+        socket_.close(ec);
+        return false;
+      }
+      ++result_.connections_opened;
+      requests_on_connection_ = 0;
+      // Give up on a server that stops answering instead of hanging the run
+      timeval timeout{10, 0};
+      ::setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      ::setsockopt(socket_.native_handle(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      socket_.set_option(tcp::no_delay(true), ec);
+      return true;
+    }
+
+    void close() {
+      boost::system::error_code ec;
+      socket_.close(ec);
+    }
+
+    bool exchange(Request req, Response& res) {
+      if (!socket_.is_open() && !connect()) {
+        return false;
+      }
+      bool last = options_.requests_per_connection &&
+                  requests_on_connection_ + 1 >= options_.requests_per_connection;
+      req.keep_alive(!last);
+      boost::system::error_code ec;
+      http::write(socket_, req, ec);
+      http::response_parser<http::string_body> parser;
+      parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+      if (!ec) {
+        http::read(socket_, buffer_, parser, ec);
+      }
+      if (ec) {
+        close();
+        buffer_.clear();
+        return false;
+      }
+      res = parser.release();
+      ++requests_on_connection_;
+      if (last || !res.keep_alive()) {
+        close();
+        buffer_.clear();
+      }
+      return res.result_int() < 400;
+    }
+
+    const Options& options_;
+    std::size_t index_;
+    std::mt19937 rng_;
+    std::discrete_distribution<std::size_t> pick_;
+    boost::asio::io_context io_;
+    tcp::socket socket_;
+    tcp::endpoint endpoint_;
+    boost::beast::flat_buffer buffer_;
+    std::size_t requests_on_connection_ = 0;
+    int api_step_ = 0;
+    int api_id_ = 0;
+    bool post_next_ = true;
+    std::string cookie_;
+    Result result_;
+  };
+}
+
+Result run(const Options& options) {
+  std::vector<std::unique_ptr<Client>> clients;
+  for (std::size_t i = 0; i < options.connections; ++i) {
+    clients.push_back(std::make_unique<Client>(options, i));
+  }
+  // Leave the clients a moment to start and log in before the clock starts
+  auto start = Clock::now() + std::chrono::milliseconds(200);
+  auto measure_from = start + std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(options.warmup_s));
+  auto end = measure_from + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(options.duration_s));
+
+  std::vector<std::thread> threads;
+  for (auto& client : clients) {
+    threads.emplace_back([&client, start, measure_from, end] { client->run(start, measure_from, end); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  Result result;
+  result.elapsed_s = std::chrono::duration<double>(end - measure_from).count();
+  for (const auto& client : clients) {
+    result.connections_opened += client->result().connections_opened;
+    result.connect_errors += client->result().connect_errors;
+    for (const auto& [kind, stats] : client->result().by_kind) {
+      result.by_kind[kind].merge(stats);
+      result.total.merge(stats);
+    }
+  }
+  return result;
+}
+
+namespace {
+  nlohmann::json StatsJson(const Stats& stats, double elapsed_s) {
+    nlohmann::json latency = {
+      {"mean", stats.requests ? stats.latency_sum_us / stats.requests : 0},
+      {"max", stats.latency_max_us},
+    };
+    static const std::pair<const char*, double> kQuantiles[] = {
+      {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+    for (const auto& [name, q] : kQuantiles) {
+      latency[name] = LatencyHistogram::quantile(stats.latency, q);
+    }
+    return {
+      {"requests", stats.requests},
+      {"errors", stats.errors},
+      {"throughput_rps", elapsed_s > 0 ? stats.requests / elapsed_s : 0},
+      {"latency_us", latency},
+    };
+  }
+}
+
+std::string report(const Options& options, const Result& result) {
+  nlohmann::json mix = nlohmann::json::object();
+  for (const auto& [kind, weight] : options.mix) {
+    mix[kind_name(kind)] = weight;
+  }
+  nlohmann::json json = {
+    {"mode", options.rate > 0 ? "open" : "closed"},
+    {"target_rate", options.rate},
+    {"connections", options.connections},
+    {"requests_per_connection", options.requests_per_connection},
+    {"duration_s", options.duration_s},
+    {"warmup_s", options.warmup_s},
+    {"mix", mix},
+    {"connections_opened", result.connections_opened},
+    {"connect_errors", result.connect_errors},
+  };
+  json.update(StatsJson(result.total, result.elapsed_s));
+  nlohmann::json by_kind = nlohmann::json::object();
+  for (const auto& [kind, stats] : result.by_kind) {
+    by_kind[kind_name(kind)] = StatsJson(stats, result.elapsed_s);
+  }
+  json["by_kind"] = by_kind;
+  return json.dump(2);
+}
+
+}  // namespace loadgen
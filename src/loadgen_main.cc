@@ -0,0 +1,94 @@
+// Drives a server over loopback and prints throughput and latency
+// percentiles as JSON; see loadgen.h and `loadgen --help`.
+
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <boost/asio.hpp>
+#include "loadgen.h"
+
+namespace {
+  // Start `server` with `config`, its output discarded so it cannot mix
+  // with the report. Returns the child's pid, or -1.
+  pid_t StartServer(const std::string& server, const std::string& config) {
+    pid_t pid = ::fork();
+    if (pid == 0) {
+      int null = ::open("/dev/null", O_WRONLY);
+      ::dup2(null, STDOUT_FILENO);
+      ::dup2(null, STDERR_FILENO);
+      ::execl(server.c_str(), server.c_str(), config.c_str(), static_cast<char*>(nullptr));
+      ::_exit(127);
+    }
+    return pid;
+  }
+
+  // Wait until the server accepts connections
+  bool WaitForServer(const loadgen::Options& options, pid_t pid) {
+    boost::asio::io_context io;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (::waitpid(pid, nullptr, WNOHANG) == pid) {
+        return false;  // it exited
+      }
+      boost::asio::ip::tcp::socket socket(io);
+      boost::system::error_code ec;
+      socket.connect({boost::asio::ip::make_address(options.host), options.port}, ec);
+      if (!ec) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+  }
+
+  void StopServer(pid_t pid) {
+    ::kill(pid, SIGTERM);
+    ::waitpid(pid, nullptr, 0);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  loadgen::Options options;
+  std::string error;
+  if (!loadgen::parse_options(argc, argv, options, error)) {
+    if (!error.empty()) {
+      std::cerr << "loadgen: " << error << "\n";
+    }
+    std::cerr << loadgen::kUsage;
+    return error.empty() ? 0 : 2;
+  }
+
+  pid_t server = -1;
+  if (!options.server.empty()) {
+    server = StartServer(options.server, options.server_config);
+    if (server < 0 || !WaitForServer(options, server)) {
+      std::cerr << "loadgen: server did not start listening on port " << options.port << "\n";
+      if (server > 0) StopServer(server);
+      return 1;
+    }
+  }
+
+  int status = 0;
+  try {
+    auto report = loadgen::report(options, loadgen::run(options));
+    if (options.out.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream(options.out) << report << "\n";
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "loadgen: " << e.what() << "\n";
+    status = 1;
+  }
+
+  if (server > 0) {
+    StopServer(server);
+  }
+  return status;
+}
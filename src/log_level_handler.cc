@@ -0,0 +1,82 @@
+#include "log_level_handler.h"
+#include <sstream>
+#include <boost/log/trivial.hpp>
+#include "handler_registry.h"
+#include "logger.h"
+
+const std::string LogLevelHandler::kName = "LogLevelHandler";
+
+namespace {
+  std::unique_ptr<HttpResponse> PlainText(int status, const std::string& body) {
+    auto response = std::make_unique<HttpResponse>();
+    response->status_code = status;
+    response->headers["Content-Type"] = "text/plain";
+    response->body = body;
+    return response;
+  }
+
+  std::string Settings() {
+    std::ostringstream out;
+    out << "level=" << log_level() << "\nsample_every=" << log_sampling() << "\n";
+    return out.str();
+  }
+}
+
+std::unique_ptr<HttpResponse> LogLevelHandler::handle_request(const HttpRequest& request) {
+  if (request.method == "GET") {
+    return PlainText(200, Settings());
+  }
+  if (request.method != "PUT" && request.method != "POST") {
+    auto response = PlainText(405, "Method Not Allowed");
+    response->headers["Allow"] = "GET, PUT, POST";
+    return response;
+  }
+
+  // Validate every setting before applying any of them
+  bool has_level = false;
+  bool has_sampling = false;
+  boost::log::trivial::severity_level level;
+  unsigned long sample_every = 0;
+  std::istringstream pairs(request.body);
+  std::string pair;
+  while (std::getline(pairs, pair, '&')) {
+    while (!pair.empty() && (pair.back() == '\n' || pair.back() == '\r')) pair.pop_back();
+    if (pair.empty()) continue;
+    auto eq = pair.find('=');
+    std::string key = pair.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : pair.substr(eq + 1);
+    if (key == "level" && parse_log_level(value, level)) {
+      has_level = true;
+    } else if (key == "sample_every" && !value.empty() &&
+               value.find_first_not_of("0123456789") == std::string::npos && value.size() < 10) {
+      sample_every = std::stoul(value);
+      has_sampling = true;
+    } else {
+      return PlainText(400, "Bad setting: " + pair + "\n");
+    }
+  }
+  if (!has_level && !has_sampling) {
+    return PlainText(400, "Expected level=<level> and/or sample_every=<n>\n");
+  }
+
+  if (has_level) {
+    set_log_level(level);
+  }
+  if (has_sampling) {
+    set_log_sampling(static_cast<unsigned>(sample_every));
+  }
+  BOOST_LOG_TRIVIAL(warning) << "Logging changed from " << request.client_ip << ": level="
+                             << log_level() << " sample_every=" << log_sampling();
+  return PlainText(200, Settings());
+}
+
+// LCOV_EXCL_START
+static const bool logLevelRegistered =
+  HandlerRegistry::instance()
+    .registerHandler(
+      LogLevelHandler::kName,
+      [](const std::vector<std::string>&) {
+        return std::make_unique<LogLevelHandler>();
+      }
+    );
+// LCOV_EXCL_STOP
@@ -1,15 +1,21 @@
 #include "logger.h"
+#include <atomic>
+#include <ctime>
 // dependencies for writing and formatting logs, attaching attributes
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/setup/file.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/sinks/text_file_backend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
 #include <boost/log/sources/logger.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/expressions/formatters.hpp>
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/attributes/current_thread_id.hpp>
+#include <boost/core/null_deleter.hpp>
+#include <boost/make_shared.hpp>
+#include "async_log_backend.h"
 
 // create namespaces for simpler syntax
 namespace logging = boost::log;
@@ -17,35 +23,131 @@ namespace sinks = boost::log::sinks;
 namespace expr = boost::log::expressions;
 namespace attrs = boost::log::attributes;
 
-//
-void init_logging() {
-    // set up log sink that writes to terminal
-    logging::add_console_log(std::clog,
-        logging::keywords::format = (
-            expr::stream
-                << "[" << expr::format_date_time<boost::posix_time::ptime>("TimeStamp", "%Y-%m-%d %H:%M:%S")
-                << "] [" << logging::trivial::severity
-                << "] [Thread " << expr::attr<attrs::current_thread_id::value_type>("ThreadID")
-                << "] " << expr::smessage
-        )); // format: [2025-04-24 12:00:00] [info] [Thread 0x123456] your message here
-
-    logging::add_file_log( // write to log file, create new file at midnight or 10MB
+namespace {
+  std::atomic<int> min_level{logging::trivial::trace};
+  std::atomic<unsigned> sample_every{1};
+
+  // Held here as well as by the core so that the writer thread is joined
+  // after remove_all_sinks() returns, not under the core's lock
+  boost::shared_ptr<AsyncLogSink> async_sink;
+
+  // format: [2025-04-24 12:00:00] [info] [Thread 0x123456] your message here
+  logging::formatter LineFormat() {
+    return expr::stream
+        << "[" << expr::format_date_time<boost::posix_time::ptime>("TimeStamp", "%Y-%m-%d %H:%M:%S")
+        << "] [" << logging::trivial::severity
+        << "] [Thread " << expr::attr<attrs::current_thread_id::value_type>("ThreadID")
+        << "] " << expr::smessage;
+  }
+
+  // Console and file writing on the writer thread. The backends are only
+  // touched from there, so they need no lock, and the file is flushed once
+  // per batch instead of once per record.
+  AsyncLogBackend::Writer AsyncWriter() {
+    auto console = boost::make_shared<sinks::text_ostream_backend>();
+    console->add_stream(boost::shared_ptr<std::ostream>(&std::clog, boost::null_deleter()));
+    auto file = boost::make_shared<sinks::text_file_backend>(
         logging::keywords::file_name = "../logs/server_%Y-%m-%d.log",
-        logging::keywords::rotation_size = 10 * 1024 * 1024, // 10 MB
-        logging::keywords::time_based_rotation = sinks::file::rotation_at_time_point(0, 0, 0),
-        logging::keywords::auto_flush = true,
-        logging::keywords::format = (
-            expr::stream
-                << "[" << expr::format_date_time<boost::posix_time::ptime>("TimeStamp", "%Y-%m-%d %H:%M:%S")
-                << "] [" << logging::trivial::severity
-                << "] [Thread " << expr::attr<attrs::current_thread_id::value_type>("ThreadID")
-                << "] " << expr::smessage
-        ) // format: [2025-04-24 12:00:00] [info] [Thread 0x123456] your message here
-    );
-
-    logging::core::get()->set_filter(
-        logging::trivial::severity >= logging::trivial::trace
-    );
+        logging::keywords::rotation_size = 10 * 1024 * 1024,
+        logging::keywords::time_based_rotation = sinks::file::rotation_at_time_point(0, 0, 0));
+    logging::formatter format = LineFormat();
+    auto line = std::make_shared<std::string>();
+    return [console, file, format, line](const AsyncLogBackend::Batch& batch, std::uint64_t dropped) {
+      for (const auto& rec : batch) {
+        line->clear();
+        logging::formatting_ostream out(*line);
+        format(rec, out);
+        out.flush();
+        console->consume(rec, *line);
+        file->consume(rec, *line);
+      }
+      if (dropped > 0) {
+        std::time_t now = std::time(nullptr);
+        std::tm local;
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime_r(&now, &local));
+        *line = std::string("[") + stamp + "] [warning] Log queue full: dropped " +
+                std::to_string(dropped) + " records";
+        console->consume(batch.back(), *line);
+        file->consume(batch.back(), *line);
+      }
+      console->flush();
+      file->flush();
+    };
+  }
+}
+
+void init_logging() {
+    init_logging(LogOptions());
+}
+
+void init_logging(const LogOptions& options) {
+    shutdown_logging();
+    auto core = logging::core::get();
+
+    if (options.async) {
+        auto overflow = options.overflow == LogOptions::Overflow::block
+                            ? AsyncLogBackend::Overflow::block
+                            : AsyncLogBackend::Overflow::drop;
+        auto backend = boost::make_shared<AsyncLogBackend>(AsyncWriter(), options.queue_size, overflow);
+        async_sink = boost::make_shared<AsyncLogSink>(backend);
+        core->add_sink(async_sink);
+    } else {
+        // set up log sink that writes to terminal
+        logging::add_console_log(std::clog, logging::keywords::format = LineFormat());
+
+        logging::add_file_log( // write to log file, create new file at midnight or 10MB
+            logging::keywords::file_name = "../logs/server_%Y-%m-%d.log",
+            logging::keywords::rotation_size = 10 * 1024 * 1024, // 10 MB
+            logging::keywords::time_based_rotation = sinks::file::rotation_at_time_point(0, 0, 0),
+            logging::keywords::auto_flush = true,
+            logging::keywords::format = LineFormat()
+        );
+    }
+
+    // The level is read from an atomic on each record so it can change at runtime
+    set_log_level(options.level);
+    set_log_sampling(options.sample_every);
+    core->set_filter([](const logging::attribute_value_set& attrs) {
+        auto severity = attrs[logging::trivial::severity];
+        return !severity || *severity >= min_level.load(std::memory_order_relaxed);
+    });
 
     logging::add_common_attributes(); // adds TimeStamp, ThreadID
-}
\ No newline at end of file
+}
+
+void shutdown_logging() {
+    auto core = logging::core::get();
+    core->flush();
+    core->remove_all_sinks();
+    async_sink.reset();
+}
+
+void set_log_level(logging::trivial::severity_level level) {
+    min_level.store(level, std::memory_order_relaxed);
+}
+
+logging::trivial::severity_level log_level() {
+    return static_cast<logging::trivial::severity_level>(min_level.load(std::memory_order_relaxed));
+}
+
+bool parse_log_level(const std::string& name, logging::trivial::severity_level& level) {
+    return logging::trivial::from_string(name.c_str(), name.size(), level);
+}
+
+void set_log_sampling(unsigned every) {
+    sample_every.store(every == 0 ? 1 : every, std::memory_order_relaxed);
+}
+
+unsigned log_sampling() {
+    return sample_every.load(std::memory_order_relaxed);
+}
+
+bool sample_request_log() {
+    unsigned every = sample_every.load(std::memory_order_relaxed);
+    if (every <= 1) {
+        return true;
+    }
+    thread_local unsigned counter = 0;
+    return ++counter % every == 0;
+}
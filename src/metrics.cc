@@ -0,0 +1,282 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <utility>
+
+void LatencyHistogram::record(std::uint64_t micros) {
+  counts_[bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::add_to(std::vector<std::uint64_t>& into) const {
+  into.resize(kBuckets);
+  for (std::size_t i = 0; i < kBuckets; ++i) {
+    into[i] += counts_[i].load(std::memory_order_relaxed);
+  }
+}
+
+std::size_t LatencyHistogram::bucket(std::uint64_t micros) {
+  if (micros < kSubBuckets) {
+    return static_cast<std::size_t>(micros);
+  }
+  int magnitude = 63 - __builtin_clzll(micros);
+  std::size_t sub = (micros >> (magnitude - kSubBits)) - kSubBuckets;
+  std::size_t index = (magnitude - kSubBits + 1) * kSubBuckets + sub;
+  return std::min(index, kBuckets - 1);
+}
+
+std::uint64_t LatencyHistogram::upper_bound(std::size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int shift = static_cast<int>(index / kSubBuckets) - 1;
+  std::uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+  return lower + (std::uint64_t(1) << shift) - 1;
+}
+
+std::uint64_t LatencyHistogram::quantile(const std::vector<std::uint64_t>& counts, double q) {
+  std::uint64_t total = 0;
+  for (auto count : counts) total += count;
+  if (total == 0) {
+    return 0;
+  }
+  auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * total)));
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return upper_bound(i);
+    }
+  }
+  return upper_bound(counts.size() - 1);  // LCOV_EXCL_LINE
+}
+
+namespace {
+  constexpr int kMinStatus = 100;
+  constexpr int kMaxStatus = 599;
+
+  std::atomic<std::uint64_t> next_metrics_id{1};
+
+  // Prometheus label values escape backslash, quote and newline
+  std::string Label(const std::string& value) {
+    std::string out;
+    for (char c : value) {
+      if (c == '\\' || c == '"') {
+        out += '\\';
+        out += c;
+      } else if (c == '\n') {
+        out += "\\n";
+      } else {
+        out += c;
+      }
+    }
+    return out;
+  }
+
+  // The handler and route labels that identify one series
+  std::string SeriesLabels(const std::pair<std::string, std::string>& key) {
+    return "handler=\"" + Label(key.first) + "\",route=\"" + Label(key.second) + "\"";
+  }
+}
+
+struct alignas(64) Metrics::HandlerStats {
+  std::array<std::atomic<std::uint64_t>, kMaxStatus - kMinStatus + 1> statuses{};
+  std::atomic<std::uint64_t> bytes_in{0};
+  std::atomic<std::uint64_t> bytes_out{0};
+  std::atomic<std::uint64_t> latency_sum_us{0};
+  LatencyHistogram latency;
+  std::array<std::atomic<std::uint64_t>, RequestTiming::kStageCount> stage_sum_us{};
+  std::array<LatencyHistogram, RequestTiming::kStageCount> stages;
+};
+
+struct alignas(64) Metrics::Shard {
+  // Only the owning thread inserts, and it takes the mutex to do so; a
+  // scrape takes it to walk the map. The owner's own lookups need no lock.
+  std::mutex mutex;
+  // handler -> route -> stats
+  std::unordered_map<std::string,
+                     std::unordered_map<std::string, std::unique_ptr<HandlerStats>>> handlers;
+  alignas(64) std::atomic<std::uint64_t> connections_opened{0};
+  std::atomic<std::uint64_t> connections_closed{0};
+};
+
+// LCOV_EXCL_START
+Metrics& Metrics::instance() {
+  static Metrics metrics;
+  return metrics;
+}
+// LCOV_EXCL_STOP
+
+Metrics::Metrics() : id_(next_metrics_id.fetch_add(1)) {}
+
+Metrics::Shard& Metrics::local_shard() {
+  struct Local {
+    std::uint64_t owner = 0;
+    std::shared_ptr<Shard> shard;
+  };
+  thread_local Local local;
+  if (local.owner != id_) {
+    local.shard = std::make_shared<Shard>();
+    local.owner = id_;
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shards_.push_back(local.shard);
+  }
+  return *local.shard;
+}
+
+Metrics::HandlerStats& Metrics::local_stats(const std::string& handler, const std::string& route) {
+  Shard& shard = local_shard();
+  auto it = shard.handlers.find(handler);
+  if (it != shard.handlers.end()) {
+    auto found = it->second.find(route);
+    if (found != it->second.end()) {
+      return *found->second;
+    }
+  }
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto& stats = shard.handlers[handler][route];
+  stats = std::make_unique<HandlerStats>();
+  return *stats;
+}
+
+void Metrics::record_request(const std::string& handler, const std::string& route, int status,
+                             std::chrono::microseconds latency,
+                             std::uint64_t bytes_in, std::uint64_t bytes_out) {
+  HandlerStats& stats = local_stats(handler, route);
+  status = std::min(std::max(status, kMinStatus), kMaxStatus);
+  stats.statuses[status - kMinStatus].fetch_add(1, std::memory_order_relaxed);
+  stats.bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+  stats.bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+  auto micros = static_cast<std::uint64_t>(std::max<std::int64_t>(latency.count(), 0));
+  stats.latency_sum_us.fetch_add(micros, std::memory_order_relaxed);
+  stats.latency.record(micros);
+}
+
+void Metrics::record_stages(const std::string& handler, const std::string& route,
+                            const RequestTiming& timing) {
+  HandlerStats& stats = local_stats(handler, route);
+  for (int s = 0; s < RequestTiming::kStageCount; ++s) {
+    std::chrono::microseconds span;
+    if (timing.duration(static_cast<RequestTiming::Stage>(s), span)) {
+      auto micros = static_cast<std::uint64_t>(std::max<std::int64_t>(span.count(), 0));
+      stats.stage_sum_us[s].fetch_add(micros, std::memory_order_relaxed);
+      stats.stages[s].record(micros);
+    }
+  }
+}
+
+void Metrics::connection_opened() {
+  local_shard().connections_opened.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::connection_closed() {
+  local_shard().connections_closed.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string Metrics::scrape() const {
+  struct Totals {
+    std::map<int, std::uint64_t> statuses;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t latency_sum_us = 0;
+    std::vector<std::uint64_t> latency;
+    std::array<std::uint64_t, RequestTiming::kStageCount> stage_sum_us{};
+    std::array<std::vector<std::uint64_t>, RequestTiming::kStageCount> stages;
+  };
+  // Keyed by (handler, route) and sorted, so output order is stable
+  std::map<std::pair<std::string, std::string>, Totals> series;
+  std::uint64_t opened = 0;
+  std::uint64_t closed = 0;
+
+  std::vector<std::shared_ptr<Shard>> shards;
+  {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    shards = shards_;
+  }
+  for (const auto& shard : shards) {
+    opened += shard->connections_opened.load(std::memory_order_relaxed);
+    closed += shard->connections_closed.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    for (const auto& [name, routes] : shard->handlers) {
+      for (const auto& [route, stats] : routes) {
+        Totals& totals = series[{name, route}];
+        for (int status = kMinStatus; status <= kMaxStatus; ++status) {
+          auto count = stats->statuses[status - kMinStatus].load(std::memory_order_relaxed);
+          if (count) totals.statuses[status] += count;
+        }
+        totals.bytes_in += stats->bytes_in.load(std::memory_order_relaxed);
+        totals.bytes_out += stats->bytes_out.load(std::memory_order_relaxed);
+        totals.latency_sum_us += stats->latency_sum_us.load(std::memory_order_relaxed);
+        stats->latency.add_to(totals.latency);
+        for (int s = 0; s < RequestTiming::kStageCount; ++s) {
+          totals.stage_sum_us[s] += stats->stage_sum_us[s].load(std::memory_order_relaxed);
+          stats->stages[s].add_to(totals.stages[s]);
+        }
+      }
+    }
+  }
+
+  std::ostringstream out;
+  out << "# HELP server_requests_total Responses sent, by handler, route and status code.\n"
+      << "# TYPE server_requests_total counter\n";
+  for (const auto& [key, totals] : series) {
+    for (const auto& [status, count] : totals.statuses) {
+      out << "server_requests_total{" << SeriesLabels(key) << ",code=\"" << status << "\"} "
+          << count << "\n";
+    }
+  }
+
+  out << "# HELP server_request_duration_seconds Time from parsing a request to its response being ready.\n"
+      << "# TYPE server_request_duration_seconds summary\n";
+  for (const auto& [key, totals] : series) {
+    std::string label = SeriesLabels(key);
+    std::uint64_t count = 0;
+    for (auto c : totals.latency) count += c;
+    for (const char* q : {"0.5", "0.9", "0.99", "0.999"}) {
+      out << "server_request_duration_seconds{" << label << ",quantile=\"" << q << "\"} "
+          << LatencyHistogram::quantile(totals.latency, std::stod(q)) / 1e6 << "\n";
+    }
+    out << "server_request_duration_seconds_sum{" << label << "} " << totals.latency_sum_us / 1e6 << "\n"
+        << "server_request_duration_seconds_count{" << label << "} " << count << "\n";
+  }
+
+  out << "# HELP server_request_stage_seconds Time spent in each stage of a request.\n"
+      << "# TYPE server_request_stage_seconds summary\n";
+  for (const auto& [key, totals] : series) {
+    for (int s = 0; s < RequestTiming::kStageCount; ++s) {
+      std::uint64_t count = 0;
+      for (auto c : totals.stages[s]) count += c;
+      if (count == 0) {
+        continue;
+      }
+      std::string label = SeriesLabels(key) + ",stage=\"" +
+                          RequestTiming::stage_name(static_cast<RequestTiming::Stage>(s)) + "\"";
+      for (const char* q : {"0.5", "0.99", "0.999"}) {
+        out << "server_request_stage_seconds{" << label << ",quantile=\"" << q << "\"} "
+            << LatencyHistogram::quantile(totals.stages[s], std::stod(q)) / 1e6 << "\n";
+      }
+      out << "server_request_stage_seconds_sum{" << label << "} " << totals.stage_sum_us[s] / 1e6 << "\n"
+          << "server_request_stage_seconds_count{" << label << "} " << count << "\n";
+    }
+  }
+
+  out << "# HELP server_received_bytes_total Request bytes read, by handler and route.\n"
+      << "# TYPE server_received_bytes_total counter\n";
+  for (const auto& [key, totals] : series) {
+    out << "server_received_bytes_total{" << SeriesLabels(key) << "} " << totals.bytes_in << "\n";
+  }
+  out << "# HELP server_sent_bytes_total Response bytes queued, by handler and route.\n"
+      << "# TYPE server_sent_bytes_total counter\n";
+  for (const auto& [key, totals] : series) {
+    out << "server_sent_bytes_total{" << SeriesLabels(key) << "} " << totals.bytes_out << "\n";
+  }
+
+  out << "# HELP server_connections_in_flight Open client connections.\n"
+      << "# TYPE server_connections_in_flight gauge\n"
+      << "server_connections_in_flight " << (opened > closed ? opened - closed : 0) << "\n"
+      << "# HELP server_connections_total Client connections accepted.\n"
+      << "# TYPE server_connections_total counter\n"
+      << "server_connections_total " << opened << "\n";
+  return out.str();
+}
@@ -0,0 +1,32 @@
+#include "metrics_handler.h"
+#include "handler_registry.h"
+#include "metrics.h"
+
+const std::string MetricsHandler::kName = "MetricsHandler";
+
+std::unique_ptr<HttpResponse> MetricsHandler::handle_request(const HttpRequest& request) {
+  auto response = std::make_unique<HttpResponse>();
+  if (request.method != "GET") {
+    response->status_code = 405;
+    response->headers["Content-Type"] = "text/plain";
+    response->headers["Allow"] = "GET";
+    response->body = "Method Not Allowed";
+    return response;
+  }
+  response->status_code = 200;
+  response->headers["Content-Type"] = "text/plain; version=0.0.4";
+  response->headers["Cache-Control"] = "no-store";
+  response->body = Metrics::instance().scrape();
+  return response;
+}
+
+// LCOV_EXCL_START
+static const bool metricsRegistered =
+  HandlerRegistry::instance()
+    .registerHandler(
+      MetricsHandler::kName,
+      [](const std::vector<std::string>&) {
+        return std::make_unique<MetricsHandler>();
+      }
+    );
+// LCOV_EXCL_STOP
@@ -0,0 +1,97 @@
+#include "mime_types.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <utility>
+
+namespace {
+  using Entry = std::pair<std::string_view, std::string_view>;
+
+  // Sorted by extension for binary search
+  constexpr std::array<Entry, 38> kBuiltin = {{
+    {"7z", "application/x-7z-compressed"},
+    {"avif", "image/avif"},
+    {"bin", "application/octet-stream"},
+    {"bmp", "image/bmp"},
+    {"css", "text/css"},
+    {"csv", "text/csv"},
+    {"gif", "image/gif"},
+    {"gz", "application/gzip"},
+    {"htm", "text/html"},
+    {"html", "text/html"},
+    {"ico", "image/x-icon"},
+    {"jpeg", "image/jpeg"},
+    {"jpg", "image/jpeg"},
+    {"js", "text/javascript"},
+    {"json", "application/json"},
+    {"map", "application/json"},
+    {"md", "text/markdown"},
+    {"mjs", "text/javascript"},
+    {"mp3", "audio/mpeg"},
+    {"mp4", "video/mp4"},
+    {"ogg", "audio/ogg"},
+    {"otf", "font/otf"},
+    {"pdf", "application/pdf"},
+    {"png", "image/png"},
+    {"svg", "image/svg+xml"},
+    {"tar", "application/x-tar"},
+    {"ttf", "font/ttf"},
+    {"txt", "text/plain"},
+    {"wasm", "application/wasm"},
+    {"webm", "video/webm"},
+    {"webmanifest", "application/manifest+json"},
+    {"webp", "image/webp"},
+    {"woff", "font/woff"},
+    {"woff2", "font/woff2"},
+    {"xhtml", "application/xhtml+xml"},
+    {"xml", "application/xml"},
+    {"yaml", "application/yaml"},
+    {"zip", "application/zip"},
+  }};
+
+  constexpr bool Sorted() {
+    for (std::size_t i = 1; i < kBuiltin.size(); ++i) {
+      if (!(kBuiltin[i - 1].first < kBuiltin[i].first)) return false;
+    }
+    return true;
+  }
+  static_assert(Sorted(), "kBuiltin must be sorted by extension");
+
+  std::string Lower(std::string_view s) {
+    std::string out(s);
+    for (auto& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+  }
+}
+
+// LCOV_EXCL_START
+MimeTypes& MimeTypes::instance() {
+  static MimeTypes types;
+  return types;
+}
+// LCOV_EXCL_STOP
+
+void MimeTypes::add(std::string_view extension, std::string type) {
+  if (!extension.empty() && extension[0] == '.') extension.remove_prefix(1);
+  types_[Lower(extension)] = std::move(type);
+}
+
+std::string MimeTypes::lookup(std::string_view path) const {
+  auto dot = path.rfind('.');
+  if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos) {
+    return "";
+  }
+  std::string extension = Lower(path.substr(dot + 1));
+  if (!types_.empty()) {
+    auto it = types_.find(extension);
+    if (it != types_.end()) return it->second;
+  }
+  return std::string(builtin(extension));
+}
+
+std::string_view MimeTypes::builtin(std::string_view extension) {
+  auto it = std::lower_bound(kBuiltin.begin(), kBuiltin.end(), extension,
+                             [](const Entry& e, std::string_view ext) { return e.first < ext; });
+  if (it == kBuiltin.end() || it->first != extension) return "";
+  return it->second;
+}
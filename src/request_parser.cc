@@ -1,64 +1,180 @@
 #include "request_parser.h"
+#include "header_scanner.h"
 #include <boost/system/error_code.hpp>
 #include <system_error>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <cctype>
+#include <cstdlib>
 
-HttpRequest RequestParser::parse(const char* data, std::size_t len, boost::system::error_code& ec) {
-  ec.clear();                   
-  std::string raw(data, len);
-  HttpRequest req;
+namespace {
+  // case-insensitive comparison of a header name against a lowercase literal
+  bool NameEquals(std::string_view name, std::string_view lower) {
+    if (name.size() != lower.size()) return false;
+    for (std::size_t i = 0; i < name.size(); ++i) {
+      if (std::tolower(static_cast<unsigned char>(name[i])) != lower[i]) return false;
+    }
+    return true;
+  }
 
-  //raw string for echo
-  req.raw.assign(data, len);
-  // Split head & body
-  auto split = raw.find("\r\n\r\n");
-  std::string head = (split == std::string::npos ? raw : raw.substr(0, split));
-  if (split != std::string::npos) {
-    req.body = raw.substr(split + 4);
+  // string_view::find equivalents backed by the vectorized HeaderScanner
+  std::size_t FindChar(std::string_view v, char c, std::size_t from = 0) {
+    if (from >= v.size()) return std::string_view::npos;
+    std::size_t pos = from + HeaderScanner::find_char(v.data() + from, v.size() - from, c);
+    return pos == v.size() ? std::string_view::npos : pos;
   }
 
-  // Parse the request‐line: METHOD SP PATH SP VERSION
-  std::istringstream lines(head);
-  std::string request_line;
-  if (!std::getline(lines, request_line) || request_line.empty()) {
-    ec = make_error_code(std::errc::protocol_error);
-    return {};
+  std::size_t FindHeaderEnd(std::string_view v) {
+    std::size_t pos = HeaderScanner::find_header_end(v.data(), v.size());
+    return pos == v.size() ? std::string_view::npos : pos;
   }
-  // Strip trailing '\r'
-  if (request_line.back() == '\r')
-    request_line.pop_back();
-
-  std::istringstream rl(request_line);
-  std::string version;
-  if (!(rl >> req.method >> req.path >> version)) {
-    ec = make_error_code(std::errc::protocol_error);
+
+  std::string_view TrimSpaces(std::string_view v) {
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t')) v.remove_suffix(1);
+    return v;
+  }
+} // end of namespace
+
+HttpRequest RequestView::materialize(bool with_raw) const {
+  HttpRequest req;
+  req.method.assign(method.data(), method.size());
+  req.path.assign(target.data(), target.size());
+  req.version.assign(version.data(), version.size());
+  req.headers.reserve(headers.size());
+  for (const auto& header : headers) {
+    req.headers.add(std::string(header.name), std::string(header.value));
+  }
+  req.body.assign(body.data(), body.size());
+  if (with_raw) {
+    req.raw.assign(raw.data(), raw.size());
+  }
+  return req;
+}
+
+HttpRequest RequestParser::parse(const char* data, std::size_t len, boost::system::error_code& ec) {
+  RequestView view;
+  if (!parse_view(data, len, view, ec)) {
     return {};
   }
+  return view.materialize();
+}
+
+bool RequestParser::parse_view(const char* data, std::size_t len, RequestView& view,
+                               boost::system::error_code& ec) {
+  ec.clear();
+  view = RequestView();
+  std::string_view raw(data, len);
+  view.raw = raw;
+
+  // Split head & body
+  auto split = FindHeaderEnd(raw);
+  std::string_view head = raw.substr(0, split);
+  if (split != std::string_view::npos) {
+    view.body = raw.substr(split + 4);
+  }
+
+  // Parse the request-line: METHOD SP PATH SP VERSION
+  auto line_end = FindChar(head, '\n');
+  std::string_view request_line = head.substr(0, line_end);
+  if (!request_line.empty() && request_line.back() == '\r')
+    request_line.remove_suffix(1);
+
+  std::string_view* tokens[] = {&view.method, &view.target, &view.version};
+  std::size_t pos = 0;
+  for (std::string_view* token : tokens) {
+    while (pos < request_line.size() && (request_line[pos] == ' ' || request_line[pos] == '\t'))
+      ++pos;
+    std::size_t start = pos;
+    while (pos < request_line.size() && request_line[pos] != ' ' && request_line[pos] != '\t')
+      ++pos;
+    if (pos == start) {
+      ec = boost::system::errc::make_error_code(boost::system::errc::protocol_error);
+      return false;
+    }
+    *token = request_line.substr(start, pos - start);
+  }
 
   // Validate HTTP version token: must start with "HTTP/"; everything else is malformed
-  if (version.rfind("HTTP/", 0) != 0) {
-    ec = make_error_code(std::errc::protocol_error);
-    return {};
+  if (view.version.substr(0, 5) != "HTTP/") {
+    ec = boost::system::errc::make_error_code(boost::system::errc::protocol_error);
+    return false;
   }
 
-  // Parse headers: “Name: Value”
-  std::string line;
-  while (std::getline(lines, line)) {
+  // Parse headers: "Name: Value"
+  while (line_end != std::string_view::npos) {
+    std::size_t line_start = line_end + 1;
+    line_end = FindChar(head, '\n', line_start);
+    std::string_view line = head.substr(line_start, line_end == std::string_view::npos
+                                                      ? std::string_view::npos
+                                                      : line_end - line_start);
     if (!line.empty() && line.back() == '\r')
-      line.pop_back();
+      line.remove_suffix(1);
     if (line.empty())
       break;  // blank line ends headers
 
-    auto colon = line.find(':');
-    if (colon == std::string::npos)
+    auto colon = FindChar(line, ':');
+    if (colon == std::string_view::npos)
       continue;
-    std::string name  = line.substr(0, colon);
-    std::string value = line.substr(colon + 1);
-    if (!value.empty() && value[0] == ' ')
-      value.erase(0,1);
-    req.headers[name] = value;
+    view.headers.push_back({line.substr(0, colon), TrimSpaces(line.substr(colon + 1))});
   }
 
-  return req;
+  return true;
+}
+
+RequestParser::Framing RequestParser::frame(const char* data, std::size_t len,
+                                            std::size_t max_header_bytes,
+                                            std::size_t max_body_bytes,
+                                            std::size_t& request_len) {
+  std::string_view buf(data, len);
+  auto split = FindHeaderEnd(buf);
+  if (split == std::string_view::npos) {
+    return len > max_header_bytes ? Framing::header_too_large : Framing::incomplete;
+  }
+  std::size_t head_len = split + 4;
+  if (head_len > max_header_bytes) {
+    return Framing::header_too_large;
+  }
+
+  // Walk the header lines (skipping the request line) looking for framing headers
+  std::size_t content_length = 0;
+  std::string_view head = buf.substr(0, split);
+  std::size_t line_start = FindChar(head, '\n');
+  while (line_start != std::string_view::npos) {
+    line_start += 1;
+    std::size_t line_end = FindChar(head, '\n', line_start);
+    std::string_view line = head.substr(line_start, line_end == std::string_view::npos
+                                                      ? std::string_view::npos
+                                                      : line_end - line_start);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    auto colon = FindChar(line, ':');
+    if (colon != std::string_view::npos) {
+      std::string_view name = line.substr(0, colon);
+      if (NameEquals(name, "content-length")) {
+        std::string value(TrimSpaces(line.substr(colon + 1)));
+        char* end = nullptr;
+        if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0]))) {
+          return Framing::malformed;
+        }
+        unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+        if (*end != '\0') {
+          return Framing::malformed;
+        }
+        if (parsed > max_body_bytes) {
+          return Framing::body_too_large;
+        }
+        content_length = static_cast<std::size_t>(parsed);
+      } else if (NameEquals(name, "transfer-encoding")) {
+        return Framing::unsupported;
+      }
+    }
+    line_start = line_end;
+  }
+
+  if (len - head_len < content_length) {
+    return Framing::incomplete;
+  }
+  request_len = head_len + content_length;
+  return Framing::complete;
 }
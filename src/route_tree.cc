@@ -0,0 +1,136 @@
+#include "route_tree.h"
+#include <algorithm>
+
+namespace {
+  // Split the next segment off `rest`, skipping leading slashes.
+  std::string_view NextSegment(std::string_view& rest) {
+    std::size_t start = rest.find_first_not_of('/');
+    if (start == std::string_view::npos) {
+      rest = std::string_view();
+      return rest;
+    }
+    std::size_t end = rest.find('/', start);
+    if (end == std::string_view::npos) {
+      end = rest.size();
+    }
+    std::string_view segment = rest.substr(start, end - start);
+    rest.remove_prefix(end);
+    return segment;
+  }
+} // end of namespace
+
+std::vector<std::unique_ptr<RouteTree::Node>>::const_iterator
+RouteTree::Node::find_child(std::string_view segment) const {
+  return std::lower_bound(children.begin(), children.end(), segment,
+      [](const std::unique_ptr<Node>& child, std::string_view s) { return child->segment < s; });
+}
+
+std::vector<std::unique_ptr<RouteTree::Node>>::iterator
+RouteTree::Node::find_child(std::string_view segment) {
+  return std::lower_bound(children.begin(), children.end(), segment,
+      [](const std::unique_ptr<Node>& child, std::string_view s) { return child->segment < s; });
+}
+
+std::size_t RouteTree::Node::value_for(std::string_view method) const {
+  std::size_t any = npos;
+  for (const auto& entry : values) {
+    if (entry.first == method) {
+      return entry.second;
+    }
+    if (entry.first.empty()) {
+      any = entry.second;
+    }
+  }
+  return any;
+}
+
+std::size_t RouteTree::insert(std::string_view pattern, std::string_view method, std::size_t value) {
+  Node* node = &root_;
+  std::string_view rest = pattern;
+  for (std::string_view segment = NextSegment(rest); !segment.empty(); segment = NextSegment(rest)) {
+    if (segment.front() == ':') {
+      segment.remove_prefix(1);
+      if (!node->capture) {
+        node->capture = std::make_unique<Node>();
+      }
+      // One capture child per level; a later pattern's name replaces the earlier one
+      node->capture->segment = std::string(segment);
+      node = node->capture.get();
+      continue;
+    }
+    auto it = node->find_child(segment);
+    if (it == node->children.end() || (*it)->segment != segment) {
+      it = node->children.insert(it, std::make_unique<Node>());
+      (*it)->segment = std::string(segment);
+    }
+    node = it->get();
+  }
+
+  for (auto& entry : node->values) {
+    if (entry.first == method) {
+      std::size_t previous = entry.second;
+      entry.second = value;
+      return previous;
+    }
+  }
+  node->values.emplace_back(std::string(method), value);
+  return npos;
+}
+
+std::size_t RouteTree::match(std::string_view path, std::string_view method, Params* params,
+                             std::vector<std::string>* allowed) const {
+  std::size_t query = path.find('?');
+  if (query != std::string_view::npos) {
+    path = path.substr(0, query);
+  }
+
+  Best best;
+  Params captured;
+  walk(root_, path, 0, method, captured, best);
+  if (best.deepest_depth > best.depth) {
+    // The path names a location that does not take this method
+    if (allowed) {
+      allowed->clear();
+      for (const auto& entry : best.deepest->values) {
+        allowed->push_back(entry.first);
+      }
+    }
+    if (params) {
+      params->clear();
+    }
+    return npos;
+  }
+  if (params) {
+    *params = std::move(best.params);
+  }
+  return best.value;
+}
+
+void RouteTree::walk(const Node& node, std::string_view rest, int depth,
+                     std::string_view method, Params& captured, Best& best) {
+  if (!node.values.empty() && depth > best.deepest_depth) {
+    best.deepest = &node;
+    best.deepest_depth = depth;
+  }
+  std::size_t value = node.value_for(method);
+  if (value != npos && depth > best.depth) {
+    best.value = value;
+    best.depth = depth;
+    best.params = captured;
+  }
+
+  std::string_view segment = NextSegment(rest);
+  if (segment.empty()) {
+    return;
+  }
+  auto it = node.find_child(segment);
+  if (it != node.children.end() && (*it)->segment == segment) {
+    walk(**it, rest, depth + 1, method, captured, best);
+  }
+  // Literal matches win ties, so a capture only takes over if it goes deeper
+  if (node.capture) {
+    captured.emplace_back(node.capture->segment, segment);
+    walk(*node.capture, rest, depth + 1, method, captured, best);
+    captured.pop_back();
+  }
+}
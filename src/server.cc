@@ -2,46 +2,102 @@
 #include <iostream>
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
+#include <boost/log/trivial.hpp>
 
 using boost::asio::ip::tcp;
 
 #include "server.h"
 #include "session.h"
-#include <thread>
 
-void server::join_pool() {
-  thread_pool_.join();
-}
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
+namespace {
+#ifdef SO_REUSEPORT
+  using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+} // end of namespace
 
-server::server(boost::asio::io_service& io_service, short port)
+server::server(boost::asio::io_service& io_service, short port,
+               const ServerConfig& config)
   : io_service_(io_service),
-    acceptor_(io_service, tcp::endpoint(tcp::v4(), port))
+    config_(std::make_shared<const ServerConfig>(config))
 {
+  open_acceptor(io_service, port, false);
   start_accept();
 }
 
-void server::start_accept()
+server::server(IoContextPool& pool, short port, const ServerConfig& config)
+  : io_service_(pool.context(0)),
+    pool_(&pool),
+    config_(std::make_shared<const ServerConfig>(config))
+{
+#ifdef SO_REUSEPORT
+  if (config_->reuse_port) {
+    // Bind the first acceptor, then the rest to the same port (which matters
+    // when `port` is 0 and the kernel picks one)
+    open_acceptor(pool.context(0), port, true);
+    unsigned short bound = acceptors_.front()->local_endpoint().port();
+    for (std::size_t i = 1; i < pool.threads(); ++i) {
+      open_acceptor(pool.context(i % pool.contexts()), bound, true);
+    }
+    BOOST_LOG_TRIVIAL(info) << "Listening with " << acceptors_.size() << " SO_REUSEPORT acceptors";
+  }
+#else
+  if (config_->reuse_port) {
+    BOOST_LOG_TRIVIAL(warning) << "SO_REUSEPORT is not available; using a single acceptor";
+  }
+#endif
+  if (acceptors_.empty()) {
+    open_acceptor(pool.context(0), port, false);
+  }
+  for (std::size_t i = 0; i < acceptors_.size(); ++i) {
+    start_accept(i);
+  }
+}
+
+void server::open_acceptor(boost::asio::io_service& io_service, unsigned short port, bool reuse_port)
 {
-  session* new_session = new session(io_service_);
-  acceptor_.async_accept(new_session->socket(),
+  tcp::endpoint endpoint(tcp::v4(), port);
+  auto acceptor = std::make_unique<tcp::acceptor>(io_service);
+  acceptor->open(endpoint.protocol());
+  acceptor->set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+  if (reuse_port) {
+    acceptor->set_option(reuse_port_option(true));
+  }
+#endif
+  acceptor->bind(endpoint);
+  acceptor->listen();
+  acceptors_.push_back(std::move(acceptor));
+  acceptor_contexts_.push_back(&io_service);
+}
+
+unsigned short server::port() const
+{
+  return acceptors_.front()->local_endpoint().port();
+}
+
+void server::start_accept(std::size_t acceptor)
+{
+  // The session's socket belongs to the context that will run it: the
+  // acceptor's own context with per-thread acceptors, else the pool's next one
+  boost::asio::io_service& target = (pool_ && acceptors_.size() == 1)
+      ? pool_->next() : *acceptor_contexts_[acceptor];
+  auto new_session = std::make_shared<session>(target, config_);
+  acceptors_[acceptor]->async_accept(new_session->socket(),
       boost::bind(&server::handle_accept, this, new_session,
-        boost::asio::placeholders::error));
+        boost::asio::placeholders::error, acceptor));
 }
 
-void server::handle_accept(session* new_session,
-    const boost::system::error_code& error)
+void server::handle_accept(std::shared_ptr<session> new_session,
+    const boost::system::error_code& error, std::size_t acceptor)
 {
   if (!error)
   {
-    boost::asio::post(thread_pool_, [new_session]() {
-      new_session->start();
-    });
-  }
-  else
-  {
-    delete new_session;
+    new_session->start();
   }
 
-  start_accept();
+  start_accept(acceptor);
 }
-  
\ No newline at end of file
@@ -12,11 +12,16 @@
 #include <iostream>
 #include <boost/asio.hpp>
 #include <boost/log/trivial.hpp>
+#include <functional>
 #include <map>
 
+#include "access_log.h"
+#include "io_context_pool.h"
 #include "server.h"
 #include "config_parser.h"
 #include "logger.h"
+#include "mime_types.h"
+#include "static_file_cache.h"
 using HandlerPtr = std::shared_ptr<RequestHandler>;
 
 int main(int argc, char* argv[])
@@ -32,25 +37,45 @@ int main(int argc, char* argv[])
       return 1;
     }
 
-    boost::asio::io_service io_service;
-    
     //parse argument as config file
     int port;
-    parseConfig(argv[1], port);
-    //   return 1;
-    // }
+    ServerConfig server_config;
+    if (!parseConfig(argv[1], port, server_config))
+    {
+      BOOST_LOG_TRIVIAL(fatal) << "Invalid config file " << argv[1];
+      return 1;
+    }
 
-    server srv(io_service, port);
-    BOOST_LOG_TRIVIAL(info) << "Server listening on port " << port;
+    init_logging(server_config.log);
 
-    std::vector<std::thread> workers;
-    for (int i = 0; i < 4; ++i) {
-    workers.emplace_back([&io_service]() {
-    io_service.run();
-    });
+    for (const auto& [extension, type] : server_config.mime_types) {
+      MimeTypes::instance().add(extension, type);
     }
+    StaticFileCache::instance().set_mmap_limit(server_config.static_mmap_max_size);
+    StaticFileCache::instance().set_capacity(server_config.static_cache_size);
+    if (!server_config.access_log_dir.empty()) {
+      AccessLog::instance().open(server_config.access_log_dir, server_config.access_log_segment_size);
+    }
+
+    IoContextPool pool(server_config.threads, server_config.io_model);
+    server srv(pool, port, server_config);
+    BOOST_LOG_TRIVIAL(info) << "Server listening on port " << port;
+
+    // SIGUSR1 switches between the configured log level and trace
+    boost::asio::signal_set usr1(pool.context(0), SIGUSR1);
+    std::function<void(const boost::system::error_code&, int)> on_usr1 =
+      [&](const boost::system::error_code& ec, int) {
+        if (ec) {
+          return;
+        }
+        auto trace = boost::log::trivial::trace;
+        set_log_level(log_level() == trace ? server_config.log.level : trace);
+        BOOST_LOG_TRIVIAL(warning) << "SIGUSR1: log level is now " << log_level();
+        usr1.async_wait(on_usr1);
+      };
+    usr1.async_wait(on_usr1);
 
-    for (auto& t : workers) t.join();
+    pool.run();
   }
   catch (std::exception& e)
   {
@@ -58,5 +83,7 @@ int main(int argc, char* argv[])
   }
 
   BOOST_LOG_TRIVIAL(info) << "Server shutting down.";
+  AccessLog::instance().close();
+  shutdown_logging();
   return 0;
 }
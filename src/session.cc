@@ -1,9 +1,14 @@
+#include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <sys/sendfile.h>
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/log/trivial.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 #include "dispatcher.h"
 
 using boost::asio::ip::tcp;
@@ -11,13 +16,96 @@ using boost::asio::ip::tcp;
 namespace http = boost::beast::http;
 
 #include "session.h"
+#include "access_log.h"
+#include "metrics.h"
+#include "logger.h"
 #include "echo_handler.h"
 
-session::session(boost::asio::io_service& io_service)
-  : socket_(io_service)
+namespace {
+  // Read buffers are recycled per thread so accepting a connection does not
+  // allocate; buffers that grew for a large request are dropped instead.
+  constexpr std::size_t kMaxPooledBuffers = 64;
+  constexpr std::size_t kMaxPooledCapacity = 64 * 1024;
+  thread_local std::vector<std::vector<char>> buffer_pool;
+
+  const std::shared_ptr<const ServerConfig>& DefaultConfig() {
+    static const auto config = std::make_shared<const ServerConfig>();
+    return config;
+  }
+
+  std::vector<char> AcquireBuffer() {
+    if (buffer_pool.empty()) {
+      return {};
+    }
+    std::vector<char> buf = std::move(buffer_pool.back());
+    buffer_pool.pop_back();
+    return buf;
+  }
+
+  void ReleaseBuffer(std::vector<char>&& buf) {
+    if (buf.capacity() == 0 || buf.capacity() > kMaxPooledCapacity ||
+        buffer_pool.size() >= kMaxPooledBuffers) {
+      return;
+    }
+    buffer_pool.push_back(std::move(buf));
+  }
+
+  // Statuses that must not carry a body or Content-Length
+  bool IsBodyless(int status_code) {
+    return status_code < 200 || status_code == 204 || status_code == 304;
+  }
+
+  // Serialize the status line and headers. Content-Length and Connection are
+  // owned by the session, so any values a handler set for them are replaced.
+  std::string SerializeHead(const HttpResponse& res, std::size_t body_size, bool close) {
+    std::string head;
+    head.reserve(128 + res.headers.size() * 48);
+    head += "HTTP/1.1 ";
+    head += std::to_string(res.status_code);
+    head += ' ';
+    auto reason = http::obsolete_reason(http::int_to_status(res.status_code));
+    head.append(reason.data(), reason.size());
+    head += "\r\n";
+    for (std::size_t i = 0; i < res.headers.size(); ++i) {
+      HeaderId id = res.headers.id_at(i);
+      if (id == HeaderId::content_length || id == HeaderId::connection) {
+        continue;
+      }
+      const auto& header = *(res.headers.begin() + i);
+      head += header.first;
+      head += ": ";
+      head += header.second;
+      head += "\r\n";
+    }
+    if (!IsBodyless(res.status_code)) {
+      head += "Content-Length: ";
+      head += std::to_string(body_size);
+      head += "\r\n";
+    }
+    if (close) {
+      head += "Connection: close\r\n";
+    }
+    head += "\r\n";
+    return head;
+  }
+} // end of namespace
+
+session::session(boost::asio::io_service& io_service, std::shared_ptr<const ServerConfig> config)
+  : socket_(boost::asio::make_strand(io_service)),
+    idle_timer_(socket_.get_executor()),
+    config_(config ? std::move(config) : DefaultConfig()),
+    buffer_(AcquireBuffer())
 {
 }
 
+session::~session()
+{
+  if (started_) {
+    Metrics::instance().connection_closed();
+  }
+  ReleaseBuffer(std::move(buffer_));
+}
+
 tcp::socket& session::socket()
 {
   return socket_;
@@ -25,82 +113,469 @@ tcp::socket& session::socket()
 
 void session::start()
 {
-  socket_.async_read_some(boost::asio::buffer(data_, max_length),
-      boost::bind(&session::handle_read, this,
+  started_ = true;
+  accepted_ = RequestTiming::Clock::now();
+  Metrics::instance().connection_opened();
+  // Run on the connection's strand like every later completion handler
+  boost::asio::dispatch(socket_.get_executor(),
+      boost::bind(&session::process_buffer, shared_from_this()));
+}
+
+void session::do_read()
+{
+  // Grow geometrically; the framing caps bound how large this can get.
+  if (buffer_.size() - filled_ < read_chunk) {
+    buffer_.resize(std::max(buffer_.size() * 2, filled_ + read_chunk));
+  }
+  read_pending_ = true;
+  socket_.async_read_some(
+      boost::asio::buffer(buffer_.data() + filled_, buffer_.size() - filled_),
+      boost::bind(&session::handle_read, shared_from_this(),
         boost::asio::placeholders::error,
         boost::asio::placeholders::bytes_transferred));
 }
 
+void session::handle_idle_timeout(const boost::system::error_code& ec)
+{
+  if (ec == boost::asio::error::operation_aborted || !awaiting_request_) {
+    return;  // timer was re-armed or cancelled because a request arrived
+  }
+  BOOST_LOG_TRIVIAL(debug) << "Closing idle connection after "
+                           << requests_parsed_ << " request(s)";
+  close();
+}
+
+void session::close()
+{
+  boost::system::error_code ignored;
+  closing_ = true;
+  idle_timer_.cancel();
+  socket_.shutdown(tcp::socket::shutdown_both, ignored);
+  socket_.close(ignored);
+}
+
+bool session::wants_keep_alive(const HttpRequest& req)
+{
+  auto it = req.headers.find(HeaderId::connection);
+  if (it != req.headers.end()) {
+    if (boost::iequals(it->second, "close")) return false;
+    if (boost::iequals(it->second, "keep-alive")) return true;
+  }
+  return req.version != "HTTP/1.0";
+}
+
 void session::handle_read(const boost::system::error_code& ec,
     size_t bytes_transferred)
 {
+  read_pending_ = false;
+
+  if (ec == boost::asio::error::eof) {
+    // The client half-closed; answer what it already sent, then hang up
+    if (outbox_.empty()) {
+      close();
+    } else {
+      outbox_.back().close_after = true;
+      closing_ = true;
+    }
+    return;
+  }
   if (ec) {
-    BOOST_LOG_TRIVIAL(warning) << "Read error: " << ec.message();
-    delete this;
+    if (ec != boost::asio::error::operation_aborted) {
+      BOOST_LOG_TRIVIAL(warning) << "Read error: " << ec.message();
+    }
+    close();
     return;
   }
 
-  boost::system::error_code parse_ec;
-  auto req = parser_.parse(data_, bytes_transferred, parse_ec);
+  last_read_ = RequestTiming::Clock::now();
+  if (filled_ == 0) {
+    first_byte_ = last_read_;
+  }
+  filled_ += bytes_transferred;
+  process_buffer();
+}
+
+void session::process_buffer()
+{
+  // Dispatch every complete request already buffered, up to the in-flight cap
+  std::size_t offset = 0;
+  bool need_more = false;
+  while (!closing_ && outbox_.size() < config_->max_pipelined_requests) {
+    std::size_t request_len = 0;
+    auto framing = RequestParser::frame(buffer_.data() + offset, filled_ - offset,
+                                        config_->max_header_size,
+                                        config_->max_body_size, request_len);
+    if (framing == RequestParser::Framing::incomplete) {
+      need_more = true;
+      break;
+    }
+    if (framing == RequestParser::Framing::header_too_large) {
+      reject(431, "Request Header Fields Too Large", offset);
+    } else if (framing == RequestParser::Framing::body_too_large) {
+      reject(413, "Payload Too Large", offset);
+    } else if (framing == RequestParser::Framing::unsupported) {
+      reject(501, "Not Implemented", offset);
+    } else if (framing == RequestParser::Framing::malformed) {
+      reject(400, "Bad Request", offset);
+    } else {
+      awaiting_request_ = false;
+      idle_timer_.cancel();
+      outbox_.emplace_back();
+      stamp_arrival(outbox_.back().timing);
+      handle_request(buffer_.data() + offset, request_len, outbox_.back());
+      offset += request_len;
+      first_byte_ = last_read_;  // any following bytes came with the latest read
+      continue;
+    }
+    break;
+  }
+
+  // Keep any bytes of a following request for the next pass
+  if (offset > 0) {
+    std::copy(buffer_.begin() + offset, buffer_.begin() + filled_, buffer_.begin());
+    filled_ -= offset;
+  }
+
+  flush();
+
+  if (closing_ || !need_more) {
+    return;  // closing, or backpressured until queued responses drain
+  }
+  if (outbox_.empty() && !awaiting_request_) {
+    // Nothing in flight: bound the time the whole next request may take to
+    // arrive. The timer closes the socket, which aborts the pending read.
+    awaiting_request_ = true;
+    idle_timer_.expires_after(std::chrono::seconds(config_->keepalive_timeout));
+    idle_timer_.async_wait(
+        boost::bind(&session::handle_idle_timeout, shared_from_this(),
+          boost::asio::placeholders::error));
+  }
+  if (!read_pending_) {
+    do_read();
+  }
+}
+
+void session::reject(int status_code, const std::string& reason, std::size_t offset)
+{
+  awaiting_request_ = false;
+  idle_timer_.cancel();
+  BOOST_LOG_TRIVIAL(warning) << "Rejecting request with " << status_code << ": " << reason;
+
+  // The rest of the request is unread, so the connection cannot be reused
+  closing_ = true;
+  outbox_.emplace_back();
+  outbox_.back().close_after = true;
+  stamp_arrival(outbox_.back().timing);
+  outbox_.back().bytes_in = filled_ - offset;  // earlier requests counted their own
+  filled_ = offset;  // the requests before it were dispatched; drop the rest
+
+  auto app_res = std::make_unique<HttpResponse>();
+  app_res->status_code = status_code;
+  app_res->headers["Content-Type"] = "text/plain";
+  app_res->body = reason;
+  HttpRequest req;
+  req.client_ip = "unknown";
+  finish_response(outbox_.back(), std::move(app_res), req, "None");
+}
+
+// Marks when the request's bytes arrived; only a connection's first request
+// also carries the accept time
+void session::stamp_arrival(RequestTiming& timing)
+{
+  if (accepted_ != RequestTiming::Clock::time_point()) {
+    timing.set(RequestTiming::kAccepted, accepted_);
+    accepted_ = RequestTiming::Clock::time_point();
+  }
+  if (first_byte_ != RequestTiming::Clock::time_point()) {
+    timing.set(RequestTiming::kFirstByte, first_byte_);
+  }
+  timing.mark(RequestTiming::kReceived);
+}
 
-  try {
-    auto client_ip = socket_.remote_endpoint().address().to_string();
-    auto client_port = socket_.remote_endpoint().port();
-    BOOST_LOG_TRIVIAL(info) << "Received request from " << client_ip << ":" << client_port;
-    req.client_ip = client_ip;
-  } catch (std::exception& e) {
-    BOOST_LOG_TRIVIAL(warning) << "Could not retrieve client address: " << e.what();
-    req.client_ip = "unknown";
+void session::handle_request(const char* data, std::size_t len, Outgoing& slot)
+{
+  ++requests_parsed_;
+  slot.log_sampled = sample_request_log();
+  slot.bytes_in = len;
+
+  // The peer cannot change, so one lookup serves every request on the connection
+  if (!remote_known_) {
+    boost::system::error_code ec;
+    remote_ = socket_.remote_endpoint(ec);
+    if (ec) {
+      BOOST_LOG_TRIVIAL(warning) << "Could not retrieve client address: " << ec.message();
+    }
+    remote_known_ = !ec;
   }
+  std::string client_ip = remote_known_ ? remote_.address().to_string() : "unknown";
+  if (remote_known_ && slot.log_sampled) {
+    BOOST_LOG_TRIVIAL(info) << "Received request from " << client_ip << ":" << remote_.port();
+  }
+
+  // The parse stage starts here, so it measures only the parser
+  slot.timing.mark(RequestTiming::kParseStart);
+  boost::system::error_code parse_ec;
+  RequestView view;
+  bool parsed = parser_.parse_view(data, len, view, parse_ec);
+  slot.timing.mark(RequestTiming::kParsed);
 
   std::unique_ptr<HttpResponse> app_res;
-  std::string handler_name = "None";
-  if (parse_ec) {
+  if (!parsed) {
     BOOST_LOG_TRIVIAL(error) << "Failed to parse HTTP request: " << parse_ec.message();
     app_res = std::make_unique<HttpResponse>();
     app_res->status_code = 400;
     app_res->headers["Content-Type"] = "text/plain";
     app_res->body = "Bad Request";
-  } else {
-    BOOST_LOG_TRIVIAL(debug) << "Parsed request, routing...";
-    auto handler = Dispatcher::match(req.path);
-    handler_name = handler->get_kName();
-    app_res = handler->handle_request(req);
+    slot.close_after = true;  // framing is unknown, so the connection cannot be reused
+    closing_ = true;
+    HttpRequest req;
+    req.client_ip = std::move(client_ip);
+    finish_response(slot, std::move(app_res), req, "None");
+    return;
   }
 
-  // Build Beast response
-  response.result((http::status)app_res->status_code);
-  response.body() = std::move(app_res->body);
-  
-  // Set all headers from the response
-  for (const auto& header : app_res->headers) {
-    response.set(header.first, header.second);
+  BOOST_LOG_TRIVIAL(debug) << "Parsed request, routing...";
+  RouteTree::Params params;
+  std::vector<std::string> allowed;  // set when the location exists but not for this method
+  RequestHandler* handler = Dispatcher::match(view.target, view.method, &params, &allowed,
+                                              &slot.route);
+
+  // Routed on the view; only now is the request copied out of the read
+  // buffer, since an asynchronous handler may outlive it. Shared so that such
+  // a handler can keep using it until it answers. The raw bytes are copied
+  // only for the handlers that read them.
+  auto req = std::make_shared<HttpRequest>(
+      view.materialize(handler && handler->needs_raw_request()));
+  req->client_ip = std::move(client_ip);
+  for (const auto& param : params) {
+    req->path_params.emplace(std::string(param.first), std::string(param.second));
   }
-  
-  response.prepare_payload();
+  slot.timing.mark(RequestTiming::kRouted);
+
+  slot.close_after = !wants_keep_alive(*req) ||
+                     requests_parsed_ >= config_->keepalive_requests;
+  if (slot.close_after) {
+    closing_ = true;
+  }
+
+  if (!handler) {
+    app_res = std::make_unique<HttpResponse>();
+    app_res->headers["Content-Type"] = "text/plain";
+    if (allowed.empty()) {
+      app_res->status_code = 404;
+      app_res->body = "Not Found";
+    } else {
+      app_res->status_code = 405;
+      app_res->headers["Allow"] = boost::algorithm::join(allowed, ", ");
+      app_res->body = "Method Not Allowed";
+    }
+    finish_response(slot, std::move(app_res), *req, "None");
+    return;
+  }
+
+  // The response may arrive later and on another thread; hop back onto the
+  // connection's strand before touching the outbox. Handlers that answer
+  // inline complete immediately, since dispatch runs in place on the strand.
+  auto self = shared_from_this();
+  std::string handler_name = handler->get_kName();
+  slot.timing.mark(RequestTiming::kHandlerStart);
+  handler->handle_request_async(*req, socket_.get_executor(),
+      [this, self, req, &slot, handler_name](std::unique_ptr<HttpResponse> res) {
+        auto handler_end = RequestTiming::Clock::now();
+        boost::asio::dispatch(socket_.get_executor(),
+            [this, self, req, &slot, handler_name, handler_end, res = std::move(res)]() mutable {
+              slot.timing.set(RequestTiming::kHandlerEnd, handler_end);
+              finish_response(slot, std::move(res), *req, handler_name);
+              if (slot.deferred) {
+                flush();
+              }
+            });
+      });
+  if (!slot.ready) {
+    slot.deferred = true;  // flushed by the completion above
+  }
+}
+
+void session::finish_response(Outgoing& slot,
+                              std::unique_ptr<HttpResponse> app_res,
+                              const HttpRequest& req,
+                              const std::string& handler_name)
+{
+  std::size_t body_size = 0;
+  if (!IsBodyless(app_res->status_code)) {
+    if (app_res->file) {
+      slot.file = std::move(app_res->file);
+      body_size = slot.file->size();
+    } else if (app_res->shared_body) {
+      slot.shared_body = std::move(app_res->shared_body);
+      body_size = slot.shared_body.size();
+    } else {
+      slot.body = std::move(app_res->body);
+      body_size = slot.body.size();
+    }
+  }
+  slot.timing.mark(RequestTiming::kReady);
+  slot.handler = handler_name;
+  if (config_->server_timing) {
+    app_res->headers.add("Server-Timing", slot.timing.server_timing());
+  }
+  slot.head = SerializeHead(*app_res, body_size, slot.close_after);
+  slot.ready = true;
 
   BOOST_LOG_TRIVIAL(debug) << "Sending response with status code: " << app_res->status_code;
 
-  BOOST_LOG_TRIVIAL(info)
-      << "[ResponseMetrics]"
-      << " code="   << app_res->status_code
-      << " path="   << req.path
-      << " client=" << req.client_ip
-      << " handler="<< handler_name;
+  // Sampled with the request, but error responses are always logged
+  if (slot.log_sampled || app_res->status_code >= 400) {
+    BOOST_LOG_TRIVIAL(info)
+        << "[ResponseMetrics]"
+        << " code="   << app_res->status_code
+        << " path="   << req.path
+        << " client=" << req.client_ip
+        << " handler="<< handler_name;
+  }
+
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      slot.timing.at(RequestTiming::kReady) - slot.timing.at(RequestTiming::kReceived));
+  std::uint64_t bytes_out = slot.head.size() + body_size;
+  Metrics::instance().record_request(handler_name, slot.route, app_res->status_code, latency,
+                                     slot.bytes_in, bytes_out);
 
-  http::async_write(socket_, response,
-    boost::bind(&session::handle_write, this,
-                boost::asio::placeholders::error));
+  AccessLog& access_log = AccessLog::instance();
+  if (access_log.enabled()) {
+    AccessLog::Request entry;
+    entry.time = std::chrono::system_clock::now();
+    entry.latency = latency;
+    entry.status = app_res->status_code;
+    entry.bytes_in = slot.bytes_in;
+    entry.bytes_out = bytes_out;
+    if (remote_known_) {
+      entry.client = remote_.address();
+      entry.client_port = remote_.port();
+    }
+    entry.method = req.method;
+    entry.path = req.path;
+    entry.handler = handler_name;
+    access_log.record(entry);
+  }
 }
 
-void session::handle_write(const boost::system::error_code& ec)
+void session::flush()
 {
-  if (!ec) {
-    BOOST_LOG_TRIVIAL(info) << "Successfully sent response to client.";
-    socket_.shutdown(tcp::socket::shutdown_both);
-  } else {
+  if (write_pending_ || !socket_.is_open()) {
+    return;
+  }
+
+  // Gather every consecutive ready response into a single write
+  write_buffers_.clear();
+  std::size_t responses = 0;
+  for (const auto& out : outbox_) {
+    if (!out.ready) {
+      break;
+    }
+    write_buffers_.push_back(boost::asio::buffer(out.head));
+    if (out.shared_body) {
+      write_buffers_.push_back(boost::asio::buffer(out.shared_body.data(), out.shared_body.size()));
+    } else if (!out.body.empty()) {
+      write_buffers_.push_back(boost::asio::buffer(out.body));
+    }
+    ++responses;
+    // A file body goes out after this write; later responses must wait for it
+    if (out.close_after || out.file) {
+      break;
+    }
+  }
+  if (responses == 0) {
+    return;
+  }
+
+  write_pending_ = true;
+  boost::asio::async_write(socket_, write_buffers_,
+    boost::bind(&session::handle_write, shared_from_this(),
+                boost::asio::placeholders::error, responses));
+}
+
+void session::handle_write(const boost::system::error_code& ec, std::size_t responses)
+{
+  write_pending_ = false;
+  if (ec) {
     BOOST_LOG_TRIVIAL(warning) << "Write error: " << ec.message();
+    close();
+    return;
+  }
+
+  if (outbox_[responses - 1].file) {
+    send_file(responses);
+    return;
+  }
+  complete_write(responses);
+}
+
+void session::send_file(std::size_t responses)
+{
+  Outgoing& out = outbox_[responses - 1];
+  socket_.native_non_blocking(true);
+  while (out.file_sent < out.file->size()) {
+    off_t offset = static_cast<off_t>(out.file->offset() + out.file_sent);
+    std::size_t remaining = static_cast<std::size_t>(out.file->size() - out.file_sent);
+    ssize_t n = ::sendfile(socket_.native_handle(), out.file->fd(), &offset, remaining);
+    if (n > 0) {
+      out.file_sent += static_cast<std::uint64_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Socket buffer is full; resume once it drains
+      write_pending_ = true;
+      socket_.async_wait(tcp::socket::wait_write,
+        boost::bind(&session::handle_file_writable, shared_from_this(),
+                    boost::asio::placeholders::error, responses));
+      return;
+    }
+    // n == 0 means the file shrank under us; either way the response is cut short
+    BOOST_LOG_TRIVIAL(warning) << "sendfile failed after " << out.file_sent << " of "
+                               << out.file->size() << " bytes: "
+                               << (n < 0 ? std::strerror(errno) : "unexpected end of file");
+    close();
+    return;
+  }
+  complete_write(responses);
+}
+
+void session::handle_file_writable(const boost::system::error_code& ec, std::size_t responses)
+{
+  write_pending_ = false;
+  if (ec) {
+    if (ec != boost::asio::error::operation_aborted) {
+      BOOST_LOG_TRIVIAL(warning) << "Write error: " << ec.message();
+    }
+    close();
+    return;
   }
+  send_file(responses);
+}
 
-  delete this;
+void session::complete_write(std::size_t responses)
+{
+  bool close_now = false;
+  bool log_sampled = false;
+  auto written = RequestTiming::Clock::now();
+  for (std::size_t i = 0; i < responses; ++i) {
+    Outgoing& out = outbox_.front();
+    close_now = close_now || out.close_after;
+    log_sampled = log_sampled || out.log_sampled;
+    out.timing.set(RequestTiming::kWritten, written);
+    Metrics::instance().record_stages(out.handler, out.route, out.timing);
+    outbox_.pop_front();
+  }
+  if (log_sampled) {
+    BOOST_LOG_TRIVIAL(info) << "Successfully sent " << responses << " response(s) to client.";
+  }
+
+  if (close_now) {
+    close();
+    return;
+  }
+  process_buffer();
 }
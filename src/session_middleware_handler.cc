@@ -47,7 +47,7 @@ std::unique_ptr<HttpResponse> SessionMiddlewareHandler::handle_request(const Htt
 
 std::optional<std::string> SessionMiddlewareHandler::extract_session_token(const HttpRequest& request) {
     // get from cookie header
-    auto cookie_it = request.headers.find("Cookie");
+    auto cookie_it = request.headers.find(HeaderId::cookie);
     if (cookie_it != request.headers.end()) {
         std::smatch matches;
         if (std::regex_search(cookie_it->second, matches, session_cookie_regex)) {
@@ -56,7 +56,7 @@ std::optional<std::string> SessionMiddlewareHandler::extract_session_token(const
     }
 
     // then get from authorization header
-    auto auth_it = request.headers.find("Authorization");
+    auto auth_it = request.headers.find(HeaderId::authorization);
     if (auth_it != request.headers.end()) {
         // check if it's a Bearer token
         if (auth_it->second.substr(0, 7) == "Bearer ") {
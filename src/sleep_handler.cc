@@ -3,14 +3,30 @@
 #include "handler_registry.h"
 #include <thread>
 #include <chrono>
-#include <thread>
+#include <charconv>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/log/trivial.hpp>
 
 const std::string SleepHandler::kName = "SleepHandler";
 
-std::unique_ptr<HttpResponse> SleepHandler::handle_request(const HttpRequest& req) {
-    BOOST_LOG_TRIVIAL(info) << "Handling /sleep in thread " << std::this_thread::get_id();
-  std::this_thread::sleep_for(std::chrono::seconds(3));  // Delay
+namespace {
+  // Parse "delay_ms N;" as a non-negative decimal count of milliseconds
+  bool ParseDelay(const std::string& text, std::chrono::milliseconds& out) {
+    long long value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || text[0] == '-' || ec != std::errc() || end != text.data() + text.size()) {
+      BOOST_LOG_TRIVIAL(error) << "Invalid delay_ms: " << text
+                               << " (expected a non-negative integer)";
+      return false;
+    }
+    out = std::chrono::milliseconds(value);
+    return true;
+  }
+} // end of namespace
+
+SleepHandler::SleepHandler(std::chrono::milliseconds delay) : delay_(delay) {}
+
+std::unique_ptr<HttpResponse> SleepHandler::make_response() {
   auto res = std::make_unique<HttpResponse>();
   res->status_code = 200;
   res->body = "Slept";
@@ -19,12 +35,37 @@ std::unique_ptr<HttpResponse> SleepHandler::handle_request(const HttpRequest& re
   return res;
 }
 
+std::unique_ptr<HttpResponse> SleepHandler::handle_request(const HttpRequest& req) {
+    BOOST_LOG_TRIVIAL(info) << "Handling /sleep in thread " << std::this_thread::get_id();
+  std::this_thread::sleep_for(delay_);  // Delay
+  return make_response();
+}
+
+void SleepHandler::handle_request_async(const HttpRequest& req,
+                                        boost::asio::any_io_executor executor,
+                                        ResponseCallback done) {
+  BOOST_LOG_TRIVIAL(debug) << "Arming " << delay_.count() << "ms timer for /sleep";
+  // The timer owns itself through the completion handler
+  auto timer = std::make_shared<boost::asio::steady_timer>(executor, delay_);
+  timer->async_wait([timer, done = std::move(done)](const boost::system::error_code&) {
+    done(make_response());
+  });
+}
+
 // LCOV_EXCL_START
 static const bool sleepRegistered =
   HandlerRegistry::instance()
     .registerHandler(
       SleepHandler::kName,
-      [](auto const& args) {
+      [](auto const& args) -> HandlerRegistry::HandlerPtr {
+        // optional "delay_ms N;" in the location block
+        if (args.size() > 1) {
+          std::chrono::milliseconds delay;
+          if (!ParseDelay(args.at(1), delay)) {
+            return nullptr;
+          }
+          return std::make_unique<SleepHandler>(delay);
+        }
         return std::make_unique<SleepHandler>();
       });
 // LCOV_EXCL_STOP
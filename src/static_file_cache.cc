@@ -0,0 +1,509 @@
+#include "static_file_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <boost/log/trivial.hpp>
+
+namespace {
+  constexpr std::uint32_t kWatchMask =
+      IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+      IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+  // Directory part of `path` as inotify will report it back
+  std::string DirectoryOf(const std::string& path) {
+    auto slash = path.rfind('/');
+    if (slash == std::string::npos) return ".";
+    if (slash == 0) return "/";
+    return path.substr(0, slash);
+  }
+
+  bool SameFile(const struct stat& a, const struct stat& b) {
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino && a.st_size == b.st_size &&
+           a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+  }
+
+  // Read `size` bytes from the start of `fd`; false on error or short read
+  bool ReadAll(int fd, std::string& out, std::size_t size) {
+    out.resize(size);
+    std::size_t done = 0;
+    while (done < size) {
+      ssize_t n = ::pread(fd, &out[done], size - done, static_cast<off_t>(done));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      done += static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+} // end of namespace
+
+// LCOV_EXCL_START
+StaticFileCache& StaticFileCache::instance() {
+  static StaticFileCache cache;
+  return cache;
+}
+// LCOV_EXCL_STOP
+
+StaticFileCache::StaticFileCache(std::size_t capacity) {
+  set_capacity(capacity);
+}
+
+StaticFileCache::~StaticFileCache() {
+  stop_watcher();
+}
+
+void StaticFileCache::set_capacity(std::size_t bytes) {
+  // Without inotify there is no way to notice stale entries, so don't cache
+  if (bytes > 0 && !start_watcher()) {
+    bytes = 0;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = bytes;
+  if (capacity_ == 0) {
+    clear_locked();
+  }
+  evict_locked(0, false);
+}
+
+void StaticFileCache::set_mmap_limit(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  mmap_limit_ = bytes;
+  evict_locked(0, true);
+}
+
+std::size_t StaticFileCache::mmap_limit() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return mmap_limit_;
+}
+
+std::size_t StaticFileCache::mapped_size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return mapped_bytes_;
+}
+
+std::size_t StaticFileCache::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+std::size_t StaticFileCache::max_entry_size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_ / 16;
+}
+
+std::size_t StaticFileCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+std::size_t StaticFileCache::entries() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+std::shared_ptr<const CachedFile> StaticFileCache::find(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  auto& lru = it->second.file->mapping ? mapped_lru_ : lru_;
+  lru.splice(lru.begin(), lru, it->second.lru_pos);
+  return it->second.file;
+}
+
+std::shared_ptr<const CachedFile> StaticFileCache::insert(const std::string& key,
+                                                          const std::string& path,
+                                                          const std::shared_ptr<FileBody>& file,
+                                                          HttpHeaders headers) {
+  std::uint64_t generation;
+  bool in_memory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_memory = file->file_size() <= capacity_ / 16;
+    if (capacity_ == 0 || (!in_memory && file->file_size() > mmap_limit_)) {
+      return nullptr;
+    }
+    // Watch before reading so a write racing with the read bumps the generation
+    if (!watch_directory(DirectoryOf(path))) {
+      return nullptr;
+    }
+    generation = generation_;
+  }
+
+  // The file may have been replaced between being opened and being watched
+  struct stat current;
+  if (::stat(path.c_str(), &current) != 0 || !SameFile(current, file->stat())) {
+    return nullptr;
+  }
+
+  auto cached = std::make_shared<CachedFile>();
+  if (in_memory) {
+    std::string contents;
+    if (!ReadAll(file->fd(), contents, static_cast<std::size_t>(file->file_size()))) {
+      return nullptr;
+    }
+    cached->body = SharedBytes(std::move(contents));
+  } else {
+    cached->mapping = MappedFile::map(file);
+    if (!cached->mapping) {
+      return nullptr;
+    }
+    cached->body = SharedBytes(cached->mapping, cached->mapping->bytes());
+  }
+  cached->headers = std::move(headers);
+  cached->stat = file->stat();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t limit = in_memory ? capacity_ / 16 : mmap_limit_;
+  if (generation != generation_ || capacity_ == 0 || cached->body.size() > limit) {
+    return nullptr;
+  }
+  store_locked(key, path, cached);
+  return cached;
+}
+
+std::shared_ptr<const CachedFile> StaticFileCache::insert_variant(
+    const std::string& key, const std::string& identity_key,
+    const std::shared_ptr<const CachedFile>& identity, std::shared_ptr<const CachedFile> variant) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto source = entries_.find(identity_key);
+  if (source == entries_.end() || source->second.file != identity || variant->mapping ||
+      variant->body.size() > capacity_ / 16) {
+    return nullptr;
+  }
+  std::string path = source->second.path;
+  store_locked(key, path, variant);
+  return variant;
+}
+
+bool StaticFileCache::missing(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return missing_.count(key) != 0;
+}
+
+bool StaticFileCache::watch_paths(const std::vector<std::string>& paths, std::uint64_t& generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return false;
+  }
+  for (const auto& path : paths) {
+    // A directory that does not exist yet is noticed being created in the
+    // nearest one that does
+    std::string dir = DirectoryOf(path);
+    struct stat st;
+    while (dir != "." && dir != "/" && ::stat(dir.c_str(), &st) != 0 && errno == ENOENT) {
+      dir = DirectoryOf(dir);
+    }
+    if (!watch_directory(dir)) {
+      return false;
+    }
+  }
+  generation = generation_;
+  return true;
+}
+
+void StaticFileCache::insert_missing(const std::string& key, const std::vector<std::string>& paths,
+                                     std::uint64_t generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // A file created after the watch but before the probe bumped the generation
+  if (generation != generation_ || capacity_ == 0) {
+    return;
+  }
+  drop_missing_locked(key);
+  for (const auto& path : paths) {
+    missing_by_path_[path] = key;
+  }
+  missing_[key] = paths;
+}
+
+void StaticFileCache::invalidate(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  invalidate_locked(path);
+}
+
+void StaticFileCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  clear_locked();
+}
+
+void StaticFileCache::clear_locked() {
+  ++generation_;
+  entries_.clear();
+  keys_by_path_.clear();
+  missing_.clear();
+  missing_by_path_.clear();
+  lru_.clear();
+  mapped_lru_.clear();
+  bytes_ = 0;
+  mapped_bytes_ = 0;
+}
+
+HttpHeaders StaticFileCache::file_headers(const struct stat& st, const std::string& content_type) {
+  HttpHeaders headers;
+  headers.reserve(4);
+  headers.add("Content-Type", content_type);
+  headers.add("Accept-Ranges", "bytes");
+  headers.add("ETag", make_etag(st));
+  headers.add("Last-Modified", http_date(st.st_mtim.tv_sec));
+  return headers;
+}
+
+std::string StaticFileCache::make_etag(const struct stat& st) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "\"%llx-%llx-%lx-%llx\"",
+                static_cast<unsigned long long>(st.st_ino),
+                static_cast<unsigned long long>(st.st_mtim.tv_sec),
+                static_cast<unsigned long>(st.st_mtim.tv_nsec),
+                static_cast<unsigned long long>(st.st_size));
+  return buf;
+}
+
+std::string StaticFileCache::http_date(std::time_t t) {
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  static const char* const kDays[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+  static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                kDays[tm.tm_wday], tm.tm_mday, kMonths[tm.tm_mon], tm.tm_year + 1900,
+                tm.tm_hour, tm.tm_min, tm.tm_sec);
+  return buf;
+}
+
+bool StaticFileCache::parse_http_date(const std::string& value, std::time_t& t) {
+  static const char* const kFormats[] = {
+    "%a, %d %b %Y %H:%M:%S GMT",  // IMF-fixdate
+    "%A, %d-%b-%y %H:%M:%S GMT",  // obsolete RFC 850
+    "%a %b %e %H:%M:%S %Y",       // obsolete asctime()
+  };
+  for (const char* format : kFormats) {
+    struct tm tm = {};
+    const char* end = strptime(value.c_str(), format, &tm);
+    if (end && *end == '\0') {
+      t = timegm(&tm);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool StaticFileCache::start_watcher() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (inotify_fd_ >= 0) {
+    return true;
+  }
+  inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) {
+    BOOST_LOG_TRIVIAL(warning) << "Static file cache disabled, inotify unavailable: "
+                               << std::strerror(errno);
+    return false;
+  }
+  stop_fd_ = ::eventfd(0, EFD_CLOEXEC);
+  if (stop_fd_ < 0) {
+    BOOST_LOG_TRIVIAL(warning) << "Static file cache disabled, eventfd failed: "
+                               << std::strerror(errno);
+    ::close(inotify_fd_);
+    inotify_fd_ = -1;
+    return false;
+  }
+  watcher_ = std::thread(&StaticFileCache::watch_loop, this);
+  return true;
+}
+
+void StaticFileCache::stop_watcher() {
+  if (watcher_.joinable()) {
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(stop_fd_, &one, sizeof(one));
+    (void)ignored;
+    watcher_.join();
+  }
+  if (stop_fd_ >= 0) ::close(stop_fd_);
+  if (inotify_fd_ >= 0) ::close(inotify_fd_);
+  stop_fd_ = inotify_fd_ = -1;
+}
+
+bool StaticFileCache::watch_directory(const std::string& dir) {
+  if (dir_watches_.count(dir)) {
+    return true;
+  }
+  int wd = ::inotify_add_watch(inotify_fd_, dir.c_str(), kWatchMask);
+  if (wd < 0) {
+    BOOST_LOG_TRIVIAL(warning) << "Cannot watch " << dir << " for changes: "
+                               << std::strerror(errno);
+    return false;
+  }
+  // Two spellings of one directory share a watch descriptor
+  watched_dirs_[wd].push_back(dir);
+  dir_watches_[dir] = wd;
+  return true;
+}
+
+void StaticFileCache::watch_loop() {
+  alignas(struct inotify_event) char buf[16 * 1024];
+  pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+  while (true) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      BOOST_LOG_TRIVIAL(error) << "Static file cache watcher failed: " << std::strerror(errno);
+      set_capacity(0);
+      return;
+    }
+    if (fds[1].revents) {
+      return;
+    }
+    ssize_t len = ::read(inotify_fd_, buf, sizeof(buf));
+    if (len <= 0) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (char* p = buf; p < buf + len;) {
+      auto* event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Events were lost; nothing cached can be trusted
+        clear_locked();
+        continue;
+      }
+      auto dir = watched_dirs_.find(event->wd);
+      if (dir == watched_dirs_.end()) {
+        continue;
+      }
+      if (event->mask & IN_IGNORED) {
+        // The directory itself went away
+        for (const auto& spelling : dir->second) {
+          invalidate_prefix_locked(spelling == "/" ? spelling : spelling + "/");
+          dir_watches_.erase(spelling);
+        }
+        watched_dirs_.erase(dir);
+        continue;
+      }
+      if (event->len == 0) {
+        continue;
+      }
+      for (const auto& spelling : dir->second) {
+        std::string path = spelling == "/" ? "/" + std::string(event->name)
+                                           : spelling + "/" + event->name;
+        if (event->mask & IN_ISDIR) {
+          invalidate_prefix_locked(path + "/");
+        } else {
+          invalidate_locked(path);
+        }
+      }
+    }
+  }
+}
+
+void StaticFileCache::invalidate_locked(const std::string& path) {
+  ++generation_;
+  auto absent = missing_by_path_.find(path);
+  if (absent != missing_by_path_.end()) {
+    // The file now exists; an entry derived without it must not win over it
+    std::string key = absent->second;
+    drop_missing_locked(key);
+    auto entry = entries_.find(key);
+    if (entry != entries_.end()) {
+      erase_locked(entry);
+    }
+  }
+  auto indexed = keys_by_path_.find(path);
+  if (indexed == keys_by_path_.end()) {
+    return;
+  }
+  std::vector<std::string> keys = std::move(indexed->second);
+  keys_by_path_.erase(indexed);
+  for (const auto& key : keys) {
+    erase_locked(entries_.find(key));
+  }
+}
+
+void StaticFileCache::invalidate_prefix_locked(const std::string& prefix) {
+  ++generation_;
+  std::vector<std::string> keys;
+  auto it = keys_by_path_.lower_bound(prefix);
+  while (it != keys_by_path_.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+    keys.insert(keys.end(), it->second.begin(), it->second.end());
+    it = keys_by_path_.erase(it);
+  }
+  std::vector<std::string> absent_keys;
+  for (auto absent = missing_by_path_.lower_bound(prefix);
+       absent != missing_by_path_.end() && absent->first.compare(0, prefix.size(), prefix) == 0;
+       ++absent) {
+    absent_keys.push_back(absent->second);
+  }
+  for (const auto& key : absent_keys) {
+    drop_missing_locked(key);
+  }
+  for (const auto& key : keys) {
+    erase_locked(entries_.find(key));
+  }
+}
+
+void StaticFileCache::evict_locked(std::size_t incoming, bool mapped) {
+  if (mapped) {
+    while (!mapped_lru_.empty() && mapped_bytes_ + incoming > 16 * mmap_limit_) {
+      erase_locked(entries_.find(mapped_lru_.back()));
+    }
+    return;
+  }
+  while (!lru_.empty() && bytes_ + incoming > capacity_) {
+    erase_locked(entries_.find(lru_.back()));
+  }
+}
+
+void StaticFileCache::store_locked(const std::string& key, const std::string& path,
+                                   std::shared_ptr<const CachedFile> file) {
+  auto existing = entries_.find(key);
+  if (existing != entries_.end()) {
+    erase_locked(existing);
+  }
+  std::size_t size = file->body.size();
+  bool mapped = file->mapping != nullptr;
+  auto& lru = mapped ? mapped_lru_ : lru_;
+  evict_locked(size, mapped);
+  lru.push_front(key);
+  keys_by_path_[path].push_back(key);
+  entries_.emplace(key, Entry{std::move(file), path, lru.begin()});
+  (mapped ? mapped_bytes_ : bytes_) += size;
+}
+
+void StaticFileCache::erase_locked(std::unordered_map<std::string, Entry>::iterator it) {
+  // Invalidation takes the path's keys out of the index before erasing them
+  auto indexed = keys_by_path_.find(it->second.path);
+  if (indexed != keys_by_path_.end()) {
+    auto& keys = indexed->second;
+    auto key = std::find(keys.begin(), keys.end(), it->first);
+    if (key != keys.end()) {
+      keys.erase(key);
+    }
+    if (keys.empty()) {
+      keys_by_path_.erase(indexed);
+    }
+  }
+  if (it->second.file->mapping) {
+    mapped_bytes_ -= it->second.file->body.size();
+    mapped_lru_.erase(it->second.lru_pos);
+  } else {
+    bytes_ -= it->second.file->body.size();
+    lru_.erase(it->second.lru_pos);
+  }
+  entries_.erase(it);
+}
+
+void StaticFileCache::drop_missing_locked(const std::string& key) {
+  auto it = missing_.find(key);
+  if (it == missing_.end()) {
+    return;
+  }
+  for (const auto& path : it->second) {
+    missing_by_path_.erase(path);
+  }
+  missing_.erase(it);
+}
@@ -1,19 +1,228 @@
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <boost/asio.hpp>
 #include <boost/beast/http.hpp>
 #include <iostream>
-#include <fstream>
+#include <random>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
 #include "static_handler.h"
+#include "byte_range.h"
+#include "compression.h"
 #include "handler_registry.h"
+#include "mime_types.h"
+#include "static_file_cache.h"
 
 const std::string StaticHandler::kName = "StaticHandler";
 
+namespace {
+  // Weak comparison (RFC 9110 section 8.8.3.2): ignore any W/ prefix
+  std::string_view OpaqueTag(std::string_view tag) {
+    if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/') tag.remove_prefix(2);
+    return tag;
+  }
+
+  bool EtagListMatches(std::string_view list, std::string_view etag) {
+    etag = OpaqueTag(etag);
+    while (!list.empty()) {
+      auto comma = list.find(',');
+      std::string_view tag = list.substr(0, comma);
+      list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+      while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+      while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+      if (tag == "*" || OpaqueTag(tag) == etag) return true;
+    }
+    return false;
+  }
+
+  // Whether the client's copy is current (RFC 9110 section 13.2.2). If-None-Match
+  // takes precedence; If-Modified-Since is only consulted when it is absent.
+  bool NotModified(const HttpRequest& req, const HttpHeaders& headers, const struct stat& st) {
+    auto inm = req.headers.find("If-None-Match");
+    if (inm != req.headers.end()) {
+      auto etag = headers.find("ETag");
+      return etag != headers.end() && EtagListMatches(inm->second, etag->second);
+    }
+    auto ims = req.headers.find("If-Modified-Since");
+    std::time_t since;
+    if (ims != req.headers.end() && StaticFileCache::parse_http_date(ims->second, since)) {
+      return st.st_mtim.tv_sec <= since;
+    }
+    return false;
+  }
+
+  // Cache key of the `coding` encoding of the file at `path`
+  std::string VariantKey(const std::string& path, ContentCoding coding) {
+    return path + '\n' + Compression::token(coding);
+  }
+
+  // Headers of a file response; `encoding` is set for a precompressed sibling
+  HttpHeaders FileHeaders(const struct stat& st, const std::string& mime_type,
+                          const char* encoding) {
+    HttpHeaders headers = StaticFileCache::file_headers(st, mime_type);
+    if (Compression::compressible(mime_type)) {
+      headers.add("Vary", "Accept-Encoding");
+    }
+    if (encoding) {
+      headers.add("Content-Encoding", encoding);
+    }
+    return headers;
+  }
+
+  // Multipart bodies are assembled in memory; larger multi-range requests are served whole
+  constexpr std::uint64_t kMaxMultipartBytes = 16 * 1024 * 1024;
+
+  // Whether Range may be honoured under If-Range (RFC 9110 section 13.1.5): the
+  // validator must be the current strong ETag or exactly the Last-Modified date
+  bool IfRangeHolds(const HttpRequest& req, const HttpHeaders& headers, const struct stat& st) {
+    auto if_range = req.headers.find("If-Range");
+    if (if_range == req.headers.end()) {
+      return true;
+    }
+    const std::string& value = if_range->second;
+    if (value.rfind("W/", 0) == 0) {
+      return false;
+    }
+    if (!value.empty() && value[0] == '"') {
+      auto etag = headers.find("ETag");
+      return etag != headers.end() && etag->second == value;
+    }
+    std::time_t date;
+    return StaticFileCache::parse_http_date(value, date) && date == st.st_mtim.tv_sec;
+  }
+
+  std::string MultipartBoundary() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(rng()));
+    return buf;
+  }
+
+  // Append `range` of the file to `out`: copied from memory when the cache
+  // holds the file, otherwise read from the open file (or the one behind a
+  // mapping, which is never read directly)
+  bool AppendRange(std::string& out, const ByteRange& range,
+                   const CachedFile* cached, const FileBody* file) {
+    if (cached && !cached->mapping) {
+      out.append(cached->body.view().substr(range.first, range.length()));
+      return true;
+    }
+    if (cached) {
+      file = &cached->mapping->source();
+    }
+    std::size_t start = out.size();
+    out.resize(start + range.length());
+    std::uint64_t done = 0;
+    while (done < range.length()) {
+      ssize_t n = ::pread(file->fd(), &out[start + done], range.length() - done,
+                          static_cast<off_t>(range.first + done));
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      done += static_cast<std::uint64_t>(n);
+    }
+    return true;
+  }
+
+  // Fill in a found file: a 304 for a current conditional GET, a 206 or 416
+  // for a Range, otherwise the whole file. `cached` is the cache entry, or
+  // null when `file` is to be sent instead.
+  void Serve(const HttpRequest& req, HttpResponse& res, const struct stat& st,
+             const CachedFile* cached, std::shared_ptr<FileBody> file) {
+    if (NotModified(req, res.headers, st)) {
+      res.status_code = 304;
+      return;
+    }
+
+    auto size = static_cast<std::uint64_t>(st.st_size);
+    std::vector<ByteRange> ranges;
+    auto result = ByteRangeParser::Result::ignored;
+    auto range = req.headers.find("Range");
+    if (range != req.headers.end() && IfRangeHolds(req, res.headers, st)) {
+      result = ByteRangeParser::parse(range->second, size, ranges);
+    }
+
+    if (result == ByteRangeParser::Result::unsatisfiable) {
+      res.status_code = 416;
+      res.headers.erase("Content-Type");
+      res.headers.add("Content-Range", ByteRangeParser::unsatisfied_range(size));
+      return;
+    }
+    if (result == ByteRangeParser::Result::satisfiable && ranges.size() == 1) {
+      // Only the requested slice is sent: a view of the cached bytes, or
+      // the file from an offset with sendfile
+      const ByteRange& r = ranges.front();
+      res.status_code = 206;
+      res.headers.add("Content-Range", ByteRangeParser::content_range(r, size));
+      if (cached) {
+        res.shared_body = cached->body.slice(r.first, r.length());
+      } else {
+        file->set_range(r.first, r.length());
+        res.file = std::move(file);
+      }
+      return;
+    }
+    if (result == ByteRangeParser::Result::satisfiable) {
+      std::uint64_t total = 0;
+      for (const auto& r : ranges) total += r.length();
+      if (total <= kMaxMultipartBytes) {
+        std::string boundary = MultipartBoundary();
+        auto type = res.headers.find("Content-Type");
+        std::string part_type = type != res.headers.end() ? type->second : "";
+        std::string body;
+        body.reserve(total + ranges.size() * 128);
+        for (const auto& r : ranges) {
+          body += "--" + boundary + "\r\nContent-Type: " + part_type + "\r\nContent-Range: " +
+                  ByteRangeParser::content_range(r, size) + "\r\n\r\n";
+          if (!AppendRange(body, r, cached, file.get())) {
+            res.status_code = 500;
+            res.headers.clear();
+            return;
+          }
+          body += "\r\n";
+        }
+        body += "--" + boundary + "--\r\n";
+        res.status_code = 206;
+        res.headers.set("Content-Type", "multipart/byteranges; boundary=" + boundary);
+        res.body = std::move(body);
+        return;
+      }
+    }
+
+    res.status_code = 200;
+    if (cached) {
+      res.shared_body = cached->body;
+    } else {
+      res.file = std::move(file);
+    }
+  }
+} // end of namespace
+
 StaticHandler::StaticHandler(const std::string& path, const std::string& root_dir)
   : path_(path), root_dir_(root_dir) {}
 
+std::vector<std::string> StaticHandler::candidate_paths(const std::string& path) const {
+  // If root_dir_ is absolute, also try sibling static_files from build directory
+  if (!root_dir_.empty() && root_dir_[0] == '/') {
+    return {path, ".." + path};
+  }
+  return {path};
+}
+
+std::shared_ptr<FileBody> StaticHandler::open_file(const std::string& path,
+                                                   std::string& file_path) const {
+  for (const auto& candidate : candidate_paths(path)) {
+    if (auto file = FileBody::open(candidate)) {
+      file_path = candidate;
+      return file;
+    }
+  }
+  return nullptr;
+}
+
 std::unique_ptr<HttpResponse> StaticHandler::handle_request(const HttpRequest& req) {
   //setup server response
   auto res = std::make_unique<HttpResponse>();
@@ -23,49 +232,116 @@ std::unique_ptr<HttpResponse> StaticHandler::handle_request(const HttpRequest& r
     std::string path = req.path;
     path.replace(0, path_.length(), root_dir_); //replace url prefix with root
 
-    //find mime_type
+    // Codings the client takes, most preferred first
+    std::vector<ContentCoding> codings;
+    auto accept = req.headers.find("Accept-Encoding");
+    if (accept != req.headers.end()) {
+      codings = Compression::accepted(accept->second);
+    }
+
+    // Serve from memory when this path, or an encoding of it, was read before
+    // and has not changed since
+    auto& cache = StaticFileCache::instance();
+    for (auto coding : codings) {
+      if (auto cached = cache.find(VariantKey(path, coding))) {
+        res->headers = cached->headers;
+        Serve(req, *res, cached->stat, cached.get(), nullptr);
+        return res;
+      }
+    }
+    auto identity = cache.find(path);
+
     std::string mime_type;
-    auto ext_pos = path.rfind('.');
-    if (ext_pos == std::string::npos) { 
+    if (identity) {
+      mime_type = identity->headers.find(HeaderId::content_type)->second;
+    } else {
+      mime_type = MimeTypes::instance().lookup(path);
+      if (mime_type.empty()) {
         res->status_code = 404;
         return res;
+      }
     }
-    auto ext = path.substr(ext_pos);
-    if      (ext == ".html") mime_type = "text/html";
-    else if (ext == ".txt" ) mime_type = "text/plain";
-    else if (ext == ".jpg" ) mime_type = "image/jpeg";
-    else if (ext == ".png" ) mime_type = "image/png";
-    else if (ext == ".zip" ) mime_type = "application/zip";
-    if (mime_type.empty()) {
+    bool encode = !codings.empty() && Compression::compressible(mime_type);
+
+    std::shared_ptr<FileBody> file;
+    std::string file_path;
+    if (!identity) {
+      file = open_file(path, file_path);
+      if (!file) {
         res->status_code = 404;
-    } else {
-      // else try open file at configured path
-      std::string file_path = path;
-      std::ifstream file(file_path, std::ios::in | std::ios::binary);
-      // If root_dir_ is absolute, also try sibling static_files from build directory
-      if (!file && !root_dir_.empty() && root_dir_[0] == '/') {
-          std::string alt_path = ".." + file_path;
-          file.open(alt_path, std::ios::in | std::ios::binary);
-          if (file) {
-              file_path = alt_path;
-          }
+        return res;
       }
-      // Try relative path if absolute path fails
-      if (!file) {
-          file.open(file_path, std::ios::in | std::ios::binary);
+    }
+
+    // A precompressed sibling such as messages.html.br wins over compressing
+    // here. Siblings found missing are remembered until one appears, so a
+    // file without them costs a lookup per request rather than open() calls.
+    if (encode) {
+      for (auto coding : codings) {
+        std::string key = VariantKey(path, coding);
+        if (cache.missing(key)) {
+          continue;
+        }
+        std::string sibling_name = path + Compression::extension(coding);
+        std::vector<std::string> probed = candidate_paths(sibling_name);
+        std::uint64_t generation = 0;
+        bool record = cache.watch_paths(probed, generation);
+        std::string sibling_path;
+        auto sibling = open_file(sibling_name, sibling_path);
+        if (!sibling) {
+          if (record) {
+            cache.insert_missing(key, probed, generation);
+          }
+          continue;
+        }
+        auto headers = FileHeaders(sibling->stat(), mime_type, Compression::token(coding));
+        if (auto cached = cache.insert(key, sibling_path, sibling, headers)) {
+          res->headers = cached->headers;
+          Serve(req, *res, cached->stat, cached.get(), nullptr);
+        } else {
+          res->headers = std::move(headers);
+          struct stat st = sibling->stat();
+          Serve(req, *res, st, nullptr, std::move(sibling));
+        }
+        return res;
       }
-      if (!file) {
-        res->status_code = 404;
-      } else {
-        res->status_code = 200;
-        res->headers["Content-Type"] = mime_type;
+    }
 
-        std::stringstream buf;
-        buf << file.rdbuf();
-        res->body = buf.str();
+    if (!identity) {
+      identity = cache.insert(path, file_path, file, FileHeaders(file->stat(), mime_type, nullptr));
+    }
+
+    // Compress a file held in memory once and keep the result next to it.
+    // When that does not make it smaller, the file itself is kept as the
+    // variant. Mapped files are sent as they are.
+    if (encode && identity && !identity->mapping) {
+      ContentCoding coding = codings.front();
+      std::string encoded;
+      std::shared_ptr<const CachedFile> variant = identity;
+      if (Compression::compress(coding, identity->body.view(), encoded, Compression::Level::best) &&
+          encoded.size() < identity->body.size()) {
+        auto compressed = std::make_shared<CachedFile>();
+        compressed->body = SharedBytes(std::move(encoded));
+        compressed->headers = identity->headers;
+        compressed->headers.add("Content-Encoding", Compression::token(coding));
+        auto etag = compressed->headers.find("ETag");
+        etag->second = Compression::variant_etag(etag->second, coding);
+        compressed->stat = identity->stat;
+        variant = std::move(compressed);
       }
+      cache.insert_variant(VariantKey(path, coding), path, identity, variant);
+      identity = std::move(variant);
+    }
+
+    if (identity) {
+      res->headers = identity->headers;
+      Serve(req, *res, identity->stat, identity.get(), nullptr);
+    } else {
+      // Too large to cache: the session streams the file with sendfile
+      res->headers = FileHeaders(file->stat(), mime_type, nullptr);
+      struct stat st = file->stat();
+      Serve(req, *res, st, nullptr, std::move(file));
     }
-    
   }
   else {res->status_code = 400;}
 
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "access_log.h"
+
+class AccessLogTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/access_log_testXXXXXX";
+    ASSERT_NE(mkdtemp(tmpl), nullptr);
+    dir_ = tmpl;
+  }
+
+  void TearDown() override {
+    log_.close();
+    std::system(("rm -rf " + dir_).c_str());
+  }
+
+  // Segment files in the order they were written
+  std::vector<std::string> segments() {
+    std::vector<std::string> files;
+    DIR* dir = opendir(dir_.c_str());
+    while (dirent* ent = readdir(dir)) {
+      std::string name = ent->d_name;
+      if (name.rfind("access-", 0) == 0) files.push_back(name);
+    }
+    closedir(dir);
+    auto index = [](const std::string& name) {
+      return std::stoul(name.substr(name.rfind('-') + 1));
+    };
+    std::sort(files.begin(), files.end(),
+              [&](const std::string& a, const std::string& b) { return index(a) < index(b); });
+    for (auto& file : files) file = dir_ + "/" + file;
+    return files;
+  }
+
+  static std::vector<AccessLogEntry> read(const std::string& file) {
+    std::vector<AccessLogEntry> entries;
+    std::string error;
+    EXPECT_TRUE(AccessLogReader::read(file, [&](const AccessLogEntry& e) { entries.push_back(e); },
+                                      error)) << error;
+    return entries;
+  }
+
+  static AccessLog::Request request(const std::string& path, int status) {
+    AccessLog::Request req;
+    req.time = std::chrono::system_clock::time_point(std::chrono::microseconds(1790000000123456));
+    req.latency = std::chrono::microseconds(250);
+    req.status = status;
+    req.bytes_in = 78;
+    req.bytes_out = 1234;
+    req.client = boost::asio::ip::make_address("127.0.0.1");
+    req.client_port = 51000;
+    req.method = "GET";
+    req.path = path;
+    req.handler = "StaticHandler";
+    return req;
+  }
+
+  std::string dir_;
+  AccessLog log_;
+};
+
+// test that recorded requests decode with every field intact
+TEST_F(AccessLogTest, RoundTrip) {
+  ASSERT_TRUE(log_.open(dir_, 0));
+  log_.record(request("/static/index.html", 200));
+  log_.record(request("/static/index.html", 304));
+  auto v6 = request("/missing", 404);
+  v6.client = boost::asio::ip::make_address("2001:db8::1");
+  v6.method = "HEAD";
+  log_.record(v6);
+  log_.close();
+
+  auto files = segments();
+  ASSERT_EQ(files.size(), 1u);
+  auto entries = read(files[0]);
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].timestamp_us, 1790000000123456u);
+  EXPECT_EQ(entries[0].latency_us, 250u);
+  EXPECT_EQ(entries[0].status, 200);
+  EXPECT_EQ(entries[0].bytes_in, 78u);
+  EXPECT_EQ(entries[0].bytes_out, 1234u);
+  EXPECT_EQ(entries[0].client, "127.0.0.1");
+  EXPECT_EQ(entries[0].client_port, 51000);
+  EXPECT_EQ(entries[0].method, "GET");
+  EXPECT_EQ(entries[0].path, "/static/index.html");
+  EXPECT_EQ(entries[0].handler, "StaticHandler");
+  EXPECT_EQ(entries[1].status, 304);
+  EXPECT_EQ(entries[1].path, "/static/index.html");
+  EXPECT_EQ(entries[2].client, "2001:db8::1");
+  EXPECT_EQ(entries[2].method, "HEAD");
+  EXPECT_EQ(entries[2].path, "/missing");
+}
+
+// test that repeated strings are written once per segment
+TEST_F(AccessLogTest, InternsStrings) {
+  ASSERT_TRUE(log_.open(dir_, 0));
+  for (int i = 0; i < 100; ++i) {
+    log_.record(request("/static/index.html", 200));
+  }
+  log_.close();
+  std::ifstream in(segments()[0], std::ios::binary | std::ios::ate);
+  // header, three strings of at most 24 bytes each, then fixed-size records
+  EXPECT_LE(static_cast<std::size_t>(in.tellg()),
+            sizeof(access_log::SegmentHeader) + 3 * 32 + 100 * sizeof(access_log::RequestRecord));
+}
+
+// test that a full segment rolls over and every segment decodes on its own
+TEST_F(AccessLogTest, RotatesSegments) {
+  ASSERT_TRUE(log_.open(dir_, 0));  // clamped up to the minimum size
+  const int kRequests = 10000;
+  for (int i = 0; i < kRequests; ++i) {
+    log_.record(request("/static/file" + std::to_string(i % 50), 200));
+  }
+  EXPECT_GT(log_.segments(), 1u);
+  log_.close();
+
+  auto files = segments();
+  ASSERT_EQ(files.size(), log_.segments());
+  std::size_t total = 0;
+  for (const auto& file : files) {
+    auto entries = read(file);
+    EXPECT_FALSE(entries.empty());
+    for (const auto& entry : entries) {
+      EXPECT_EQ(entry.path.rfind("/static/file", 0), 0u);
+      EXPECT_EQ(entry.handler, "StaticHandler");
+    }
+    total += entries.size();
+  }
+  EXPECT_EQ(total, static_cast<std::size_t>(kRequests));
+}
+
+// test that recording does nothing until the log is opened, or once it is closed
+TEST_F(AccessLogTest, DisabledIsNoOp) {
+  EXPECT_FALSE(log_.enabled());
+  log_.record(request("/", 200));
+  EXPECT_TRUE(segments().empty());
+
+  ASSERT_TRUE(log_.open(dir_, 0));
+  log_.close();
+  EXPECT_FALSE(log_.enabled());
+  log_.record(request("/", 200));
+  auto files = segments();
+  ASSERT_EQ(files.size(), 1u);
+  EXPECT_TRUE(read(files[0]).empty());
+}
+
+// test that opening a missing directory fails and leaves the log disabled
+TEST_F(AccessLogTest, OpenFails) {
+  EXPECT_FALSE(log_.open(dir_ + "/missing", 0));
+  EXPECT_FALSE(log_.enabled());
+}
+
+// test that foreign and damaged files are reported
+TEST_F(AccessLogTest, RejectsBadFiles) {
+  std::string error;
+  auto ignore = [](const AccessLogEntry&) {};
+  EXPECT_FALSE(AccessLogReader::read(dir_ + "/none.bin", ignore, error));
+
+  std::string foreign = dir_ + "/foreign.bin";
+  std::ofstream(foreign) << std::string(100, 'x');
+  EXPECT_FALSE(AccessLogReader::read(foreign, ignore, error));
+  EXPECT_EQ(error, "not an access log segment");
+
+  ASSERT_TRUE(log_.open(dir_, 0));
+  log_.record(request("/a", 200));
+  log_.record(request("/b", 200));
+  log_.close();
+  std::string segment = segments()[0];
+  std::string data;
+  {
+    std::ifstream in(segment, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  // Cut the last record in half: the first request still decodes
+  std::string cut = dir_ + "/cut.bin";
+  std::ofstream(cut, std::ios::binary) << data.substr(0, data.size() - 32);
+  int seen = 0;
+  EXPECT_FALSE(AccessLogReader::read(cut, [&](const AccessLogEntry&) { ++seen; }, error));
+  EXPECT_EQ(seen, 1);
+  EXPECT_NE(error.find("corrupt"), std::string::npos);
+}
+
+// test the text and JSON renderings
+TEST_F(AccessLogTest, Formats) {
+  AccessLogEntry entry;
+  entry.timestamp_us = 1790000000123456;
+  entry.latency_us = 250;
+  entry.status = 200;
+  entry.bytes_in = 78;
+  entry.bytes_out = 1234;
+  entry.client = "127.0.0.1";
+  entry.client_port = 51000;
+  entry.method = "GET";
+  entry.path = "/static/index.html";
+  entry.handler = "StaticHandler";
+  EXPECT_EQ(AccessLogReader::to_text(entry),
+            "2026-09-21T14:13:20.123456Z 127.0.0.1:51000 \"GET /static/index.html\" 200 250us "
+            "in=78 out=1234 handler=StaticHandler");
+  auto json = nlohmann::json::parse(AccessLogReader::to_json(entry));
+  EXPECT_EQ(json["time"], "2026-09-21T14:13:20.123456Z");
+  EXPECT_EQ(json["status"], 200);
+  EXPECT_EQ(json["path"], "/static/index.html");
+  EXPECT_EQ(json["latency_us"], 250);
+  EXPECT_EQ(json["handler"], "StaticHandler");
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "api_handler.h"
+#include "compression_middleware_handler.h"
 #include "fake_file_store.h"
 #include "handler_registry.h"
 #include <memory>
@@ -156,8 +157,10 @@ TEST(ApiHandlerFactoryTest, RegisteredInHandlerRegistry) {
   auto ptr = HandlerRegistry::instance().createHandler(
       "ApiHandler", std::vector<std::string>{"/api", "/tmp/data"});
   ASSERT_TRUE(ptr) << "ApiHandler factory should be registered";
-  // Should actually produce an ApiHandler
-  auto* api = dynamic_cast<ApiHandler*>(ptr.get());
+  // Should actually produce an ApiHandler, behind the compression middleware
+  auto* compression = dynamic_cast<CompressionMiddlewareHandler*>(ptr.get());
+  ASSERT_NE(compression, nullptr);
+  auto* api = dynamic_cast<ApiHandler*>(compression->next());
   EXPECT_NE(api, nullptr);
 }
 
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/make_shared.hpp>
+#include "async_log_backend.h"
+
+namespace logging = boost::log;
+namespace sinks = boost::log::sinks;
+
+// Installs an AsyncLogBackend as the only sink and records what it writes
+class AsyncLogBackendTest : public ::testing::Test {
+protected:
+  using Sink = AsyncLogSink;
+
+  void Install(std::size_t ring_size, AsyncLogBackend::Overflow overflow,
+               std::function<void()> before_write = nullptr) {
+    backend_ = boost::make_shared<AsyncLogBackend>(
+        [this, before_write](const AsyncLogBackend::Batch& batch, std::uint64_t dropped) {
+          if (before_write) before_write();
+          std::lock_guard<std::mutex> lock(mutex_);
+          reported_drops_ += dropped;
+          for (const auto& rec : batch) {
+            written_.push_back(*rec[logging::expressions::smessage]);
+          }
+        },
+        ring_size, overflow);
+    sink_ = boost::make_shared<Sink>(backend_);
+    logging::core::get()->remove_all_sinks();
+    logging::core::get()->add_sink(sink_);
+  }
+
+  void TearDown() override {
+    logging::core::get()->remove_all_sinks();
+    sink_.reset();
+    backend_.reset();
+  }
+
+  std::vector<std::string> written() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+  }
+
+  boost::shared_ptr<AsyncLogBackend> backend_;
+  boost::shared_ptr<Sink> sink_;
+  std::mutex mutex_;
+  std::vector<std::string> written_;
+  std::uint64_t reported_drops_ = 0;
+};
+
+// test that records from several threads all arrive, each thread's in order
+TEST_F(AsyncLogBackendTest, DeliversEveryThreadInOrder) {
+  Install(1024, AsyncLogBackend::Overflow::block);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t] {
+      for (int i = 0; i < 500; ++i) {
+        BOOST_LOG_TRIVIAL(info) << t << " " << i;
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  logging::core::get()->flush();
+
+  auto lines = written();
+  ASSERT_EQ(lines.size(), 2000u);
+  std::map<int, int> next;
+  for (const auto& line : lines) {
+    int t = std::stoi(line);
+    int i = std::stoi(line.substr(line.find(' ') + 1));
+    EXPECT_EQ(i, next[t]++);
+  }
+  EXPECT_EQ(backend_->dropped(), 0u);
+}
+
+// test that a full queue drops and counts records under the drop policy
+TEST_F(AsyncLogBackendTest, DropsWhenFull) {
+  std::promise<void> entered;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  bool first = true;
+  Install(4, AsyncLogBackend::Overflow::drop, [&] {
+    if (first) {
+      first = false;
+      entered.set_value();
+      released.wait();
+    }
+  });
+
+  BOOST_LOG_TRIVIAL(info) << "first";
+  entered.get_future().wait();  // the writer holds "first" and is stalled
+  for (int i = 0; i < 7; ++i) {
+    BOOST_LOG_TRIVIAL(info) << "queued " << i;
+  }
+  EXPECT_EQ(backend_->dropped(), 3u);
+  release.set_value();
+  logging::core::get()->flush();
+
+  auto lines = written();
+  ASSERT_EQ(lines.size(), 5u);
+  EXPECT_EQ(lines[0], "first");
+  EXPECT_EQ(lines[4], "queued 3");
+  std::lock_guard<std::mutex> lock(mutex_);
+  EXPECT_EQ(reported_drops_, 3u);
+}
+
+// test that a full queue makes the logging thread wait under the block policy
+TEST_F(AsyncLogBackendTest, BlocksWhenFull) {
+  std::promise<void> entered;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  bool first = true;
+  Install(4, AsyncLogBackend::Overflow::block, [&] {
+    if (first) {
+      first = false;
+      entered.set_value();
+      released.wait();
+    }
+  });
+
+  BOOST_LOG_TRIVIAL(info) << "first";
+  entered.get_future().wait();
+  std::thread producer([] {
+    for (int i = 0; i < 7; ++i) {
+      BOOST_LOG_TRIVIAL(info) << "queued " << i;
+    }
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  release.set_value();
+  producer.join();
+  logging::core::get()->flush();
+
+  auto lines = written();
+  ASSERT_EQ(lines.size(), 8u);
+  EXPECT_EQ(lines[7], "queued 6");
+  EXPECT_EQ(backend_->dropped(), 0u);
+}
@@ -0,0 +1,52 @@
+#!/usr/bin/env bash
+
+SERVER_EXEC="../build/bin/server"
+PORT=8080
+
+# Temp files
+CONFIG_FILE=$(mktemp)
+
+cleanup() {
+  rm -f "$CONFIG_FILE"
+}
+trap cleanup EXIT
+
+# expect_startup_failure <description>: the server must exit non-zero on
+# $CONFIG_FILE instead of starting with defaults
+expect_startup_failure() {
+  timeout 5 "$SERVER_EXEC" "$CONFIG_FILE" > /dev/null 2>&1
+  local status=$?
+  if [[ $status -eq 124 ]]; then
+    echo "FAIL: server started with $1"
+    exit 1
+  elif [[ $status -eq 0 ]]; then
+    echo "FAIL: server exited 0 with $1"
+    exit 1
+  fi
+  echo "PASS: server refused to start with $1"
+}
+
+echo "==== INVALID DIRECTIVE VALUE ===="
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+max_pipelined_requests 0;
+
+location /echo EchoHandler {}
+CONF
+expect_startup_failure "max_pipelined_requests 0"
+
+echo "==== INVALID HANDLER ARGUMENT ===="
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+
+location /sleep SleepHandler {
+  delay_ms abc;
+}
+CONF
+expect_startup_failure "delay_ms abc"
+
+echo "==== UNREADABLE CONFIG ===="
+rm -f "$CONFIG_FILE"
+expect_startup_failure "a missing config file"
+
+exit 0
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "byte_range.h"
+
+using Result = ByteRangeParser::Result;
+
+// test the three forms of a single range
+TEST(ByteRangeParserTest, SingleRanges) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("bytes=0-499", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{0, 499}}));
+
+  EXPECT_EQ(ByteRangeParser::parse("bytes=500-", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{500, 999}}));
+
+  EXPECT_EQ(ByteRangeParser::parse("bytes=-100", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{900, 999}}));
+  EXPECT_EQ(ranges[0].length(), 100u);
+}
+
+// test that ranges running past the end are clamped
+TEST(ByteRangeParserTest, ClampsToSize) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("bytes=900-5000", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{900, 999}}));
+
+  EXPECT_EQ(ByteRangeParser::parse("bytes=-5000", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{0, 999}}));
+
+  EXPECT_EQ(ByteRangeParser::parse("bytes=0-99999999999999999999999", 1000, ranges),
+            Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{0, 999}}));
+}
+
+// test several ranges, with whitespace and empty list elements
+TEST(ByteRangeParserTest, MultipleRanges) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("Bytes = 0-9, ,20-29 ,-5", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{0, 9}, {20, 29}, {995, 999}}));
+}
+
+// test that ranges wholly outside the file are dropped, and 416 when none remain
+TEST(ByteRangeParserTest, Unsatisfiable) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("bytes=1000-", 1000, ranges), Result::unsatisfiable);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=-0", 1000, ranges), Result::unsatisfiable);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=0-", 0, ranges), Result::unsatisfiable);
+  EXPECT_TRUE(ranges.empty());
+
+  EXPECT_EQ(ByteRangeParser::parse("bytes=2000-3000,0-0", 1000, ranges), Result::satisfiable);
+  EXPECT_EQ(ranges, (std::vector<ByteRange>{{0, 0}}));
+}
+
+// test that malformed or unsupported headers are ignored
+TEST(ByteRangeParserTest, Ignored) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("items=0-1", 1000, ranges), Result::ignored);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=", 1000, ranges), Result::ignored);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=abc", 1000, ranges), Result::ignored);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=5-1", 1000, ranges), Result::ignored);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=0-1,x-2", 1000, ranges), Result::ignored);
+  EXPECT_EQ(ByteRangeParser::parse("bytes=--1", 1000, ranges), Result::ignored);
+  EXPECT_TRUE(ranges.empty());
+}
+
+// test that overlapping ranges and too many ranges are ignored rather than served
+TEST(ByteRangeParserTest, AbusiveRangesIgnored) {
+  std::vector<ByteRange> ranges;
+  EXPECT_EQ(ByteRangeParser::parse("bytes=0-10,5-20", 1000, ranges), Result::ignored);
+
+  std::string many = "bytes=0-0";
+  for (std::size_t i = 1; i <= ByteRangeParser::kMaxRanges; ++i) {
+    many += "," + std::to_string(i * 2) + "-" + std::to_string(i * 2);
+  }
+  EXPECT_EQ(ByteRangeParser::parse(many, 1000, ranges), Result::ignored);
+  EXPECT_TRUE(ranges.empty());
+}
+
+// test the Content-Range values
+TEST(ByteRangeParserTest, ContentRange) {
+  EXPECT_EQ(ByteRangeParser::content_range({0, 499}, 1234), "bytes 0-499/1234");
+  EXPECT_EQ(ByteRangeParser::unsatisfied_range(1234), "bytes */1234");
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <memory>
+#include <string>
+#include <brotli/decode.h>
+#include "compression_middleware_handler.h"
+
+// Answers every request with a copy of a canned response
+class CannedHandler : public RequestHandler {
+public:
+    explicit CannedHandler(HttpResponse response) : response_(std::move(response)) {}
+    std::unique_ptr<HttpResponse> handle_request(const HttpRequest&) override {
+        return std::make_unique<HttpResponse>(response_);
+    }
+    std::string get_kName() override { return "CannedHandler"; }
+    bool is_thread_safe() const override { return true; }
+
+private:
+    HttpResponse response_;
+};
+
+class CompressionMiddlewareTest : public ::testing::Test {
+protected:
+    static HttpResponse Json(std::size_t size, int status = 200) {
+        HttpResponse res;
+        res.status_code = status;
+        res.headers["Content-Type"] = "application/json";
+        res.body = "[" + std::string(size - 2, '1') + "]";
+        return res;
+    }
+
+    static std::unique_ptr<HttpResponse> Run(HttpResponse canned, const std::string& accept) {
+        CompressionMiddlewareHandler handler(std::make_unique<CannedHandler>(std::move(canned)));
+        HttpRequest req;
+        req.method = "GET";
+        req.path = "/api/messages";
+        if (!accept.empty()) {
+            req.headers.add("Accept-Encoding", accept);
+        }
+        return handler.handle_request(req);
+    }
+
+    static std::string Unbrotli(const std::string& in) {
+        std::string out(1 << 20, '\0');
+        std::size_t size = out.size();
+        EXPECT_EQ(BrotliDecoderDecompress(in.size(), reinterpret_cast<const uint8_t*>(in.data()),
+                                          &size, reinterpret_cast<uint8_t*>(&out[0])),
+                  BROTLI_DECODER_RESULT_SUCCESS);
+        out.resize(size);
+        return out;
+    }
+};
+
+// test that a large JSON body is compressed with the preferred coding
+TEST_F(CompressionMiddlewareTest, CompressesLargeJson) {
+    HttpResponse canned = Json(4096);
+    auto res = Run(canned, "gzip, br");
+
+    EXPECT_EQ(res->status_code, 200);
+    EXPECT_EQ(res->headers["Content-Encoding"], "br");
+    EXPECT_EQ(res->headers["Vary"], "Accept-Encoding");
+    EXPECT_LT(res->body.size(), canned.body.size());
+    EXPECT_EQ(Unbrotli(res->body), canned.body);
+}
+
+// test that small bodies, clients without Accept-Encoding and errors are left alone
+TEST_F(CompressionMiddlewareTest, LeavesOthersAlone) {
+    auto small = Run(Json(100), "br");
+    EXPECT_EQ(small->headers.count("Content-Encoding"), 0u);
+    EXPECT_EQ(small->headers["Vary"], "Accept-Encoding");
+
+    auto no_accept = Run(Json(4096), "");
+    EXPECT_EQ(no_accept->headers.count("Content-Encoding"), 0u);
+    EXPECT_EQ(no_accept->body.size(), 4096u);
+    EXPECT_EQ(no_accept->headers["Vary"], "Accept-Encoding");
+
+    auto error = Run(Json(4096, 500), "br");
+    EXPECT_EQ(error->headers.count("Content-Encoding"), 0u);
+
+    HttpResponse png = Json(4096);
+    png.headers["Content-Type"] = "image/png";
+    auto image = Run(png, "br");
+    EXPECT_EQ(image->headers.count("Content-Encoding"), 0u);
+    EXPECT_EQ(image->headers.count("Vary"), 0u);
+}
+
+// test that an existing Vary header is extended and ETags become variant-specific
+TEST_F(CompressionMiddlewareTest, VaryAndETag) {
+    HttpResponse canned = Json(4096);
+    canned.headers.add("Vary", "Cookie");
+    canned.headers.add("ETag", "\"v1\"");
+    auto res = Run(canned, "gzip");
+
+    EXPECT_EQ(res->headers["Content-Encoding"], "gzip");
+    EXPECT_EQ(res->headers["Vary"], "Cookie, Accept-Encoding");
+    EXPECT_EQ(res->headers["ETag"], "\"v1-gzip\"");
+}
+
+// test that the async path compresses too and keeps the wrapped handler's name
+TEST_F(CompressionMiddlewareTest, AsyncAndName) {
+    CompressionMiddlewareHandler handler(std::make_unique<CannedHandler>(Json(4096)));
+    EXPECT_EQ(handler.get_kName(), "CannedHandler");
+    EXPECT_TRUE(handler.is_thread_safe());
+
+    boost::asio::io_context io;
+    HttpRequest req;
+    req.headers.add("Accept-Encoding", "br");
+    std::unique_ptr<HttpResponse> res;
+    handler.handle_request_async(req, io.get_executor(),
+        [&res](std::unique_ptr<HttpResponse> r) { res = std::move(r); });
+    ASSERT_NE(res, nullptr);
+    EXPECT_EQ(res->headers["Content-Encoding"], "br");
+}
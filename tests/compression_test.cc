@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <brotli/decode.h>
+#include <zlib.h>
+#include "compression.h"
+
+namespace {
+  std::string Gunzip(const std::string& in) {
+    z_stream zs = {};
+    EXPECT_EQ(inflateInit2(&zs, 15 + 16), Z_OK);
+    std::string out(1 << 20, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    EXPECT_EQ(inflate(&zs, Z_FINISH), Z_STREAM_END);
+    out.resize(zs.total_out);
+    inflateEnd(&zs);
+    return out;
+  }
+
+  std::string Unbrotli(const std::string& in) {
+    std::string out(1 << 20, '\0');
+    std::size_t size = out.size();
+    EXPECT_EQ(BrotliDecoderDecompress(in.size(), reinterpret_cast<const uint8_t*>(in.data()),
+                                      &size, reinterpret_cast<uint8_t*>(&out[0])),
+              BROTLI_DECODER_RESULT_SUCCESS);
+    out.resize(size);
+    return out;
+  }
+
+  std::string SampleJson() {
+    std::string json = "[";
+    for (int i = 0; i < 200; ++i) {
+      json += "{\"user\":\"user" + std::to_string(i % 7) + "\",\"text\":\"hello world\"},";
+    }
+    json.back() = ']';
+    return json;
+  }
+}
+
+using Codings = std::vector<ContentCoding>;
+
+// test Accept-Encoding negotiation
+TEST(CompressionTest, Accepted) {
+  EXPECT_EQ(Compression::accepted("gzip, deflate, br"), (Codings{ContentCoding::br, ContentCoding::gzip}));
+  EXPECT_EQ(Compression::accepted("gzip"), (Codings{ContentCoding::gzip}));
+  EXPECT_EQ(Compression::accepted("br;q=0.5, gzip;q=0.8"), (Codings{ContentCoding::gzip, ContentCoding::br}));
+  EXPECT_EQ(Compression::accepted("GZIP;Q=1, br;q=0"), (Codings{ContentCoding::gzip}));
+  EXPECT_EQ(Compression::accepted("*"), (Codings{ContentCoding::br, ContentCoding::gzip}));
+  EXPECT_EQ(Compression::accepted("*;q=0.1, gzip"), (Codings{ContentCoding::gzip, ContentCoding::br}));
+  EXPECT_EQ(Compression::accepted("x-gzip"), (Codings{ContentCoding::gzip}));
+  EXPECT_TRUE(Compression::accepted("identity").empty());
+  EXPECT_TRUE(Compression::accepted("").empty());
+  EXPECT_TRUE(Compression::accepted("gzip;q=bogus").empty());
+}
+
+// test which content types are compressed
+TEST(CompressionTest, Compressible) {
+  EXPECT_TRUE(Compression::compressible("text/html"));
+  EXPECT_TRUE(Compression::compressible("text/plain; charset=utf-8"));
+  EXPECT_TRUE(Compression::compressible("application/json"));
+  EXPECT_TRUE(Compression::compressible("application/problem+json"));
+  EXPECT_TRUE(Compression::compressible("image/svg+xml"));
+  EXPECT_FALSE(Compression::compressible("image/png"));
+  EXPECT_FALSE(Compression::compressible("application/zip"));
+  EXPECT_FALSE(Compression::compressible(""));
+}
+
+// test that both encoders round-trip at both levels and shrink repetitive JSON
+TEST(CompressionTest, RoundTrip) {
+  std::string json = SampleJson();
+  for (auto level : {Compression::Level::fast, Compression::Level::best}) {
+    std::string gz;
+    ASSERT_TRUE(Compression::compress(ContentCoding::gzip, json, gz, level));
+    EXPECT_LT(gz.size() * 5, json.size());
+    EXPECT_EQ(Gunzip(gz), json);
+
+    std::string br;
+    ASSERT_TRUE(Compression::compress(ContentCoding::br, json, br, level));
+    EXPECT_LT(br.size() * 5, json.size());
+    EXPECT_EQ(Unbrotli(br), json);
+  }
+
+  std::string empty;
+  ASSERT_TRUE(Compression::compress(ContentCoding::br, "", empty));
+  EXPECT_EQ(Unbrotli(empty), "");
+}
+
+// test tokens, sibling extensions and variant ETags
+TEST(CompressionTest, Names) {
+  EXPECT_STREQ(Compression::token(ContentCoding::gzip), "gzip");
+  EXPECT_STREQ(Compression::token(ContentCoding::br), "br");
+  EXPECT_STREQ(Compression::extension(ContentCoding::gzip), ".gz");
+  EXPECT_STREQ(Compression::extension(ContentCoding::br), ".br");
+  EXPECT_EQ(Compression::variant_etag("\"abc\"", ContentCoding::br), "\"abc-br\"");
+  EXPECT_EQ(Compression::variant_etag("\"abc\"", ContentCoding::gzip), "\"abc-gzip\"");
+}
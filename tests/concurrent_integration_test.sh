@@ -14,6 +14,10 @@ port $PORT;
 
 location /sleep SleepHandler {}
 
+location /shortsleep SleepHandler {
+  delay_ms 1000;
+}
+
 location /echo EchoHandler {}
 EOF
 
@@ -54,3 +58,33 @@ else
   cat "$RESPONSE_FILE"
   exit 1
 fi
+
+echo "==== MANY CONCURRENT SLEEPS TEST ===="
+
+# Sleeps wait on timers, so hundreds of them must overlap instead of
+# queueing behind the worker threads (which would take minutes).
+SLEEP_COUNT=300
+URLS=()
+for i in $(seq 1 $SLEEP_COUNT); do
+  URLS+=(-o /dev/null "http://localhost:$PORT/shortsleep")
+done
+
+START=$(date +%s.%N)
+curl -s --no-progress-meter --parallel --parallel-immediate --parallel-max $SLEEP_COUNT \
+  -w "%{http_code}\n" "${URLS[@]}" > "$RESPONSE_FILE"
+END=$(date +%s.%N)
+ELAPSED=$(echo "$END - $START" | bc)
+OK_COUNT=$(grep -c '^200$' "$RESPONSE_FILE" || true)
+
+echo "$OK_COUNT/$SLEEP_COUNT sleeps answered in $ELAPSED seconds"
+
+if [ "$OK_COUNT" -ne "$SLEEP_COUNT" ]; then
+  echo "FAIL: only $OK_COUNT of $SLEEP_COUNT sleeps succeeded"
+  exit 1
+fi
+if (( $(echo "$ELAPSED < 5.0" | bc -l) )); then
+  echo "PASS: $SLEEP_COUNT concurrent sleeps overlapped"
+else
+  echo "FAIL: concurrent sleeps were serialized (elapsed: $ELAPSED)"
+  exit 1
+fi
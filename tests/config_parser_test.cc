@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include "config_parser.h"
+#include "dispatcher.h"
+#include <cstdio>
+#include <fstream>
 
 // test fixture for config parser tests
 class NginxConfigParserTest : public ::testing::Test {
@@ -393,6 +396,313 @@ TEST_F(NginxConfigParserTest, WhitespaceVariations) {
   EXPECT_EQ(config.statements_[0]->tokens_[1], "bar");
 }
 
+// ========================================
+// Server Directive Tests
+// ========================================
+
+// test keep-alive directives are parsed into the server config
+TEST(ParseConfigTest, KeepaliveDirectives) {
+  const char* file_name = "keepalive_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nkeepalive_timeout 12;\nkeepalive_requests 7;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(port, 8080);
+  EXPECT_EQ(server_config.keepalive_timeout, 12);
+  EXPECT_EQ(server_config.keepalive_requests, 7);
+  std::remove(file_name);
+}
+
+// test keep-alive defaults when the directives are absent
+TEST(ParseConfigTest, KeepaliveDefaults) {
+  const char* file_name = "keepalive_default_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.keepalive_timeout, 5);
+  EXPECT_EQ(server_config.keepalive_requests, 100);
+  std::remove(file_name);
+}
+
+// test the threading directives
+TEST(ParseConfigTest, ThreadingDirectives) {
+  const char* file_name = "threading_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nthreads 8;\nio_model per_core;\nreuse_port on;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.threads, 8u);
+  EXPECT_EQ(server_config.io_model, ServerConfig::IoModel::per_core);
+  EXPECT_TRUE(server_config.reuse_port);
+  std::remove(file_name);
+}
+
+// test the static file cache directives and their defaults
+TEST(ParseConfigTest, StaticCacheSize) {
+  const char* file_name = "static_cache_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\n";
+  }
+  int port = 0;
+  ServerConfig defaults;
+  EXPECT_TRUE(parseConfig(file_name, port, defaults));
+  EXPECT_EQ(defaults.static_cache_size, 64u * 1024 * 1024);
+  EXPECT_EQ(defaults.static_mmap_max_size, 64u * 1024 * 1024);
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nstatic_cache_size 0;\nstatic_mmap_max_size 1048576;\n";
+  }
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.static_cache_size, 0u);
+  EXPECT_EQ(server_config.static_mmap_max_size, 1048576u);
+  std::remove(file_name);
+}
+
+// test that a types block maps each listed extension to its type
+TEST(ParseConfigTest, TypesBlock) {
+  const char* file_name = "types_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\ntypes {\n  model/gltf-binary glb;\n  text/x-c c h;\n}\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  using Pair = std::pair<std::string, std::string>;
+  EXPECT_EQ(server_config.mime_types, (std::vector<Pair>{{"glb", "model/gltf-binary"},
+                                                         {"c", "text/x-c"},
+                                                         {"h", "text/x-c"}}));
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\ntypes {\n  text/plain;\n}\n";
+  }
+  ServerConfig bad;
+  EXPECT_FALSE(parseConfig(file_name, port, bad));
+  std::remove(file_name);
+}
+
+// test the logging directives
+TEST(ParseConfigTest, LogOptions) {
+  const char* file_name = "log_options_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nlog_async on;\nlog_queue_size 1024;\nlog_overflow block;\n"
+        << "log_level info;\nlog_sample_every 100;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_TRUE(server_config.log.async);
+  EXPECT_EQ(server_config.log.queue_size, 1024u);
+  EXPECT_EQ(server_config.log.overflow, LogOptions::Overflow::block);
+  EXPECT_EQ(server_config.log.level, boost::log::trivial::info);
+  EXPECT_EQ(server_config.log.sample_every, 100u);
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nlog_overflow sometimes;\n";
+  }
+  ServerConfig bad;
+  EXPECT_FALSE(parseConfig(file_name, port, bad));
+  EXPECT_FALSE(bad.log.async);
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nlog_level chatty;\n";
+  }
+  EXPECT_FALSE(parseConfig(file_name, port, bad));
+  std::remove(file_name);
+}
+
+// test the access log directives
+TEST(ParseConfigTest, AccessLog) {
+  const char* file_name = "access_log_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\naccess_log /var/log/server;\naccess_log_segment_size 1048576;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.access_log_dir, "/var/log/server");
+  EXPECT_EQ(server_config.access_log_segment_size, 1048576u);
+  std::remove(file_name);
+
+  ServerConfig defaults;
+  EXPECT_TRUE(defaults.access_log_dir.empty());
+}
+
+// test that numeric directives reject zero where it would stall, negative
+// and non-numeric values, and overflow
+TEST(ParseConfigTest, InvalidNumbersRejected) {
+  const char* file_name = "invalid_numbers_test_config";
+  const char* const bad[] = {
+    "max_pipelined_requests 0;", "max_pipelined_requests -1;", "max_pipelined_requests many;",
+    "threads -2;", "threads 4x;", "static_cache_size -1;", "static_mmap_max_size 1e6;",
+    "access_log_segment_size 0;", "keepalive_requests 0;", "keepalive_timeout 99999999999;",
+    "max_header_size 0;", "log_queue_size 0;", "log_sample_every 0;",
+    "max_body_size 99999999999999999999999;",
+  };
+  for (const char* directive : bad) {
+    {
+      std::ofstream out(file_name);
+      out << "port 8080;\n" << directive << "\n";
+    }
+    int port = 0;
+    ServerConfig server_config;
+    EXPECT_FALSE(parseConfig(file_name, port, server_config)) << directive;
+  }
+
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nmax_pipelined_requests 1;\nthreads 0;\nstatic_cache_size 0;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.max_pipelined_requests, 1u);
+  EXPECT_EQ(server_config.threads, 0u);
+  EXPECT_EQ(server_config.static_cache_size, 0u);
+  std::remove(file_name);
+}
+
+// test that on/off directives accept nothing else
+TEST(ParseConfigTest, InvalidSwitchesRejected) {
+  const char* file_name = "invalid_switches_test_config";
+  const char* const bad[] = {
+    "reuse_port yes;", "reuse_port ON;", "reuse_port 1;",
+    "log_async true;", "log_async of;",
+    "server_timing enabled;", "server_timing 0;",
+  };
+  for (const char* directive : bad) {
+    {
+      std::ofstream out(file_name);
+      out << "port 8080;\n" << directive << "\n";
+    }
+    int port = 0;
+    ServerConfig server_config;
+    EXPECT_FALSE(parseConfig(file_name, port, server_config)) << directive;
+  }
+
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nreuse_port off;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  server_config.reuse_port = true;
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_FALSE(server_config.reuse_port);
+  std::remove(file_name);
+}
+
+// test the server_timing switch
+TEST(ParseConfigTest, ServerTiming) {
+  const char* file_name = "server_timing_test_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nserver_timing on;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_FALSE(server_config.server_timing);
+  EXPECT_TRUE(parseConfig(file_name, port, server_config));
+  EXPECT_TRUE(server_config.server_timing);
+  std::remove(file_name);
+}
+
+// test that an unknown io_model is rejected
+TEST(ParseConfigTest, UnknownIoModelRejected) {
+  const char* file_name = "bad_io_model_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\nio_model fibers;\n";
+  }
+  int port = 0;
+  ServerConfig server_config;
+  EXPECT_FALSE(parseConfig(file_name, port, server_config));
+  EXPECT_EQ(server_config.threads, 0u);
+  EXPECT_EQ(server_config.io_model, ServerConfig::IoModel::shared);
+  std::remove(file_name);
+}
+
+// test that method-limited locations route by method and share a path
+TEST(ParseConfigTest, MethodRoutes) {
+  const char* file_name = "method_routes_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\n"
+        << "location /things EchoHandler {\n  methods GET HEAD;\n}\n"
+        << "location /things NotFoundHandler {\n  methods POST;\n}\n";
+  }
+  int port = 0;
+  EXPECT_TRUE(parseConfig(file_name, port));
+  RequestHandler* get = Dispatcher::match("/things", "GET");
+  RequestHandler* post = Dispatcher::match("/things", "POST");
+  ASSERT_NE(get, nullptr);
+  ASSERT_NE(post, nullptr);
+  EXPECT_EQ(get->get_kName(), "EchoHandler");
+  EXPECT_EQ(post->get_kName(), "NotFoundHandler");
+
+  std::vector<std::string> allowed;
+  EXPECT_EQ(Dispatcher::match("/things", "DELETE", nullptr, &allowed), nullptr);
+  EXPECT_EQ(allowed, (std::vector<std::string>{"GET", "HEAD", "POST"}));
+  std::remove(file_name);
+}
+
+// test that overlapping methods on one path are rejected
+TEST(ParseConfigTest, OverlappingMethodRoutesRejected) {
+  const char* file_name = "overlapping_methods_config";
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\n"
+        << "location /things EchoHandler {\n  methods GET;\n}\n"
+        << "location /things EchoHandler {\n}\n";
+  }
+  int port = 0;
+  EXPECT_FALSE(parseConfig(file_name, port));
+  std::remove(file_name);
+}
+
+// test that paths reaching the same route under different spellings are rejected
+TEST(ParseConfigTest, EquivalentLocationPathsRejected) {
+  const char* file_name = "equivalent_paths_config";
+  const char* const pairs[][2] = {
+    {"/a", "//a"}, {"/a/b", "/a//b"}, {"/items/:id", "/items/:name"},
+  };
+  for (const auto& pair : pairs) {
+    {
+      std::ofstream out(file_name);
+      out << "port 8080;\n"
+          << "location " << pair[0] << " EchoHandler {\n}\n"
+          << "location " << pair[1] << " EchoHandler {\n}\n";
+    }
+    int port = 0;
+    EXPECT_FALSE(parseConfig(file_name, port)) << pair[0] << " and " << pair[1];
+  }
+
+  {
+    std::ofstream out(file_name);
+    out << "port 8080;\n"
+        << "location /a EchoHandler {\n}\n"
+        << "location /a/b EchoHandler {\n}\n"
+        << "location /a/:id EchoHandler {\n}\n";
+  }
+  int port = 0;
+  EXPECT_TRUE(parseConfig(file_name, port));
+  std::remove(file_name);
+}
+
 // add more tests if necessary
 
 /*
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <functional>
+#include <thread>
 #include "dispatcher.h"
 #include "request_handler.h"
 
@@ -27,3 +28,96 @@ TEST(DispatcherTest, LongestMatch) {
     Dispatcher::registerRoute("/foo/bar/baz", []() {return nullptr;});
     Dispatcher::match("/foo/bar");
 }
+
+namespace {
+  class CountingHandler : public RequestHandler {
+  public:
+    explicit CountingHandler(bool thread_safe) : thread_safe_(thread_safe) {}
+    std::unique_ptr<HttpResponse> handle_request(const HttpRequest&) override {
+      return std::make_unique<HttpResponse>();
+    }
+    std::string get_kName() override { return "CountingHandler"; }
+    bool is_thread_safe() const override { return thread_safe_; }
+  private:
+    bool thread_safe_;
+  };
+}
+
+TEST(DispatcherTest, ThreadSafeHandlerIsBuiltOnce) {
+    int created = 0;
+    Dispatcher::registerRoute("/shared", [&created]() {
+        ++created;
+        return std::make_unique<CountingHandler>(true);
+    });
+
+    RequestHandler* first = Dispatcher::match("/shared/a");
+    RequestHandler* second = Dispatcher::match("/shared/b");
+    RequestHandler* other_thread = nullptr;
+    std::thread([&other_thread]() { other_thread = Dispatcher::match("/shared"); }).join();
+
+    EXPECT_EQ(created, 1);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first, other_thread);
+}
+
+TEST(DispatcherTest, UnsafeHandlerIsBuiltOncePerThread) {
+    int created = 0;
+    Dispatcher::registerRoute("/unsafe", [&created]() {
+        ++created;
+        return std::make_unique<CountingHandler>(false);
+    });
+    EXPECT_EQ(created, 1);  // probed once at registration
+
+    RequestHandler* first = Dispatcher::match("/unsafe");
+    RequestHandler* second = Dispatcher::match("/unsafe");
+    RequestHandler* other_thread = nullptr;
+    std::thread([&other_thread]() { other_thread = Dispatcher::match("/unsafe"); }).join();
+
+    EXPECT_EQ(created, 3);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other_thread);
+}
+
+TEST(DispatcherTest, ReRegisteringReplacesHandler) {
+    Dispatcher::registerRoute("/swap", []() { return std::make_unique<CountingHandler>(false); });
+    RequestHandler* before = Dispatcher::match("/swap");
+    Dispatcher::registerRoute("/swap", []() { return std::make_unique<CountingHandler>(true); });
+    RequestHandler* after = Dispatcher::match("/swap");
+
+    ASSERT_NE(after, nullptr);
+    EXPECT_NE(before, after);
+    EXPECT_TRUE(after->is_thread_safe());
+}
+
+TEST(DispatcherTest, RegisterReportsMissingHandler) {
+    EXPECT_TRUE(Dispatcher::registerRoute("/built", []() { return std::make_unique<CountingHandler>(true); }));
+    EXPECT_FALSE(Dispatcher::registerRoute("/unbuilt", []() { return nullptr; }));
+}
+
+TEST(DispatcherTest, MatchReportsRoute) {
+    Dispatcher::registerRoute("/reports/:id", []() { return std::make_unique<CountingHandler>(true); }, {"GET"});
+
+    std::string route = "unset";
+    ASSERT_NE(Dispatcher::match("/reports/7/pdf", "GET", nullptr, nullptr, &route), nullptr);
+    EXPECT_EQ(route, "/reports/:id");
+
+    route = "unset";
+    EXPECT_EQ(Dispatcher::match("/reports/7", "POST", nullptr, nullptr, &route), nullptr);
+    EXPECT_EQ(route, "unset");
+}
+
+TEST(DispatcherTest, MatchFillsPathParams) {
+    Dispatcher::registerRoute("/items/:id", []() { return std::make_unique<CountingHandler>(true); }, {"GET"});
+
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/items/17";
+    ASSERT_NE(Dispatcher::match(req), nullptr);
+    EXPECT_EQ(req.path_params.at("id"), "17");
+
+    req.method = "DELETE";
+    req.path = "/items/17";
+    EXPECT_NE(Dispatcher::match(req), Dispatcher::match("/items/17", "GET"));
+}
@@ -69,7 +69,7 @@ TEST(EchoHandlerTest, HandleGetAndReturnResponseMock) {
 
     std::unique_ptr<HttpResponse> out = mock.handle_request(req);
     EXPECT_EQ(out->status_code, 200);
-    EXPECT_EQ(out->headers, (std::map<std::string,std::string>{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
+    EXPECT_EQ(out->headers, (HttpHeaders{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
     EXPECT_EQ(out->body,        req.raw);
     EXPECT_EQ(out->body.size(), req.raw.size());
 
@@ -102,7 +102,7 @@ TEST(EchoHandlerTest, HandleGetSpecialCharacterAndReturnResponseMock) {
 
     std::unique_ptr<HttpResponse> out = mock.handle_request(req);
     EXPECT_EQ(out->status_code, 200);
-    EXPECT_EQ(out->headers, (std::map<std::string,std::string>{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
+    EXPECT_EQ(out->headers, (HttpHeaders{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
     EXPECT_EQ(out->body,        req.raw);
     EXPECT_EQ(out->body.size(), req.raw.size());
 
@@ -125,7 +125,7 @@ TEST(EchoHandlerTest, HandleEmptyAndReturnResponseMock) {
 
     std::unique_ptr<HttpResponse> out = mock.handle_request(req);
     EXPECT_EQ(out->status_code, 200);
-    EXPECT_EQ(out->headers, (std::map<std::string,std::string>{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
+    EXPECT_EQ(out->headers, (HttpHeaders{{"Content-Type", "text/plain"},{"Content-Length", std::to_string(req.raw.size())}}));
     EXPECT_EQ(out->body,        req.raw);
     EXPECT_EQ(out->body.size(), req.raw.size());
 
@@ -149,4 +149,9 @@ TEST_F(DoEchoTest, EmptyRaw) {
   EXPECT_EQ(resp->body,        "");
   EXPECT_EQ(resp->headers["Content-Type"],   "text/plain");
   EXPECT_EQ(resp->headers["Content-Length"], "0");
-}
\ No newline at end of file
+}
+// test that the session is told to keep the raw request for echo
+TEST(EchoHandlerTest, NeedsRawRequest) {
+  EchoHandler handler("/echo");
+  EXPECT_TRUE(handler.needs_raw_request());
+}
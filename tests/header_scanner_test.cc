@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "header_scanner.h"
+
+namespace {
+  const HeaderScanner::Kernel kKernels[] = {
+    HeaderScanner::Kernel::scalar,
+    HeaderScanner::Kernel::sse42,
+    HeaderScanner::Kernel::avx2,
+  };
+}
+
+// run every test body once per kernel this CPU supports
+class HeaderScannerTest : public ::testing::TestWithParam<HeaderScanner::Kernel> {
+protected:
+  void SetUp() override {
+    original_ = HeaderScanner::kernel();
+    if (!HeaderScanner::set_kernel(GetParam())) {
+      GTEST_SKIP() << HeaderScanner::kernel_name(GetParam()) << " not supported on this CPU";
+    }
+  }
+
+  void TearDown() override {
+    HeaderScanner::set_kernel(original_);
+  }
+
+  HeaderScanner::Kernel original_;
+};
+
+// test scalar is always available
+TEST(HeaderScannerSupportTest, ScalarAlwaysSupported) {
+  EXPECT_TRUE(HeaderScanner::supported(HeaderScanner::Kernel::scalar));
+}
+
+// test the terminator is found at the right offset
+TEST_P(HeaderScannerTest, FindsHeaderEnd) {
+  std::string head = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\nbody";
+  EXPECT_EQ(HeaderScanner::find_header_end(head.data(), head.size()), head.find("\r\n\r\n"));
+}
+
+// test a missing terminator reports the buffer length
+TEST_P(HeaderScannerTest, MissingHeaderEnd) {
+  std::string head = "GET / HTTP/1.1\r\nHost: example.com\r\n\r";
+  EXPECT_EQ(HeaderScanner::find_header_end(head.data(), head.size()), head.size());
+}
+
+// test a terminator straddling the 16/32-byte block boundary
+TEST_P(HeaderScannerTest, HeaderEndAcrossBlockBoundary) {
+  for (std::size_t prefix = 0; prefix < 70; ++prefix) {
+    std::string head(prefix, 'a');
+    head += "\r\n\r\n";
+    head += std::string(5, 'b');
+    EXPECT_EQ(HeaderScanner::find_header_end(head.data(), head.size()), prefix);
+  }
+}
+
+// test a long cookie header with many lone carriage returns before the terminator
+TEST_P(HeaderScannerTest, LongHeaderWithDecoys) {
+  std::string head = "GET / HTTP/1.1\r\nCookie: " + std::string(500, 'c') + "\r\n";
+  for (int i = 0; i < 20; ++i) head += "X-H" + std::to_string(i) + ": v\r\n";
+  std::size_t expected = head.size() - 2;
+  head += "\r\n";
+  EXPECT_EQ(HeaderScanner::find_header_end(head.data(), head.size()), expected);
+}
+
+// test single character search matches std::string::find
+TEST_P(HeaderScannerTest, FindCharMatchesStdFind) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> byte('a', 'z');
+  for (std::size_t len = 0; len < 100; ++len) {
+    std::string s(len, 'x');
+    for (auto& c : s) c = static_cast<char>(byte(gen));
+    std::size_t expected = s.find(':');
+    std::size_t got = HeaderScanner::find_char(s.data(), s.size(), ':');
+    EXPECT_EQ(got, expected == std::string::npos ? s.size() : expected);
+    if (len > 0) {
+      s[len / 2] = ':';
+      EXPECT_EQ(HeaderScanner::find_char(s.data(), s.size(), ':'), s.find(':'));
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllKernels, HeaderScannerTest, ::testing::ValuesIn(kKernels),
+  [](const ::testing::TestParamInfo<HeaderScanner::Kernel>& info) {
+    switch (info.param) {
+      case HeaderScanner::Kernel::scalar: return std::string("Scalar");
+      case HeaderScanner::Kernel::sse42:  return std::string("Sse42");
+      case HeaderScanner::Kernel::avx2:   return std::string("Avx2");
+    }
+    return std::string("Unknown");
+  });
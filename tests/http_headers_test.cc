@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "http_headers.h"
+
+// test case-insensitive lookup of well-known and custom names
+TEST(HttpHeadersTest, LookupIsCaseInsensitive) {
+  HttpHeaders headers;
+  headers.add("cookie", "session=abc");
+  headers.add("X-Request-Id", "42");
+
+  auto it = headers.find("Cookie");
+  ASSERT_NE(it, headers.end());
+  EXPECT_EQ(it->second, "session=abc");
+  EXPECT_NE(headers.find(HeaderId::cookie), headers.end());
+  EXPECT_EQ(headers.find("x-request-id")->second, "42");
+  EXPECT_EQ(headers.find("X-Missing"), headers.end());
+}
+
+// test that well-known names are interned and others are not
+TEST(HttpHeadersTest, InternsWellKnownNames) {
+  EXPECT_EQ(HttpHeaders::lookup_id("content-TYPE"), HeaderId::content_type);
+  EXPECT_EQ(HttpHeaders::lookup_id("Content-Length"), HeaderId::content_length);
+  EXPECT_EQ(HttpHeaders::lookup_id("SET-COOKIE"), HeaderId::set_cookie);
+  EXPECT_EQ(HttpHeaders::lookup_id("Authorization"), HeaderId::authorization);
+  EXPECT_EQ(HttpHeaders::lookup_id("Content-Typo"), HeaderId::other);
+  EXPECT_EQ(HttpHeaders::lookup_id(""), HeaderId::other);
+}
+
+// test that repeated fields are kept in order
+TEST(HttpHeadersTest, KeepsRepeatedFields) {
+  HttpHeaders headers;
+  headers.add("Set-Cookie", "a=1");
+  headers.add("Content-Type", "text/plain");
+  headers.add("set-cookie", "b=2");
+
+  EXPECT_EQ(headers.size(), 3u);
+  EXPECT_EQ(headers.count("Set-Cookie"), 2u);
+  auto values = headers.values("SET-COOKIE");
+  ASSERT_EQ(values.size(), 2u);
+  EXPECT_EQ(values[0], "a=1");
+  EXPECT_EQ(values[1], "b=2");
+  EXPECT_EQ(headers["Set-Cookie"], "a=1");
+}
+
+// test that operator[] updates the first match or appends a new field
+TEST(HttpHeadersTest, SubscriptInsertsOrUpdates) {
+  HttpHeaders headers;
+  headers["Content-Type"] = "text/html";
+  headers["content-type"] = "text/plain";
+  headers["X-Custom"] = "1";
+
+  ASSERT_EQ(headers.size(), 2u);
+  EXPECT_EQ(headers.begin()->first, "Content-Type");
+  EXPECT_EQ(headers.begin()->second, "text/plain");
+}
+
+// test set and erase across repeated fields
+TEST(HttpHeadersTest, SetReplacesAllAndEraseRemovesAll) {
+  HttpHeaders headers{{"Vary", "a"}, {"Host", "example.com"}, {"vary", "b"}};
+
+  headers.set("VARY", "c");
+  EXPECT_EQ(headers.count("Vary"), 1u);
+  EXPECT_EQ(headers["Vary"], "c");
+  EXPECT_EQ(headers.find(HeaderId::host)->second, "example.com");
+
+  EXPECT_EQ(headers.erase("host"), 1u);
+  EXPECT_EQ(headers.find(HeaderId::host), headers.end());
+  EXPECT_EQ(headers.size(), 1u);
+}
+
+// test equality is ordered and ignores name case
+TEST(HttpHeadersTest, Equality) {
+  HttpHeaders a{{"Content-Type", "text/plain"}, {"X-A", "1"}};
+  HttpHeaders b{{"content-type", "text/plain"}, {"x-a", "1"}};
+  HttpHeaders c{{"X-A", "1"}, {"Content-Type", "text/plain"}};
+
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+  a.clear();
+  EXPECT_TRUE(a.empty());
+}
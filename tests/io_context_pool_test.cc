@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "io_context_pool.h"
+
+// test that the shared model runs every thread on one context
+TEST(IoContextPoolTest, SharedModelHasOneContext) {
+  IoContextPool pool(3, ServerConfig::IoModel::shared);
+  EXPECT_EQ(pool.threads(), 3u);
+  EXPECT_EQ(pool.contexts(), 1u);
+  EXPECT_EQ(&pool.next(), &pool.next());
+}
+
+// test that the per-core model hands out its contexts round-robin
+TEST(IoContextPoolTest, PerCoreModelRoundRobins) {
+  IoContextPool pool(3, ServerConfig::IoModel::per_core);
+  EXPECT_EQ(pool.contexts(), 3u);
+  boost::asio::io_context* first = &pool.next();
+  boost::asio::io_context* second = &pool.next();
+  boost::asio::io_context* third = &pool.next();
+  EXPECT_NE(first, second);
+  EXPECT_NE(second, third);
+  EXPECT_EQ(first, &pool.next());
+}
+
+// test that zero threads means one per hardware thread
+TEST(IoContextPoolTest, DefaultsToHardwareConcurrency) {
+  std::size_t expected = std::max(1u, std::thread::hardware_concurrency());
+  EXPECT_EQ(IoContextPool::resolve_threads(0), expected);
+  EXPECT_EQ(IoContextPool::resolve_threads(5), 5u);
+}
+
+// test that each per-core context is run by its own thread, and that stop() ends run()
+TEST(IoContextPoolTest, RunsEachContextOnItsOwnThread) {
+  IoContextPool pool(2, ServerConfig::IoModel::per_core);
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::atomic<int> remaining{2};
+  for (std::size_t i = 0; i < pool.contexts(); ++i) {
+    boost::asio::post(pool.context(i), [&]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+      }
+      if (--remaining == 0) {
+        pool.stop();
+      }
+    });
+  }
+  pool.run();
+  EXPECT_EQ(ids.size(), 2u);
+}
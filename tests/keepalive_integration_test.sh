@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+set -e
+
+SERVER_EXEC="../build/bin/server"
+PORT=8080
+
+# Temp files
+CONFIG_FILE=$(mktemp)
+RESPONSE_FILE=$(mktemp)
+TRACE_FILE=$(mktemp)
+
+# Short idle timeout and a two-request cap so both limits can be observed
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+keepalive_timeout 1;
+keepalive_requests 2;
+
+location /echo EchoHandler {}
+CONF
+
+# Start server in background
+"$SERVER_EXEC" "$CONFIG_FILE" &
+SERVER_PID=$!
+
+cleanup() {
+  kill $SERVER_PID 2>/dev/null || true
+  rm -f "$CONFIG_FILE" "$RESPONSE_FILE" "$TRACE_FILE"
+}
+trap cleanup EXIT
+
+# give the server a moment to bind the socket
+sleep 0.1
+
+echo "==== CONNECTION REUSE ===="
+# curl reuses one connection for several URLs when the server keeps it open
+curl -s -v "http://localhost:$PORT/echo" "http://localhost:$PORT/echo" \
+     -o /dev/null -o /dev/null 2> "$TRACE_FILE"
+if grep -q "Re-using existing connection" "$TRACE_FILE"; then
+  echo "PASS: second request reused the connection"
+else
+  echo "FAIL: connection was not reused"
+  cat "$TRACE_FILE"
+  exit 1
+fi
+
+echo "==== MAX REQUESTS PER CONNECTION ===="
+# The second response on a connection must announce the close
+curl -s -v "http://localhost:$PORT/echo" "http://localhost:$PORT/echo" \
+     -o /dev/null -o /dev/null 2> "$TRACE_FILE"
+if grep -i -q "< Connection: close" "$TRACE_FILE"; then
+  echo "PASS: connection closed after keepalive_requests"
+else
+  echo "FAIL: missing Connection: close after keepalive_requests"
+  cat "$TRACE_FILE"
+  exit 1
+fi
+
+echo "==== CONNECTION: CLOSE ===="
+curl -s -i -H "Connection: close" "http://localhost:$PORT/echo" -o "$RESPONSE_FILE"
+if grep -i -q "^Connection: close" "$RESPONSE_FILE"; then
+  echo "PASS: Connection: close honoured"
+else
+  echo "FAIL: Connection: close not honoured"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+echo "==== IDLE TIMEOUT ===="
+# Open a connection, send nothing, and expect the server to hang up
+exec 3<>/dev/tcp/localhost/$PORT
+START=$(date +%s.%N)
+cat <&3 > /dev/null
+END=$(date +%s.%N)
+exec 3<&-
+exec 3>&-
+ELAPSED=$(echo "$END - $START" | bc)
+if (( $(echo "$ELAPSED < 3.0" | bc -l) )); then
+  echo "PASS: idle connection closed after $ELAPSED seconds"
+else
+  echo "FAIL: idle connection held for $ELAPSED seconds"
+  exit 1
+fi
+
+exit 0
@@ -0,0 +1,63 @@
+#!/usr/bin/env bash
+set -e
+
+SERVER_EXEC="../build/bin/server"
+LOADGEN_EXEC="../build/bin/loadgen"
+PORT=8094
+
+# Temp files
+CONFIG_FILE=$(mktemp)
+REPORT_FILE=$(mktemp)
+API_DIR=$(mktemp -d)
+DATA_DIR=$(mktemp -d)
+
+cleanup() {
+  rm -rf "$CONFIG_FILE" "$REPORT_FILE" "$API_DIR" "$DATA_DIR"
+}
+trap cleanup EXIT
+
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+log_level warning;
+
+location /echo EchoHandler {}
+
+location /api ApiHandler {
+  data_path $API_DIR;
+}
+
+location /register RegisterHandler {
+  data_path $DATA_DIR;
+}
+
+location /login LoginHandler {
+  data_path $DATA_DIR;
+}
+
+location /messages/get GetMessagesHandler {
+  data_path $DATA_DIR;
+}
+
+location /messages/post PostMessageHandler {
+  data_path $DATA_DIR;
+}
+CONF
+
+echo "==== LOADGEN TEST ===="
+
+# loadgen starts the server, runs a short mixed load and stops it again
+"$LOADGEN_EXEC" --server "$SERVER_EXEC" --config "$CONFIG_FILE" --port $PORT \
+  --connections 4 --duration 1 --warmup 0.2 --mix echo=2,api=1,messages=1 \
+  --out "$REPORT_FILE"
+
+cat "$REPORT_FILE"
+
+REQUESTS=$(grep -m1 '"requests":' "$REPORT_FILE" | tr -dc '0-9')
+ERRORS=$(grep -m1 '"errors":' "$REPORT_FILE" | tr -dc '0-9')
+
+if [[ "$REQUESTS" -gt 0 && "$ERRORS" -eq 0 ]]; then
+  echo "PASS: $REQUESTS requests, no errors"
+else
+  echo "FAIL: $REQUESTS requests, $ERRORS errors"
+  exit 1
+fi
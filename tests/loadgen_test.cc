@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "dispatcher.h"
+#include "io_context_pool.h"
+#include "loadgen.h"
+#include "server.h"
+
+using namespace loadgen;
+
+namespace {
+  class OkHandler : public RequestHandler {
+  public:
+    std::unique_ptr<HttpResponse> handle_request(const HttpRequest&) override {
+      auto res = std::make_unique<HttpResponse>();
+      res->status_code = 200;
+      res->body = "ok";
+      return res;
+    }
+    std::string get_kName() override { return "OkHandler"; }
+    bool is_thread_safe() const override { return true; }
+  };
+
+  bool Parse(std::vector<const char*> args, Options& options, std::string& error) {
+    args.insert(args.begin(), "loadgen");
+    return parse_options(static_cast<int>(args.size()), args.data(), options, error);
+  }
+}
+
+// test request mix parsing
+TEST(LoadgenTest, ParsesMix) {
+  Mix mix;
+  std::string error;
+  ASSERT_TRUE(parse_mix("static=4,echo=1,api=2,messages=1", mix, error));
+  ASSERT_EQ(mix.size(), 4u);
+  EXPECT_EQ(mix[0], std::make_pair(Kind::static_file, 4u));
+  EXPECT_EQ(mix[2], std::make_pair(Kind::api, 2u));
+
+  EXPECT_FALSE(parse_mix("video=1", mix, error));
+  EXPECT_EQ(error, "unknown request kind: video");
+  EXPECT_FALSE(parse_mix("echo=0", mix, error));
+  EXPECT_FALSE(parse_mix("echo", mix, error));
+  EXPECT_FALSE(parse_mix("echo=1,echo=2", mix, error));
+  EXPECT_FALSE(parse_mix("", mix, error));
+  EXPECT_EQ(mix.size(), 4u);  // unchanged by failures
+}
+
+// test command line parsing
+TEST(LoadgenTest, ParsesOptions) {
+  Options options;
+  std::string error;
+  ASSERT_TRUE(Parse({"--port", "9000", "--connections", "64", "--duration", "2.5", "--rate", "1000",
+                     "--requests-per-connection", "1", "--mix", "echo=3,static=1"},
+                    options, error)) << error;
+  EXPECT_EQ(options.port, 9000);
+  EXPECT_EQ(options.connections, 64u);
+  EXPECT_DOUBLE_EQ(options.duration_s, 2.5);
+  EXPECT_DOUBLE_EQ(options.rate, 1000);
+  EXPECT_EQ(options.requests_per_connection, 1u);
+  EXPECT_EQ(options.mix.size(), 2u);
+
+  Options bad;
+  EXPECT_FALSE(Parse({"--port", "70000"}, bad, error));
+  EXPECT_FALSE(Parse({"--connections", "0"}, bad, error));
+  EXPECT_FALSE(Parse({"--duration", "ten"}, bad, error));
+  EXPECT_EQ(error, "bad value for --duration: ten");
+  EXPECT_FALSE(Parse({"--rate"}, bad, error));
+  EXPECT_FALSE(Parse({"--verbose", "1"}, bad, error));
+  EXPECT_FALSE(Parse({"--server", "bin/server"}, bad, error));
+  EXPECT_FALSE(Parse({"--help"}, bad, error));
+  EXPECT_TRUE(error.empty());
+}
+
+// test that the open-loop schedule advances by a fixed interval
+TEST(LoadgenTest, Schedule) {
+  auto start = Schedule::Clock::now();
+  Schedule schedule(start, std::chrono::milliseconds(5));
+  EXPECT_EQ(schedule.next(), start);
+  EXPECT_EQ(schedule.next(), start + std::chrono::milliseconds(5));
+  EXPECT_EQ(schedule.next(), start + std::chrono::milliseconds(10));
+}
+
+// test merging stats and the JSON report
+TEST(LoadgenTest, Report) {
+  Stats a, b;
+  a.record(100, false);
+  a.record(200, true);
+  b.record(5000, false);
+  Result result;
+  result.elapsed_s = 2;
+  result.by_kind[Kind::echo] = a;
+  result.by_kind[Kind::api] = b;
+  result.total.merge(a);
+  result.total.merge(b);
+  EXPECT_EQ(result.total.requests, 3u);
+  EXPECT_EQ(result.total.errors, 1u);
+  EXPECT_EQ(result.total.latency_max_us, 5000u);
+
+  Options options;
+  options.rate = 100;
+  auto json = nlohmann::json::parse(report(options, result));
+  EXPECT_EQ(json["mode"], "open");
+  EXPECT_EQ(json["requests"], 3);
+  EXPECT_DOUBLE_EQ(json["throughput_rps"].get<double>(), 1.5);
+  EXPECT_EQ(json["latency_us"]["mean"], 1766);
+  EXPECT_GE(json["latency_us"]["p99"].get<int>(), 5000);
+  EXPECT_EQ(json["by_kind"]["echo"]["errors"], 1);
+  EXPECT_EQ(json["by_kind"]["api"]["requests"], 1);
+}
+
+class LoadgenRunTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    Dispatcher::registerRoute("/echo", [] { return std::make_unique<OkHandler>(); });
+    srv_ = std::make_unique<server>(pool_, 0);
+    runner_ = std::thread([this] { pool_.run(); });
+    options_.port = srv_->port();
+    options_.connections = 2;
+    options_.duration_s = 0.3;
+    options_.warmup_s = 0.05;
+  }
+
+  void TearDown() override {
+    pool_.stop();
+    runner_.join();
+  }
+
+  IoContextPool pool_{1, ServerConfig::IoModel::shared};
+  std::unique_ptr<server> srv_;
+  std::thread runner_;
+  Options options_;
+};
+
+// test a closed-loop run over kept-alive connections
+TEST_F(LoadgenRunTest, ClosedLoop) {
+  Result result = run(options_);
+  EXPECT_GT(result.total.requests, 10u);
+  EXPECT_EQ(result.total.errors, 0u);
+  EXPECT_GE(result.connections_opened, 2u);
+  EXPECT_EQ(result.by_kind[Kind::echo].requests, result.total.requests);
+}
+
+// test that an open-loop run sends at the target rate
+TEST_F(LoadgenRunTest, OpenLoop) {
+  options_.rate = 200;
+  options_.duration_s = 0.5;
+  Result result = run(options_);
+  EXPECT_GE(result.total.requests, 80u);
+  EXPECT_LE(result.total.requests, 110u);
+  EXPECT_EQ(result.total.errors, 0u);
+}
+
+// test one connection per request, and that error responses are counted
+TEST_F(LoadgenRunTest, NewConnectionPerRequest) {
+  options_.requests_per_connection = 1;
+  options_.mix = {{Kind::static_file, 1}};  // unrouted here, so 404
+  Result result = run(options_);
+  EXPECT_GT(result.total.requests, 0u);
+  EXPECT_EQ(result.total.errors, result.total.requests);
+  EXPECT_GE(result.connections_opened, result.total.requests);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "log_level_handler.h"
+#include "logger.h"
+
+namespace trivial = boost::log::trivial;
+
+class LogLevelHandlerTest : public ::testing::Test {
+protected:
+  void TearDown() override {
+    set_log_level(trivial::trace);
+    set_log_sampling(1);
+  }
+
+  std::unique_ptr<HttpResponse> Send(const std::string& method, const std::string& body = "") {
+    HttpRequest req;
+    req.method = method;
+    req.path = "/admin/log";
+    req.body = body;
+    return handler_.handle_request(req);
+  }
+
+  LogLevelHandler handler_;
+};
+
+// test that GET reports the current settings
+TEST_F(LogLevelHandlerTest, ShowsSettings) {
+  set_log_level(trivial::info);
+  set_log_sampling(10);
+  auto res = Send("GET");
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(res->body, "level=info\nsample_every=10\n");
+}
+
+// test that PUT changes the level and sampling at runtime
+TEST_F(LogLevelHandlerTest, ChangesSettings) {
+  auto res = Send("PUT", "level=warning&sample_every=100\n");
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(log_level(), trivial::warning);
+  EXPECT_EQ(log_sampling(), 100u);
+
+  res = Send("POST", "level=debug");
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(log_level(), trivial::debug);
+  EXPECT_EQ(log_sampling(), 100u);
+}
+
+// test that a bad setting changes nothing and other methods are refused
+TEST_F(LogLevelHandlerTest, RejectsBadRequests) {
+  set_log_level(trivial::info);
+  EXPECT_EQ(Send("PUT", "level=debug&sample_every=lots")->status_code, 400);
+  EXPECT_EQ(Send("PUT", "level=loud")->status_code, 400);
+  EXPECT_EQ(Send("PUT", "")->status_code, 400);
+  EXPECT_EQ(log_level(), trivial::info);
+
+  auto res = Send("DELETE");
+  EXPECT_EQ(res->status_code, 405);
+  EXPECT_EQ(res->headers["Allow"], "GET, PUT, POST");
+}
+
+// test that one request in N is sampled
+TEST(LogSamplingTest, OneInN) {
+  set_log_sampling(4);
+  int sampled = 0;
+  for (int i = 0; i < 100; ++i) {
+    sampled += sample_request_log() ? 1 : 0;
+  }
+  EXPECT_EQ(sampled, 25);
+  set_log_sampling(0);
+  EXPECT_TRUE(sample_request_log());
+  EXPECT_EQ(log_sampling(), 1u);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <boost/log/core.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/trivial.hpp>
 #include "logger.h"
 
 namespace logging = boost::log;
@@ -22,6 +23,22 @@ TEST(LoggerTest, InitAddsConsoleAndFileSinksAndAttributes) {
     EXPECT_TRUE(attrs.count("ThreadID"))  << "Missing ThreadID attribute";
 }
 
+// test that async mode replaces the sinks and shuts down cleanly
+TEST(LoggerTest, AsyncInitAndShutdown) {
+    LogOptions options;
+    options.async = true;
+    options.queue_size = 16;
+    init_logging(options);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_LOG_TRIVIAL(debug) << "async record " << i;
+    }
+    logging::core::get()->flush();
+    shutdown_logging();
+    init_logging();  // back to synchronous sinks
+    BOOST_LOG_TRIVIAL(info) << "synchronous again";
+    shutdown_logging();
+}
+
 // standard google test entry point
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
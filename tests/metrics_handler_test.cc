@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include "metrics.h"
+#include "metrics_handler.h"
+
+// test that GET serves the process metrics in the Prometheus text format
+TEST(MetricsHandlerTest, ServesMetrics) {
+  Metrics::instance().record_request("HealthHandler", "/health", 200, std::chrono::microseconds(5), 40, 60);
+  MetricsHandler handler;
+  HttpRequest req;
+  req.method = "GET";
+  req.path = "/metrics";
+  auto res = handler.handle_request(req);
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(res->headers["Content-Type"], "text/plain; version=0.0.4");
+  EXPECT_NE(res->body.find("server_requests_total{handler=\"HealthHandler\",route=\"/health\",code=\"200\"} 1\n"),
+            std::string::npos);
+}
+
+// test that other methods are refused
+TEST(MetricsHandlerTest, RejectsOtherMethods) {
+  MetricsHandler handler;
+  HttpRequest req;
+  req.method = "POST";
+  auto res = handler.handle_request(req);
+  EXPECT_EQ(res->status_code, 405);
+  EXPECT_EQ(res->headers["Allow"], "GET");
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+
+// test that small values are exact and larger ones land within one bucket width
+TEST(LatencyHistogramTest, Buckets) {
+  for (std::uint64_t v = 0; v < 16; ++v) {
+    EXPECT_EQ(LatencyHistogram::upper_bound(LatencyHistogram::bucket(v)), v);
+  }
+  for (std::uint64_t v : {17u, 100u, 999u, 1000u, 12345u, 1000000u, 987654321u}) {
+    std::uint64_t upper = LatencyHistogram::upper_bound(LatencyHistogram::bucket(v));
+    EXPECT_GE(upper, v);
+    EXPECT_LE(upper - v, v / LatencyHistogram::kSubBuckets) << v;
+  }
+  // Buckets are contiguous and increasing
+  for (std::size_t i = 1; i < LatencyHistogram::kBuckets; ++i) {
+    EXPECT_EQ(LatencyHistogram::bucket(LatencyHistogram::upper_bound(i - 1) + 1), i);
+  }
+  EXPECT_EQ(LatencyHistogram::bucket(UINT64_MAX), LatencyHistogram::kBuckets - 1);
+}
+
+// test quantiles of a known distribution
+TEST(LatencyHistogramTest, Quantiles) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 990; ++i) histogram.record(100);
+  for (int i = 0; i < 9; ++i) histogram.record(5000);
+  histogram.record(200000);
+  std::vector<std::uint64_t> counts;
+  histogram.add_to(counts);
+
+  auto near = [](std::uint64_t got, std::uint64_t want) {
+    return got >= want && got - want <= want / LatencyHistogram::kSubBuckets;
+  };
+  EXPECT_TRUE(near(LatencyHistogram::quantile(counts, 0.5), 100));
+  EXPECT_TRUE(near(LatencyHistogram::quantile(counts, 0.99), 100));
+  EXPECT_TRUE(near(LatencyHistogram::quantile(counts, 0.995), 5000));
+  EXPECT_TRUE(near(LatencyHistogram::quantile(counts, 0.999), 5000));
+  EXPECT_TRUE(near(LatencyHistogram::quantile(counts, 1.0), 200000));
+  EXPECT_EQ(LatencyHistogram::quantile(std::vector<std::uint64_t>(10), 0.5), 0u);
+}
+
+// test that requests from several threads are summed on scrape
+TEST(MetricsTest, AggregatesShards) {
+  Metrics metrics;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&metrics] {
+      for (int i = 0; i < 250; ++i) {
+        metrics.record_request("EchoHandler", "/echo", 200, std::chrono::microseconds(100), 80, 150);
+      }
+      metrics.record_request("EchoHandler", "/echo", 500, std::chrono::microseconds(3000), 80, 20);
+      metrics.connection_opened();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  metrics.connection_closed();
+
+  std::string text = metrics.scrape();
+  EXPECT_NE(text.find("server_requests_total{handler=\"EchoHandler\",route=\"/echo\",code=\"200\"} 1000\n"),
+            std::string::npos) << text;
+  EXPECT_NE(text.find("server_requests_total{handler=\"EchoHandler\",route=\"/echo\",code=\"500\"} 4\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_request_duration_seconds_count{handler=\"EchoHandler\",route=\"/echo\"} 1004\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_request_duration_seconds{handler=\"EchoHandler\",route=\"/echo\",quantile=\"0.5\"} 0.000103\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_received_bytes_total{handler=\"EchoHandler\",route=\"/echo\"} 80320\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_sent_bytes_total{handler=\"EchoHandler\",route=\"/echo\"} 150080\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_connections_in_flight 3\n"), std::string::npos);
+  EXPECT_NE(text.find("server_connections_total 4\n"), std::string::npos);
+}
+
+// test that request stages are summarized per handler, skipping unmeasured ones
+TEST(MetricsTest, Stages) {
+  Metrics metrics;
+  RequestTiming timing;
+  auto t0 = RequestTiming::Clock::now();
+  timing.set(RequestTiming::kReceived, t0);
+  timing.set(RequestTiming::kParseStart, t0);
+  timing.set(RequestTiming::kParsed, t0 + std::chrono::microseconds(4));
+  timing.set(RequestTiming::kReady, t0 + std::chrono::microseconds(10));
+  timing.set(RequestTiming::kWritten, t0 + std::chrono::microseconds(2010));
+  metrics.record_stages("GetMessagesHandler", "/messages/get", timing);
+
+  std::string text = metrics.scrape();
+  EXPECT_NE(text.find("server_request_stage_seconds{handler=\"GetMessagesHandler\",route=\"/messages/get\",stage=\"parse\",quantile=\"0.5\"} 4e-06\n"),
+            std::string::npos) << text;
+  EXPECT_NE(text.find("server_request_stage_seconds_sum{handler=\"GetMessagesHandler\",route=\"/messages/get\",stage=\"write\"} 0.002\n"),
+            std::string::npos);
+  EXPECT_EQ(text.find("stage=\"handler\""), std::string::npos);
+}
+
+// test that handlers are reported separately and label values are escaped
+TEST(MetricsTest, LabelsPerHandler) {
+  Metrics metrics;
+  metrics.record_request("StaticHandler", "/static", 304, std::chrono::microseconds(40), 90, 120);
+  metrics.record_request("Odd\"Name", "None", 404, std::chrono::microseconds(10), 50, 45);
+  std::string text = metrics.scrape();
+  EXPECT_NE(text.find("server_requests_total{handler=\"StaticHandler\",route=\"/static\",code=\"304\"} 1\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("handler=\"Odd\\\"Name\""), std::string::npos);
+  EXPECT_NE(text.find("# TYPE server_request_duration_seconds summary\n"), std::string::npos);
+  EXPECT_EQ(text.find("EchoHandler"), std::string::npos);  // another instance's data
+}
+
+// test that one handler serving two locations gets a series for each
+TEST(MetricsTest, LabelsPerRoute) {
+  Metrics metrics;
+  metrics.record_request("StaticHandler", "/static", 200, std::chrono::microseconds(40), 90, 120);
+  metrics.record_request("StaticHandler", "/docs", 200, std::chrono::microseconds(40), 90, 120);
+  metrics.record_request("StaticHandler", "/docs", 200, std::chrono::microseconds(40), 90, 120);
+  std::string text = metrics.scrape();
+  EXPECT_NE(text.find("server_requests_total{handler=\"StaticHandler\",route=\"/static\",code=\"200\"} 1\n"),
+            std::string::npos) << text;
+  EXPECT_NE(text.find("server_requests_total{handler=\"StaticHandler\",route=\"/docs\",code=\"200\"} 2\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("server_request_duration_seconds_count{handler=\"StaticHandler\",route=\"/docs\"} 2\n"),
+            std::string::npos);
+}
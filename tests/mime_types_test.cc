@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include "mime_types.h"
+
+// test built-in types, including the front-end types that used to 404
+TEST(MimeTypesTest, Builtin) {
+  MimeTypes types;
+  EXPECT_EQ(types.lookup("/static/index.html"), "text/html");
+  EXPECT_EQ(types.lookup("/static/test.txt"), "text/plain");
+  EXPECT_EQ(types.lookup("/static/app.css"), "text/css");
+  EXPECT_EQ(types.lookup("/static/app.js"), "text/javascript");
+  EXPECT_EQ(types.lookup("/static/logo.svg"), "image/svg+xml");
+  EXPECT_EQ(types.lookup("/static/font.woff2"), "font/woff2");
+  EXPECT_EQ(types.lookup("/static/data.json"), "application/json");
+  EXPECT_EQ(types.lookup("/static/archive.zip"), "application/zip");
+  EXPECT_EQ(MimeTypes::builtin("7z"), "application/x-7z-compressed");
+  EXPECT_EQ(MimeTypes::builtin("zip"), "application/zip");
+}
+
+// test that extensions match case-insensitively and only in the last path segment
+TEST(MimeTypesTest, Extensions) {
+  MimeTypes types;
+  EXPECT_EQ(types.lookup("/static/PHOTO.JPG"), "image/jpeg");
+  EXPECT_EQ(types.lookup("/static/v1.2/README"), "");
+  EXPECT_EQ(types.lookup("/static/noext"), "");
+  EXPECT_EQ(types.lookup("/static/file."), "");
+  EXPECT_EQ(types.lookup("/static/file.unknown"), "");
+}
+
+// test that configured types extend and override the table
+TEST(MimeTypesTest, Configured) {
+  MimeTypes types;
+  types.add("webmanifest", "application/json");
+  types.add(".Glb", "model/gltf-binary");
+  EXPECT_EQ(types.lookup("/app.webmanifest"), "application/json");
+  EXPECT_EQ(types.lookup("/model.glb"), "model/gltf-binary");
+  EXPECT_EQ(types.lookup("/model.GLB"), "model/gltf-binary");
+  EXPECT_EQ(types.lookup("/index.html"), "text/html");
+}
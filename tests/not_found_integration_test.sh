@@ -11,6 +11,10 @@ RESPONSE_HEADERS=$(mktemp)
 # Minimal config: only our three handlers
 cat > "$CONFIG_FILE" <<EOF
 port $PORT;
+
+location /echo EchoHandler {
+  methods GET;
+}
 EOF
 
 # Launch server
@@ -44,4 +48,15 @@ if grep -i "^Content-Type: text/plain" "$RESPONSE_HEADERS"; then
 else
   echo "Missing or incorrect Content-Type header"
   # exit 1
-fi
\ No newline at end of file
+fi
+
+# A location that exists but not for this method is a 405 listing the allowed ones
+curl -s -X DELETE -D "$RESPONSE_HEADERS" "http://localhost:$PORT/echo" -o /dev/null
+
+if grep -q "^HTTP/1.1 405" "$RESPONSE_HEADERS" && grep -qi "^Allow: GET" "$RESPONSE_HEADERS"; then
+  echo "Method Not Allowed check passed."
+else
+  echo "Method Not Allowed check FAILED."
+  cat "$RESPONSE_HEADERS"
+  exit 1
+fi
@@ -0,0 +1,74 @@
+#!/usr/bin/env bash
+set -e
+
+SERVER_EXEC="../build/bin/server"
+PORT=8080
+
+# Temp files
+CONFIG_FILE=$(mktemp)
+RESPONSE_FILE=$(mktemp)
+
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+max_pipelined_requests 2;
+
+location /echo EchoHandler {}
+CONF
+
+# Start server in background
+"$SERVER_EXEC" "$CONFIG_FILE" &
+SERVER_PID=$!
+
+cleanup() {
+  kill $SERVER_PID 2>/dev/null || true
+  rm -f "$CONFIG_FILE" "$RESPONSE_FILE"
+}
+trap cleanup EXIT
+
+# give the server a moment to bind the socket
+sleep 0.1
+
+echo "==== PIPELINED REQUESTS ===="
+# Four requests in a single write; the cap of 2 forces backpressure mid-way
+exec 3<>/dev/tcp/localhost/$PORT
+printf "GET /echo/1 HTTP/1.1\r\nHost: a\r\n\r\nGET /echo/2 HTTP/1.1\r\nHost: a\r\n\r\nGET /echo/3 HTTP/1.1\r\nHost: a\r\n\r\nGET /echo/4 HTTP/1.1\r\nHost: a\r\nConnection: close\r\n\r\n" >&3
+cat <&3 > "$RESPONSE_FILE"
+exec 3<&-
+exec 3>&-
+
+COUNT=$(grep -c "HTTP/1.1 200 OK" "$RESPONSE_FILE" || true)
+if [[ "$COUNT" == "4" ]]; then
+  echo "PASS: all pipelined requests answered"
+else
+  echo "FAIL: expected 4 responses, got $COUNT"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+ORDER=$(grep -o "GET /echo/[0-9]" "$RESPONSE_FILE" | tr -d '\n')
+if [[ "$ORDER" == "GET /echo/1GET /echo/2GET /echo/3GET /echo/4" ]]; then
+  echo "PASS: responses are in request order"
+else
+  echo "FAIL: responses out of order: $ORDER"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+echo "==== BAD REQUEST AFTER A GOOD ONE ===="
+# A valid request and one that cannot be framed, in a single write
+exec 3<>/dev/tcp/localhost/$PORT
+printf "GET /echo/ok HTTP/1.1\r\nHost: a\r\n\r\nPOST /echo HTTP/1.1\r\nHost: a\r\nContent-Length: abc\r\n\r\n" >&3
+cat <&3 > "$RESPONSE_FILE"
+exec 3<&-
+exec 3>&-
+
+STATUSES=$(grep -o "^HTTP/1.1 [0-9]*" "$RESPONSE_FILE" | tr '\n' ' ')
+if [[ "$STATUSES" == "HTTP/1.1 200 HTTP/1.1 400 " ]]; then
+  echo "PASS: good request answered, then the bad one rejected"
+else
+  echo "FAIL: expected 200 then 400, got: $STATUSES"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+exit 0
@@ -77,3 +77,127 @@ TEST(RequestParserTest, HandlesEmptyRequest) {
   EXPECT_TRUE(ec) << "Expected a parse error on empty input";
 }
 
+
+// test framing waits for the end of the header block
+TEST(RequestParserTest, FrameIncompleteHeaders) {
+  const char raw[] = "GET /foo HTTP/1.1\r\nHost: example.com\r\n";
+  std::size_t request_len = 0;
+  EXPECT_EQ(RequestParser::frame(raw, std::strlen(raw), 8192, 1024, request_len),
+            RequestParser::Framing::incomplete);
+}
+
+// test framing waits for Content-Length bytes of body
+TEST(RequestParserTest, FrameWaitsForBody) {
+  const char raw[] =
+    "POST /api/Shoes HTTP/1.1\r\n"
+    "content-length: 10\r\n"
+    "\r\n"
+    "12345";
+  std::size_t request_len = 0;
+  EXPECT_EQ(RequestParser::frame(raw, std::strlen(raw), 8192, 1024, request_len),
+            RequestParser::Framing::incomplete);
+}
+
+// test framing reports the exact request length, leaving following bytes alone
+TEST(RequestParserTest, FrameCompleteWithTrailingBytes) {
+  const char raw[] =
+    "POST /api/Shoes HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "12345"
+    "GET /next HTTP/1.1\r\n";
+  std::size_t request_len = 0;
+  ASSERT_EQ(RequestParser::frame(raw, std::strlen(raw), 8192, 1024, request_len),
+            RequestParser::Framing::complete);
+  EXPECT_EQ(request_len, std::strlen(raw) - std::strlen("GET /next HTTP/1.1\r\n"));
+}
+
+// test framing rejects a header block above the cap
+TEST(RequestParserTest, FrameHeaderTooLarge) {
+  std::string raw = "GET /foo HTTP/1.1\r\nCookie: " + std::string(200, 'a');
+  std::size_t request_len = 0;
+  EXPECT_EQ(RequestParser::frame(raw.data(), raw.size(), 128, 1024, request_len),
+            RequestParser::Framing::header_too_large);
+}
+
+// test framing rejects a declared body above the cap before it arrives
+TEST(RequestParserTest, FrameBodyTooLarge) {
+  const char raw[] =
+    "POST /api/Shoes HTTP/1.1\r\n"
+    "Content-Length: 5000\r\n"
+    "\r\n";
+  std::size_t request_len = 0;
+  EXPECT_EQ(RequestParser::frame(raw, std::strlen(raw), 8192, 1024, request_len),
+            RequestParser::Framing::body_too_large);
+}
+
+// test framing rejects a non-numeric Content-Length
+TEST(RequestParserTest, FrameMalformedContentLength) {
+  const char raw[] =
+    "POST /api/Shoes HTTP/1.1\r\n"
+    "Content-Length: ten\r\n"
+    "\r\n";
+  std::size_t request_len = 0;
+  EXPECT_EQ(RequestParser::frame(raw, std::strlen(raw), 8192, 1024, request_len),
+            RequestParser::Framing::malformed);
+}
+
+// test the view parser slices the input buffer without copying
+TEST(RequestParserTest, ParseViewSlicesInput) {
+  const char raw[] =
+    "POST /api/Shoes HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Content-Type:   application/json  \r\n"
+    "\r\n"
+    "{}";
+  boost::system::error_code ec;
+  RequestParser parser;
+  RequestView view;
+  ASSERT_TRUE(parser.parse_view(raw, std::strlen(raw), view, ec));
+
+  EXPECT_EQ(view.method, "POST");
+  EXPECT_EQ(view.target, "/api/Shoes");
+  EXPECT_EQ(view.version, "HTTP/1.1");
+  ASSERT_EQ(view.headers.size(), 2u);
+  EXPECT_EQ(view.headers[1].name, "Content-Type");
+  EXPECT_EQ(view.headers[1].value, "application/json");
+  EXPECT_EQ(view.body, "{}");
+  EXPECT_EQ(view.method.data(), raw);
+  EXPECT_EQ(view.body.data(), raw + std::strlen(raw) - 2);
+
+  HttpRequest without_raw = view.materialize(false);
+  EXPECT_EQ(without_raw.path, "/api/Shoes");
+  EXPECT_EQ(without_raw.body, "{}");
+  EXPECT_TRUE(without_raw.raw.empty());
+  EXPECT_EQ(view.materialize().raw, raw);
+}
+
+// test the view parser accepts bare LF line endings like the old parser did
+TEST(RequestParserTest, ParseViewAcceptsBareNewlines) {
+  const char raw[] = "GET /foo HTTP/1.0\nHost: example.com\n\n";
+  boost::system::error_code ec;
+  RequestParser parser;
+  HttpRequest req = parser.parse(raw, std::strlen(raw), ec);
+
+  ASSERT_FALSE(ec) << "Parser returned error: " << ec.message();
+  EXPECT_EQ(req.version, "HTTP/1.0");
+  EXPECT_EQ(req.headers["Host"], "example.com");
+}
+
+// test that repeated and lower-case header names survive parsing
+TEST(RequestParserTest, KeepsRepeatedHeadersCaseInsensitively) {
+  const char raw[] =
+    "GET / HTTP/1.1\r\n"
+    "cookie: a=1\r\n"
+    "Accept: text/html\r\n"
+    "Accept: application/json\r\n"
+    "\r\n";
+  boost::system::error_code ec;
+  RequestParser parser;
+  HttpRequest req = parser.parse(raw, std::strlen(raw), ec);
+
+  ASSERT_FALSE(ec);
+  EXPECT_EQ(req.headers["Cookie"], "a=1");
+  EXPECT_EQ(req.headers.count("accept"), 2u);
+  EXPECT_EQ(req.headers.values("Accept")[1], "application/json");
+}
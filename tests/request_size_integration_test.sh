@@ -0,0 +1,82 @@
+#!/usr/bin/env bash
+set -e
+
+SERVER_EXEC="../build/bin/server"
+PORT=8080
+
+# Temp files
+CONFIG_FILE=$(mktemp)
+RESPONSE_FILE=$(mktemp)
+API_DIR=$(mktemp -d)
+
+# Small caps so the limits are easy to cross
+cat > "$CONFIG_FILE" <<CONF
+port $PORT;
+max_header_size 4096;
+max_body_size 2048;
+
+location /echo EchoHandler {}
+
+location /api ApiHandler {
+  data_path $API_DIR;
+}
+CONF
+
+# Start server in background
+"$SERVER_EXEC" "$CONFIG_FILE" &
+SERVER_PID=$!
+
+cleanup() {
+  kill $SERVER_PID 2>/dev/null || true
+  rm -f "$CONFIG_FILE" "$RESPONSE_FILE"
+  rm -rf "$API_DIR"
+}
+trap cleanup EXIT
+
+# give the server a moment to bind the socket
+sleep 0.1
+
+echo "==== HEADERS LARGER THAN ONE READ ===="
+# A 3000 byte cookie no longer fits in a single small read
+BIG_COOKIE=$(head -c 3000 /dev/zero | tr '\0' 'a')
+curl -s -H "Cookie: $BIG_COOKIE" "http://localhost:$PORT/echo" -o "$RESPONSE_FILE"
+if grep -q "Cookie: $BIG_COOKIE" "$RESPONSE_FILE"; then
+  echo "PASS: full header block was read"
+else
+  echo "FAIL: header block was truncated"
+  exit 1
+fi
+
+echo "==== BODY LARGER THAN ONE READ ===="
+BIG_VALUE=$(head -c 1800 /dev/zero | tr '\0' 'b')
+curl -s -X POST "http://localhost:$PORT/api/Shoes" -d "{\"name\":\"$BIG_VALUE\"}" > /dev/null
+curl -s "http://localhost:$PORT/api/Shoes/0" -o "$RESPONSE_FILE"
+if grep -q "$BIG_VALUE" "$RESPONSE_FILE"; then
+  echo "PASS: full body was read"
+else
+  echo "FAIL: body was truncated"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+echo "==== HEADER CAP ===="
+HUGE_COOKIE=$(head -c 5000 /dev/zero | tr '\0' 'a')
+STATUS=$(curl -s -o /dev/null -w "%{http_code}" -H "Cookie: $HUGE_COOKIE" "http://localhost:$PORT/echo")
+if [[ "$STATUS" == "431" ]]; then
+  echo "PASS: oversized headers rejected with 431"
+else
+  echo "FAIL: expected 431, got $STATUS"
+  exit 1
+fi
+
+echo "==== BODY CAP ===="
+HUGE_VALUE=$(head -c 3000 /dev/zero | tr '\0' 'b')
+STATUS=$(curl -s -o /dev/null -w "%{http_code}" -X POST "http://localhost:$PORT/api/Shoes" -d "$HUGE_VALUE")
+if [[ "$STATUS" == "413" ]]; then
+  echo "PASS: oversized body rejected with 413"
+else
+  echo "FAIL: expected 413, got $STATUS"
+  exit 1
+fi
+
+exit 0
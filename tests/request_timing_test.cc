@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+#include "request_timing.h"
+
+using Clock = RequestTiming::Clock;
+using std::chrono::microseconds;
+
+// test that stage durations come from their bounding marks
+TEST(RequestTimingTest, Durations) {
+  RequestTiming timing;
+  Clock::time_point t0 = Clock::now();
+  timing.set(RequestTiming::kFirstByte, t0);
+  timing.set(RequestTiming::kReceived, t0 + microseconds(10));
+  timing.set(RequestTiming::kParseStart, t0 + microseconds(12));
+  timing.set(RequestTiming::kParsed, t0 + microseconds(16));
+  timing.set(RequestTiming::kRouted, t0 + microseconds(17));
+  timing.set(RequestTiming::kHandlerStart, t0 + microseconds(16));
+  timing.set(RequestTiming::kHandlerEnd, t0 + microseconds(1266));
+  timing.set(RequestTiming::kReady, t0 + microseconds(1270));
+
+  microseconds span;
+  ASSERT_TRUE(timing.duration(RequestTiming::kRecv, span));
+  EXPECT_EQ(span.count(), 10);
+  ASSERT_TRUE(timing.duration(RequestTiming::kParse, span));
+  EXPECT_EQ(span.count(), 4);  // from kParseStart, not kReceived
+  ASSERT_TRUE(timing.duration(RequestTiming::kRoute, span));
+  EXPECT_EQ(span.count(), 1);
+  ASSERT_TRUE(timing.duration(RequestTiming::kHandler, span));
+  EXPECT_EQ(span.count(), 1250);
+  EXPECT_FALSE(timing.duration(RequestTiming::kWait, span));   // not the first request
+  EXPECT_FALSE(timing.duration(RequestTiming::kWrite, span));  // not written yet
+
+  timing.set(RequestTiming::kWritten, t0 + microseconds(1300));
+  ASSERT_TRUE(timing.duration(RequestTiming::kWrite, span));
+  EXPECT_EQ(span.count(), 30);
+}
+
+// test the Server-Timing rendering, which skips unmeasured stages
+TEST(RequestTimingTest, ServerTimingHeader) {
+  RequestTiming timing;
+  EXPECT_EQ(timing.server_timing(), "");
+
+  Clock::time_point t0 = Clock::now();
+  timing.set(RequestTiming::kAccepted, t0);
+  timing.set(RequestTiming::kFirstByte, t0 + microseconds(500));
+  timing.set(RequestTiming::kReceived, t0 + microseconds(512));
+  timing.set(RequestTiming::kParseStart, t0 + microseconds(512));
+  timing.set(RequestTiming::kParsed, t0 + microseconds(516));
+  timing.set(RequestTiming::kRouted, t0 + microseconds(517));
+  EXPECT_EQ(timing.server_timing(),
+            "wait;dur=0.500, recv;dur=0.012, parse;dur=0.004, route;dur=0.001");
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "route_tree.h"
+
+// test longest-prefix matching on segment boundaries
+TEST(RouteTreeTest, LongestPrefixOnSegments) {
+  RouteTree tree;
+  tree.insert("/", "", 0);
+  tree.insert("/static", "", 1);
+  tree.insert("/static/images", "", 2);
+
+  EXPECT_EQ(tree.match("/static/images/cat.jpg", "GET"), 2u);
+  EXPECT_EQ(tree.match("/static/index.html", "GET"), 1u);
+  EXPECT_EQ(tree.match("/static", "GET"), 1u);
+  EXPECT_EQ(tree.match("/static/", "GET"), 1u);
+  EXPECT_EQ(tree.match("/staticfoo", "GET"), 0u);  // not a segment boundary
+  EXPECT_EQ(tree.match("/other", "GET"), 0u);
+}
+
+// test that the query string is ignored
+TEST(RouteTreeTest, IgnoresQueryString) {
+  RouteTree tree;
+  tree.insert("/echo", "", 7);
+  EXPECT_EQ(tree.match("/echo?x=/y", "GET"), 7u);
+}
+
+// test that nothing matches without a root route
+TEST(RouteTreeTest, NoMatch) {
+  RouteTree tree;
+  tree.insert("/api", "", 1);
+  EXPECT_EQ(tree.match("/", "GET"), RouteTree::npos);
+  EXPECT_EQ(tree.match("/apis", "GET"), RouteTree::npos);
+}
+
+// test captured path parameters
+TEST(RouteTreeTest, CapturesParams) {
+  RouteTree tree;
+  tree.insert("/api/:entity/:id", "", 3);
+
+  RouteTree::Params params;
+  EXPECT_EQ(tree.match("/api/shoes/42", "GET", &params), 3u);
+  ASSERT_EQ(params.size(), 2u);
+  EXPECT_EQ(params[0].first, "entity");
+  EXPECT_EQ(params[0].second, "shoes");
+  EXPECT_EQ(params[1].first, "id");
+  EXPECT_EQ(params[1].second, "42");
+
+  EXPECT_EQ(tree.match("/api/shoes", "GET", &params), RouteTree::npos);
+}
+
+// test that literal segments win over captures unless the capture goes deeper
+TEST(RouteTreeTest, LiteralsBeatCaptures) {
+  RouteTree tree;
+  tree.insert("/users/me", "", 1);
+  tree.insert("/users/:id", "", 2);
+  tree.insert("/users/:id/posts", "", 3);
+
+  RouteTree::Params params;
+  EXPECT_EQ(tree.match("/users/me", "GET", &params), 1u);
+  EXPECT_TRUE(params.empty());
+  EXPECT_EQ(tree.match("/users/7", "GET", &params), 2u);
+  EXPECT_EQ(tree.match("/users/me/posts", "GET", &params), 3u);
+  ASSERT_EQ(params.size(), 1u);
+  EXPECT_EQ(params[0].second, "me");
+}
+
+// test method-specific routes, and that a method the longest matching
+// pattern does not take is reported with the methods it does
+TEST(RouteTreeTest, MethodRoutes) {
+  RouteTree tree;
+  tree.insert("/", "", 0);
+  tree.insert("/messages", "GET", 1);
+  tree.insert("/messages", "POST", 2);
+  tree.insert("/messages/:id", "DELETE", 3);
+
+  std::vector<std::string> allowed;
+  EXPECT_EQ(tree.match("/messages", "GET", nullptr, &allowed), 1u);
+  EXPECT_TRUE(allowed.empty());
+  EXPECT_EQ(tree.match("/messages", "POST"), 2u);
+  EXPECT_EQ(tree.match("/messages", "DELETE", nullptr, &allowed), RouteTree::npos);
+  EXPECT_EQ(allowed, (std::vector<std::string>{"GET", "POST"}));
+
+  RouteTree::Params params;
+  EXPECT_EQ(tree.match("/messages/7", "GET", &params, &allowed), RouteTree::npos);
+  EXPECT_EQ(allowed, std::vector<std::string>{"DELETE"});
+  EXPECT_TRUE(params.empty());
+  EXPECT_EQ(tree.match("/other", "DELETE"), 0u);  // no location but "/" matches
+}
+
+// test that inserting an existing pattern and method replaces it
+TEST(RouteTreeTest, InsertReplaces) {
+  RouteTree tree;
+  EXPECT_EQ(tree.insert("/a", "", 1), RouteTree::npos);
+  EXPECT_EQ(tree.insert("/a", "", 2), 1u);
+  EXPECT_EQ(tree.match("/a", "GET"), 2u);
+}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <tuple>
 #include <future> 
+#include <thread>
 
 #include "server.h"
 #include "session.h"
@@ -37,24 +38,62 @@ TEST_F(ServerTest, ConstructorDoesNotThrowAndStartsAccept) {
 }
 
 TEST_F(ServerTest, HandleAcceptSuccess_CallsSessionStart) {
-  TestSession* ts = new TestSession(ios);
+  auto ts = std::make_shared<TestSession>(ios);
   boost::system::error_code ec;
   srv.handle_accept(ts, ec);
 
   auto status = ts->started_future.wait_for(std::chrono::milliseconds(100));
   EXPECT_EQ(status, std::future_status::ready) << "Session::start() was not called in time";
-
-  delete ts;
 }
 
 TEST_F(ServerTest, HandleAcceptError_DoesNotThrow) {
-  session* s = new session(ios);
+  auto s = std::make_shared<session>(ios);
   auto ec = boost::asio::error::make_error_code(boost::asio::error::operation_aborted);
   EXPECT_NO_THROW({
     srv.handle_accept(s, ec);
   });
 }
 
+TEST(ServerPoolTest, ConstructsOnPerCorePool) {
+  IoContextPool pool(2, ServerConfig::IoModel::per_core);
+  EXPECT_NO_THROW({
+    server srv(pool, 0);
+  });
+}
+
+TEST(ServerPoolTest, ReusePortOpensOneAcceptorPerThread) {
+  IoContextPool pool(3, ServerConfig::IoModel::per_core);
+  ServerConfig config;
+  config.reuse_port = true;
+  server srv(pool, 0, config);
+  EXPECT_EQ(srv.acceptors(), 3u);
+  EXPECT_NE(srv.port(), 0);
+}
+
+TEST(ServerPoolTest, ReusePortServesConnections) {
+  IoContextPool pool(2, ServerConfig::IoModel::per_core);
+  ServerConfig config;
+  config.reuse_port = true;
+  server srv(pool, 0, config);
+  std::thread runner([&pool]() { pool.run(); });
+
+  // Unrouted requests get a 404 from the session itself
+  for (int i = 0; i < 8; ++i) {
+    boost::asio::io_context client;
+    tcp::socket socket(client);
+    socket.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), srv.port()));
+    std::string request = "GET /nowhere HTTP/1.1\r\nConnection: close\r\n\r\n";
+    boost::asio::write(socket, boost::asio::buffer(request));
+    std::string response;
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(response), ec);
+    EXPECT_EQ(response.rfind("HTTP/1.1 404", 0), 0u) << response;
+  }
+
+  pool.stop();
+  runner.join();
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <chrono>
+#include "sleep_handler.h"
+#include "handler_registry.h"
+
+// test that the async path returns at once and answers when the timer fires
+TEST(SleepHandlerTest, AsyncAnswersAfterTimer) {
+  boost::asio::io_context io;
+  SleepHandler handler(std::chrono::milliseconds(50));
+  HttpRequest req;
+  req.method = "GET";
+  req.path = "/sleep";
+
+  std::unique_ptr<HttpResponse> res;
+  auto start = std::chrono::steady_clock::now();
+  handler.handle_request_async(req, io.get_executor(),
+      [&res](std::unique_ptr<HttpResponse> r) { res = std::move(r); });
+  EXPECT_EQ(res, nullptr);  // nothing happens until the io_context runs
+
+  io.run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(res, nullptr);
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(res->body, "Slept");
+  EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+}
+
+// test that many sleeps overlap on a single thread
+TEST(SleepHandlerTest, ManySleepsShareOneThread) {
+  boost::asio::io_context io;
+  SleepHandler handler(std::chrono::milliseconds(100));
+  HttpRequest req;
+
+  int answered = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 200; ++i) {
+    handler.handle_request_async(req, io.get_executor(),
+        [&answered](std::unique_ptr<HttpResponse>) { ++answered; });
+  }
+  io.run();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(answered, 200);
+  EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+// test the blocking fallback used by synchronous callers
+TEST(SleepHandlerTest, SyncPathStillResponds) {
+  SleepHandler handler(std::chrono::milliseconds(1));
+  HttpRequest req;
+  auto res = handler.handle_request(req);
+  EXPECT_EQ(res->status_code, 200);
+  EXPECT_EQ(res->headers["Content-Type"], "text/plain");
+}
+
+// test that the factory only accepts a non-negative integer delay_ms
+TEST(SleepHandlerTest, FactoryValidatesDelay) {
+  auto& registry = HandlerRegistry::instance();
+  EXPECT_NE(registry.createHandler(SleepHandler::kName, {"/sleep"}), nullptr);
+  EXPECT_NE(registry.createHandler(SleepHandler::kName, {"/sleep", "0"}), nullptr);
+  EXPECT_NE(registry.createHandler(SleepHandler::kName, {"/sleep", "250"}), nullptr);
+  EXPECT_EQ(registry.createHandler(SleepHandler::kName, {"/sleep", "abc"}), nullptr);
+  EXPECT_EQ(registry.createHandler(SleepHandler::kName, {"/sleep", "-5"}), nullptr);
+  EXPECT_EQ(registry.createHandler(SleepHandler::kName, {"/sleep", "10ms"}), nullptr);
+  EXPECT_EQ(registry.createHandler(SleepHandler::kName, {"/sleep", ""}), nullptr);
+  EXPECT_EQ(registry.createHandler(SleepHandler::kName, {"/sleep", "99999999999999999999"}), nullptr);
+}
@@ -0,0 +1,335 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "static_file_cache.h"
+
+class StaticFileCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/static_file_cache_testXXXXXX";
+    ASSERT_NE(mkdtemp(tmpl), nullptr);
+    dir_ = tmpl;
+  }
+
+  void TearDown() override {
+    std::system(("rm -rf " + dir_).c_str());
+  }
+
+  std::string write_file(const std::string& name, const std::string& contents) {
+    std::string path = dir_ + "/" + name;
+    std::ofstream(path) << contents;
+    return path;
+  }
+
+  static HttpHeaders text_headers(const FileBody& file) {
+    return StaticFileCache::file_headers(file.stat(), "text/plain");
+  }
+
+  // Poll until the watcher drops `key`, since inotify events arrive asynchronously
+  static bool evicted_soon(StaticFileCache& cache, const std::string& key) {
+    for (int i = 0; i < 200; ++i) {
+      if (!cache.find(key)) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  std::string dir_;
+};
+
+// test that a zero budget caches nothing
+TEST_F(StaticFileCacheTest, DisabledByDefault) {
+  StaticFileCache cache;
+  std::string path = write_file("a.txt", "hello");
+  auto file = FileBody::open(path);
+  ASSERT_NE(file, nullptr);
+
+  EXPECT_EQ(cache.insert("/a.txt", path, file, text_headers(*file)), nullptr);
+  EXPECT_EQ(cache.find("/a.txt"), nullptr);
+  EXPECT_EQ(cache.entries(), 0u);
+}
+
+// test that an inserted file is found with its contents and headers
+TEST_F(StaticFileCacheTest, InsertAndFind) {
+  StaticFileCache cache(1024 * 1024);
+  std::string path = write_file("a.txt", "hello");
+  auto file = FileBody::open(path);
+  ASSERT_NE(file, nullptr);
+
+  auto inserted = cache.insert("/a.txt", path, file, text_headers(*file));
+  ASSERT_NE(inserted, nullptr);
+  auto found = cache.find("/a.txt");
+  ASSERT_EQ(found, inserted);
+  EXPECT_EQ(found->body.view(), "hello");
+  EXPECT_EQ(found->headers.find("Content-Type")->second, "text/plain");
+  EXPECT_EQ(found->headers.find("ETag")->second, StaticFileCache::make_etag(file->stat()));
+  EXPECT_EQ(found->headers.find("Last-Modified")->second,
+            StaticFileCache::http_date(file->stat().st_mtim.tv_sec));
+  EXPECT_EQ(cache.size(), 5u);
+  EXPECT_EQ(cache.find("/b.txt"), nullptr);
+}
+
+// test that files above a sixteenth of the budget are left to sendfile
+TEST_F(StaticFileCacheTest, RejectsLargeFiles) {
+  StaticFileCache cache(16 * 32);
+  EXPECT_EQ(cache.max_entry_size(), 32u);
+  std::string path = write_file("big.txt", std::string(33, 'x'));
+  auto file = FileBody::open(path);
+  ASSERT_NE(file, nullptr);
+
+  EXPECT_EQ(cache.insert("/big.txt", path, file, text_headers(*file)), nullptr);
+  EXPECT_EQ(cache.entries(), 0u);
+}
+
+// test that files above the memory limit but within the mmap limit are mapped
+TEST_F(StaticFileCacheTest, MapsMidSizeFiles) {
+  StaticFileCache cache(16 * 32);
+  cache.set_mmap_limit(1024 * 1024);
+  std::string contents(4096, 'm');
+  std::string path = write_file("mid.txt", contents);
+  auto file = FileBody::open(path);
+  ASSERT_NE(file, nullptr);
+
+  auto entry = cache.insert("/mid.txt", path, file, text_headers(*file));
+  ASSERT_NE(entry, nullptr);
+  ASSERT_NE(entry->mapping, nullptr);
+  EXPECT_EQ(entry->body.size(), contents.size());
+  EXPECT_EQ(entry->body.slice(4000, 96).size(), 96u);
+  EXPECT_EQ(cache.mapped_size(), contents.size());
+  EXPECT_EQ(cache.size(), 0u);
+
+  // Files past the mmap limit are still left to sendfile
+  std::string big = write_file("big.txt", std::string(2 * 1024 * 1024, 'b'));
+  auto big_file = FileBody::open(big);
+  EXPECT_EQ(cache.insert("/big.txt", big, big_file, text_headers(*big_file)), nullptr);
+
+  write_file("mid.txt", "shrunk");
+  EXPECT_TRUE(evicted_soon(cache, "/mid.txt"));
+  EXPECT_EQ(cache.mapped_size(), 0u);
+}
+
+// test that the least recently used entry is evicted first
+TEST_F(StaticFileCacheTest, EvictsLeastRecentlyUsed) {
+  StaticFileCache cache(16 * 32);
+  std::string path = write_file("a.txt", std::string(32, 'x'));
+  auto file = FileBody::open(path);
+  ASSERT_NE(file, nullptr);
+
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_NE(cache.insert("/k" + std::to_string(i), path, file, text_headers(*file)), nullptr);
+  }
+  EXPECT_EQ(cache.size(), 16u * 32);
+  ASSERT_NE(cache.find("/k0"), nullptr);  // now the most recently used
+
+  ASSERT_NE(cache.insert("/k16", path, file, text_headers(*file)), nullptr);
+  EXPECT_EQ(cache.entries(), 16u);
+  EXPECT_NE(cache.find("/k0"), nullptr);
+  EXPECT_EQ(cache.find("/k1"), nullptr);
+  EXPECT_NE(cache.find("/k16"), nullptr);
+
+  cache.set_capacity(4 * 32);  // room for four entries
+  EXPECT_EQ(cache.entries(), 4u);
+  EXPECT_NE(cache.find("/k16"), nullptr);
+}
+
+// test that rewriting a cached file drops its entry
+TEST_F(StaticFileCacheTest, InvalidatedOnWrite) {
+  StaticFileCache cache(1024 * 1024);
+  std::string path = write_file("a.txt", "old");
+  auto file = FileBody::open(path);
+  ASSERT_NE(cache.insert("/a.txt", path, file, text_headers(*file)), nullptr);
+
+  write_file("a.txt", "new contents");
+  EXPECT_TRUE(evicted_soon(cache, "/a.txt"));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+// test that removing or renaming over a cached file drops its entry
+TEST_F(StaticFileCacheTest, InvalidatedOnRemoveAndRename) {
+  StaticFileCache cache(1024 * 1024);
+  std::string a = write_file("a.txt", "a");
+  std::string b = write_file("b.txt", "b");
+  auto file_a = FileBody::open(a);
+  auto file_b = FileBody::open(b);
+  ASSERT_NE(cache.insert("/a.txt", a, file_a, text_headers(*file_a)), nullptr);
+  ASSERT_NE(cache.insert("/b.txt", b, file_b, text_headers(*file_b)), nullptr);
+
+  std::remove(a.c_str());
+  EXPECT_TRUE(evicted_soon(cache, "/a.txt"));
+
+  std::string staged = write_file("b.txt.new", "replacement");
+  std::rename(staged.c_str(), b.c_str());
+  EXPECT_TRUE(evicted_soon(cache, "/b.txt"));
+}
+
+// test that a derived variant is stored beside its file and invalidated with it
+TEST_F(StaticFileCacheTest, VariantsFollowTheirFile) {
+  StaticFileCache cache(1024 * 1024);
+  std::string path = write_file("a.txt", "contents");
+  auto file = FileBody::open(path);
+  auto identity = cache.insert("/a.txt", path, file, text_headers(*file));
+  ASSERT_NE(identity, nullptr);
+
+  auto variant = std::make_shared<CachedFile>(*identity);
+  variant->body = SharedBytes(std::string("encoded"));
+  EXPECT_EQ(cache.insert_variant("/a.txt\nbr", "/a.txt", identity, variant), variant);
+  EXPECT_EQ(cache.find("/a.txt\nbr"), variant);
+  EXPECT_EQ(cache.size(), 15u);
+
+  // A variant of an entry that has since been replaced is refused
+  auto stale = std::make_shared<CachedFile>(*identity);
+  EXPECT_EQ(cache.insert_variant("/a.txt\ngzip", "/missing", identity, stale), nullptr);
+
+  write_file("a.txt", "changed");
+  EXPECT_TRUE(evicted_soon(cache, "/a.txt\nbr"));
+  EXPECT_EQ(cache.find("/a.txt"), nullptr);
+  EXPECT_EQ(cache.insert_variant("/a.txt\ngzip", "/a.txt", identity, stale), nullptr);
+}
+
+// test that an unrelated file in the same directory leaves entries alone
+TEST_F(StaticFileCacheTest, UnrelatedChangesKeepEntries) {
+  StaticFileCache cache(1024 * 1024);
+  std::string path = write_file("a.txt", "a");
+  auto file = FileBody::open(path);
+  ASSERT_NE(cache.insert("/a.txt", path, file, text_headers(*file)), nullptr);
+
+  write_file("other.txt", "other");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_NE(cache.find("/a.txt"), nullptr);
+}
+
+// test that invalidating a file drops every key read from it and nothing else
+TEST_F(StaticFileCacheTest, InvalidateDropsOnlyThatFile) {
+  StaticFileCache cache(16 * 32);
+  std::string a = write_file("a.txt", std::string(32, 'a'));
+  std::string b = write_file("b.txt", std::string(32, 'b'));
+  auto file_a = FileBody::open(a);
+  auto file_b = FileBody::open(b);
+  ASSERT_NE(cache.insert("/a.txt", a, file_a, text_headers(*file_a)), nullptr);
+  ASSERT_NE(cache.insert("/alias/a.txt", a, file_a, text_headers(*file_a)), nullptr);
+  ASSERT_NE(cache.insert("/b.txt", b, file_b, text_headers(*file_b)), nullptr);
+
+  cache.invalidate(a);
+  EXPECT_EQ(cache.find("/a.txt"), nullptr);
+  EXPECT_EQ(cache.find("/alias/a.txt"), nullptr);
+  EXPECT_NE(cache.find("/b.txt"), nullptr);
+  EXPECT_EQ(cache.entries(), 1u);
+  EXPECT_EQ(cache.size(), 32u);
+
+  // Keys evicted for space leave the index too
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_NE(cache.insert("/k" + std::to_string(i), a, file_a, text_headers(*file_a)), nullptr);
+  }
+  cache.invalidate(a);
+  EXPECT_EQ(cache.entries(), 0u);
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+// test that removing a directory drops the entries read from inside it
+TEST_F(StaticFileCacheTest, InvalidatedWithTheirDirectory) {
+  StaticFileCache cache(1024 * 1024);
+  ASSERT_EQ(::mkdir((dir_ + "/sub").c_str(), 0700), 0);
+  std::string inner = write_file("sub/a.txt", "inner");
+  std::string outer = write_file("a.txt", "outer");
+  auto file_inner = FileBody::open(inner);
+  auto file_outer = FileBody::open(outer);
+  ASSERT_NE(cache.insert("/sub/a.txt", inner, file_inner, text_headers(*file_inner)), nullptr);
+  ASSERT_NE(cache.insert("/a.txt", outer, file_outer, text_headers(*file_outer)), nullptr);
+
+  std::system(("rm -rf " + dir_ + "/sub").c_str());
+  EXPECT_TRUE(evicted_soon(cache, "/sub/a.txt"));
+  EXPECT_NE(cache.find("/a.txt"), nullptr);
+}
+
+// test that a recorded miss lasts until a file appears at one of its paths
+TEST_F(StaticFileCacheTest, MissingUntilCreated) {
+  StaticFileCache cache(1024 * 1024);
+  std::vector<std::string> paths = {dir_ + "/a.txt.br", dir_ + "/sub/a.txt.br"};
+  std::uint64_t generation;
+  ASSERT_TRUE(cache.watch_paths(paths, generation));
+  cache.insert_missing("/a.txt\nbr", paths, generation);
+  EXPECT_TRUE(cache.missing("/a.txt\nbr"));
+
+  // Creating the directory the second path would be in drops the record
+  ASSERT_EQ(::mkdir((dir_ + "/sub").c_str(), 0700), 0);
+  bool dropped = false;
+  for (int i = 0; i < 200 && !dropped; ++i) {
+    dropped = !cache.missing("/a.txt\nbr");
+    if (!dropped) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(dropped);
+
+  ASSERT_TRUE(cache.watch_paths(paths, generation));
+  cache.insert_missing("/a.txt\nbr", paths, generation);
+  write_file("a.txt.br", "encoded");
+  dropped = false;
+  for (int i = 0; i < 200 && !dropped; ++i) {
+    dropped = !cache.missing("/a.txt\nbr");
+    if (!dropped) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(dropped);
+}
+
+// test that a miss probed before an invalidation is not recorded
+TEST_F(StaticFileCacheTest, StaleMissIgnored) {
+  StaticFileCache cache(1024 * 1024);
+  std::vector<std::string> paths = {dir_ + "/a.txt.gz"};
+  std::uint64_t generation;
+  ASSERT_TRUE(cache.watch_paths(paths, generation));
+  cache.invalidate(dir_ + "/other.txt");
+  cache.insert_missing("/a.txt\ngzip", paths, generation);
+  EXPECT_FALSE(cache.missing("/a.txt\ngzip"));
+
+  StaticFileCache disabled;
+  EXPECT_FALSE(disabled.watch_paths(paths, generation));
+}
+
+// test that a file replaced after being opened is not cached
+TEST_F(StaticFileCacheTest, SkipsFileReplacedAfterOpen) {
+  StaticFileCache cache(1024 * 1024);
+  std::string path = write_file("a.txt", "old");
+  auto file = FileBody::open(path);
+  std::string staged = write_file("a.txt.new", "new");
+  std::rename(staged.c_str(), path.c_str());
+
+  EXPECT_EQ(cache.insert("/a.txt", path, file, text_headers(*file)), nullptr);
+}
+
+// test the HTTP date format against the example in RFC 9110
+TEST(StaticFileCacheFormatTest, HttpDate) {
+  EXPECT_EQ(StaticFileCache::http_date(784111777), "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+// test that all three HTTP date formats parse to the same instant
+TEST(StaticFileCacheFormatTest, ParseHttpDate) {
+  std::time_t t = 0;
+  EXPECT_TRUE(StaticFileCache::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", t));
+  EXPECT_EQ(t, 784111777);
+  t = 0;
+  EXPECT_TRUE(StaticFileCache::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT", t));
+  EXPECT_EQ(t, 784111777);
+  t = 0;
+  EXPECT_TRUE(StaticFileCache::parse_http_date("Sun Nov  6 08:49:37 1994", t));
+  EXPECT_EQ(t, 784111777);
+  EXPECT_FALSE(StaticFileCache::parse_http_date("yesterday", t));
+  EXPECT_FALSE(StaticFileCache::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT trailing", t));
+}
+
+// test that the ETag follows inode, modification time and size
+TEST(StaticFileCacheFormatTest, ETag) {
+  struct stat st = {};
+  st.st_ino = 10;
+  st.st_size = 255;
+  st.st_mtim.tv_sec = 16;
+  st.st_mtim.tv_nsec = 1;
+  EXPECT_EQ(StaticFileCache::make_etag(st), "\"a-10-1-ff\"");
+  st.st_size = 256;
+  EXPECT_NE(StaticFileCache::make_etag(st), "\"a-10-1-ff\"");
+  st.st_size = 255;
+  st.st_ino = 11;
+  EXPECT_NE(StaticFileCache::make_etag(st), "\"a-10-1-ff\"");
+}
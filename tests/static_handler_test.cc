@@ -5,6 +5,12 @@
 #include "request_parser.h"
 #include <boost/system/error_code.hpp>
 #include "http_types.h" 
+#include "static_file_cache.h"
+#include "compression.h"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
 
 class StaticHandlerTestFixture : public ::testing::Test {
 protected:
@@ -71,3 +77,337 @@ TEST_F(StaticHandlerTestFixture, BadPath) {
     
     EXPECT_TRUE(response->status_code == 404);
 }
+
+// test that file contents are handed to the session as a file body
+TEST_F(StaticHandlerTestFixture, ServesFileBody) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+
+    ASSERT_EQ(response->status_code, 200);
+    ASSERT_NE(response->file, nullptr);
+    EXPECT_TRUE(response->body.empty());
+    EXPECT_EQ(response->file->offset(), 0u);
+    EXPECT_EQ(response->file->size(), response->file->file_size());
+}
+
+// test that the sendfile path carries validators too
+TEST_F(StaticHandlerTestFixture, FileBodyHasValidators) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+
+    ASSERT_NE(response->file, nullptr);
+    EXPECT_EQ(response->headers["ETag"], StaticFileCache::make_etag(response->file->stat()));
+    EXPECT_FALSE(response->headers["Last-Modified"].empty());
+}
+
+// test that with the cache enabled a file is read once and then served from memory
+TEST_F(StaticHandlerTestFixture, ServesFromCache) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_capacity(16 * 1024 * 1024);
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+
+    std::unique_ptr<HttpResponse> first = handler.handle_request(req);
+    ASSERT_EQ(first->status_code, 200);
+    EXPECT_EQ(first->file, nullptr);
+    ASSERT_TRUE(first->shared_body);
+    EXPECT_EQ(cache.entries(), 1u);
+
+    std::unique_ptr<HttpResponse> second = handler.handle_request(req);
+    ASSERT_EQ(second->status_code, 200);
+    EXPECT_EQ(second->shared_body, first->shared_body);
+    EXPECT_EQ(second->headers, first->headers);
+    EXPECT_EQ(second->headers["Content-Type"], "text/plain");
+
+    cache.set_capacity(0);
+    EXPECT_EQ(cache.entries(), 0u);
+}
+
+// test that a matching If-None-Match gets a 304 without a body
+TEST_F(StaticHandlerTestFixture, IfNoneMatchNotModified) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::string etag = handler.handle_request(req)->headers["ETag"];
+
+    req.headers.add("If-None-Match", "\"other\", W/" + etag);
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+    EXPECT_EQ(response->status_code, 304);
+    EXPECT_EQ(response->file, nullptr);
+    EXPECT_FALSE(response->shared_body);
+    EXPECT_EQ(response->headers["ETag"], etag);
+
+    req.headers.set("If-None-Match", "*");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 304);
+
+    req.headers.set("If-None-Match", "\"other\"");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+}
+
+// test If-Modified-Since, and that If-None-Match takes precedence over it
+TEST_F(StaticHandlerTestFixture, IfModifiedSince) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::string last_modified = handler.handle_request(req)->headers["Last-Modified"];
+
+    req.headers.add("If-Modified-Since", last_modified);
+    EXPECT_EQ(handler.handle_request(req)->status_code, 304);
+
+    req.headers.set("If-Modified-Since", "Sun, 06 Nov 1994 08:49:37 GMT");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+
+    req.headers.set("If-Modified-Since", "not a date");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+
+    req.headers.set("If-Modified-Since", last_modified);
+    req.headers.add("If-None-Match", "\"other\"");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+}
+
+// test that cached entries answer conditional requests too
+TEST_F(StaticHandlerTestFixture, CachedNotModified) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_capacity(16 * 1024 * 1024);
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::string etag = handler.handle_request(req)->headers["ETag"];
+    ASSERT_EQ(cache.entries(), 1u);
+
+    req.headers.add("If-None-Match", etag);
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+    EXPECT_EQ(response->status_code, 304);
+    EXPECT_FALSE(response->shared_body);
+
+    cache.set_capacity(0);
+}
+
+// test that every file response advertises byte ranges
+TEST_F(StaticHandlerTestFixture, AcceptRanges) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    EXPECT_EQ(handler.handle_request(req)->headers["Accept-Ranges"], "bytes");
+}
+
+// test that a single range sends only that slice of the file
+TEST_F(StaticHandlerTestFixture, SingleRange) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    req.headers.add("Range", "bytes=5-7");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+
+    EXPECT_EQ(response->status_code, 206);
+    EXPECT_EQ(response->headers["Content-Range"], "bytes 5-7/30");
+    EXPECT_EQ(response->headers["Content-Type"], "text/plain");
+    ASSERT_NE(response->file, nullptr);
+    EXPECT_EQ(response->file->offset(), 5u);
+    EXPECT_EQ(response->file->size(), 3u);
+}
+
+// test that a mapped file is served whole and sliced from its mapping
+TEST_F(StaticHandlerTestFixture, MappedFile) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_mmap_limit(1024 * 1024);
+    cache.set_capacity(16 * 16);  // test.txt is over a sixteenth, so it is mapped
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+
+    std::unique_ptr<HttpResponse> whole = handler.handle_request(req);
+    ASSERT_TRUE(whole->shared_body);
+    EXPECT_EQ(whole->shared_body.size(), 30u);
+    EXPECT_EQ(cache.mapped_size(), 30u);
+
+    req.headers.add("Range", "bytes=-5");
+    std::unique_ptr<HttpResponse> part = handler.handle_request(req);
+    EXPECT_EQ(part->status_code, 206);
+    EXPECT_EQ(part->shared_body.view(), "text\n");
+    EXPECT_EQ(part->shared_body.data(), whole->shared_body.data() + 25);
+
+    req.headers.set("Range", "bytes=0-0,-5");
+    std::unique_ptr<HttpResponse> multi = handler.handle_request(req);
+    EXPECT_EQ(multi->status_code, 206);
+    EXPECT_NE(multi->body.find("text\n\r\n"), std::string::npos);
+    cache.set_capacity(0);
+    cache.set_mmap_limit(0);
+}
+
+// test that a cached file serves the same slice as a view of its bytes
+TEST_F(StaticHandlerTestFixture, CachedSingleRange) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_capacity(16 * 1024 * 1024);
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    req.headers.add("Range", "bytes=-5");
+
+    for (int i = 0; i < 2; ++i) {  // the first request fills the cache, the second hits it
+        std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+        EXPECT_EQ(response->status_code, 206);
+        EXPECT_EQ(response->headers["Content-Range"], "bytes 25-29/30");
+        EXPECT_EQ(response->shared_body.view(), "text\n");
+        EXPECT_EQ(response->file, nullptr);
+    }
+    cache.set_capacity(0);
+}
+
+// test that several ranges come back as multipart/byteranges
+TEST_F(StaticHandlerTestFixture, MultipleRanges) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    req.headers.add("Range", "bytes=0-3,25-");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+
+    ASSERT_EQ(response->status_code, 206);
+    EXPECT_EQ(response->file, nullptr);
+    std::string type = response->headers["Content-Type"];
+    const std::string prefix = "multipart/byteranges; boundary=";
+    ASSERT_EQ(type.compare(0, prefix.size(), prefix), 0);
+    std::string boundary = type.substr(prefix.size());
+    EXPECT_EQ(response->body,
+              "--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-3/30\r\n\r\n"
+              "name\r\n"
+              "--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 25-29/30\r\n\r\n"
+              "text\n\r\n"
+              "--" + boundary + "--\r\n");
+}
+
+// test that a range past the end gets a 416 naming the file size
+TEST_F(StaticHandlerTestFixture, UnsatisfiableRange) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    req.headers.add("Range", "bytes=30-");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+
+    EXPECT_EQ(response->status_code, 416);
+    EXPECT_EQ(response->headers["Content-Range"], "bytes */30");
+    EXPECT_EQ(response->file, nullptr);
+}
+
+// test that If-Range only allows a partial response for the current validator
+TEST_F(StaticHandlerTestFixture, IfRange) {
+    HttpRequest req = makeRequest("GET", "/static/test.txt");
+    std::unique_ptr<HttpResponse> full = handler.handle_request(req);
+    req.headers.add("Range", "bytes=0-3");
+
+    req.headers.set("If-Range", full->headers["ETag"]);
+    EXPECT_EQ(handler.handle_request(req)->status_code, 206);
+
+    req.headers.set("If-Range", full->headers["Last-Modified"]);
+    EXPECT_EQ(handler.handle_request(req)->status_code, 206);
+
+    req.headers.set("If-Range", "\"stale\"");
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+
+    req.headers.set("If-Range", "W/" + full->headers["ETag"]);
+    EXPECT_EQ(handler.handle_request(req)->status_code, 200);
+
+    req.headers.set("If-Range", "Sun, 06 Nov 1994 08:49:37 GMT");
+    std::unique_ptr<HttpResponse> response = handler.handle_request(req);
+    EXPECT_EQ(response->status_code, 200);
+    ASSERT_NE(response->file, nullptr);
+    EXPECT_EQ(response->file->size(), 30u);
+}
+
+// Static root in a temp dir, for files the tests create
+class StaticHandlerEncodingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char tmpl[] = "/tmp/static_handler_testXXXXXX";
+        ASSERT_NE(mkdtemp(tmpl), nullptr);
+        dir_ = tmpl;
+        handler_ = std::make_unique<StaticHandler>("/static", dir_);
+        for (int i = 0; i < 100; ++i) page_ += "<p>hello compressible world</p>\n";
+        write("page.html", page_);
+    }
+
+    void TearDown() override {
+        StaticFileCache::instance().set_capacity(0);
+        std::system(("rm -rf " + dir_).c_str());
+    }
+
+    void write(const std::string& name, const std::string& contents) {
+        std::ofstream(dir_ + "/" + name) << contents;
+    }
+
+    std::unique_ptr<HttpResponse> get(const std::string& accept) {
+        HttpRequest req;
+        req.method = "GET";
+        req.path = "/static/page.html";
+        if (!accept.empty()) req.headers.add("Accept-Encoding", accept);
+        return handler_->handle_request(req);
+    }
+
+    std::string dir_;
+    std::string page_;
+    std::unique_ptr<StaticHandler> handler_;
+};
+
+// test that a precompressed sibling is served to clients that accept its coding
+TEST_F(StaticHandlerEncodingTest, ServesPrecompressedSibling) {
+    write("page.html.gz", "pretend gzip");
+
+    auto gz = get("gzip");
+    EXPECT_EQ(gz->status_code, 200);
+    EXPECT_EQ(gz->headers["Content-Encoding"], "gzip");
+    EXPECT_EQ(gz->headers["Content-Type"], "text/html");
+    EXPECT_EQ(gz->headers["Vary"], "Accept-Encoding");
+    ASSERT_NE(gz->file, nullptr);
+    EXPECT_EQ(gz->file->size(), 12u);
+
+    auto plain = get("");
+    EXPECT_EQ(plain->headers.count("Content-Encoding"), 0u);
+    EXPECT_EQ(plain->headers["Vary"], "Accept-Encoding");
+    ASSERT_NE(plain->file, nullptr);
+    EXPECT_EQ(plain->file->size(), page_.size());
+    EXPECT_NE(plain->headers["ETag"], gz->headers["ETag"]);
+}
+
+// test that cached files are compressed once and the result is reused
+TEST_F(StaticHandlerEncodingTest, CachesCompressedVariant) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_capacity(16 * 1024 * 1024);
+
+    auto first = get("gzip, br");
+    EXPECT_EQ(first->headers["Content-Encoding"], "br");
+    ASSERT_TRUE(first->shared_body);
+    EXPECT_LT(first->shared_body.size(), page_.size());
+    EXPECT_EQ(cache.entries(), 2u);  // the file and its brotli encoding
+
+    auto second = get("gzip, br");
+    EXPECT_EQ(second->shared_body, first->shared_body);
+    EXPECT_EQ(second->headers["ETag"], first->headers["ETag"]);
+
+    auto plain = get("");
+    ASSERT_TRUE(plain->shared_body);
+    EXPECT_EQ(plain->shared_body.view(), page_);
+    EXPECT_EQ(Compression::variant_etag(plain->headers["ETag"], ContentCoding::br), first->headers["ETag"]);
+}
+
+// test that a missing sibling is remembered until one is written
+TEST_F(StaticHandlerEncodingTest, RemembersMissingSibling) {
+    auto& cache = StaticFileCache::instance();
+    cache.set_capacity(16 * 1024);  // page.html is too large to hold in memory
+    cache.set_mmap_limit(0);
+
+    auto first = get("br");
+    EXPECT_EQ(first->headers.count("Content-Encoding"), 0u);
+    ASSERT_NE(first->file, nullptr);
+    EXPECT_TRUE(cache.missing(dir_ + "/page.html\nbr"));
+
+    write("page.html.br", "pretend brotli");
+    bool served = false;
+    for (int i = 0; i < 200 && !served; ++i) {
+        served = get("br")->headers["Content-Encoding"] == "br";
+        if (!served) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(served);
+    EXPECT_FALSE(cache.missing(dir_ + "/page.html\nbr"));
+    cache.set_mmap_limit(64 * 1024 * 1024);
+}
+
+// test that images are never compressed
+TEST_F(StaticHandlerEncodingTest, SkipsIncompressibleTypes) {
+    write("image.png", std::string(4096, 'x'));
+    HttpRequest req;
+    req.method = "GET";
+    req.path = "/static/image.png";
+    req.headers.add("Accept-Encoding", "br");
+    auto res = handler_->handle_request(req);
+    EXPECT_EQ(res->status_code, 200);
+    EXPECT_EQ(res->headers.count("Content-Encoding"), 0u);
+    EXPECT_EQ(res->headers.count("Vary"), 0u);
+}
+
+// test that only regular files can back a response
+TEST(FileBodyTest, RejectsDirectoriesAndMissingFiles) {
+    EXPECT_EQ(FileBody::open("../static_files"), nullptr);
+    EXPECT_EQ(FileBody::open("../static_files/missing.txt"), nullptr);
+    EXPECT_NE(FileBody::open("../static_files/test.txt"), nullptr);
+}
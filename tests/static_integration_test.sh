@@ -10,6 +10,11 @@ PORT=8080
 # Temp files
 CONFIG_FILE=$(mktemp)
 RESPONSE_FILE=$(mktemp)
+BIG_DIR=$(mktemp -d)
+DOWNLOAD_FILE=$(mktemp)
+
+# A file large enough that sendfile has to wait for the socket to drain
+head -c 32000000 /dev/urandom > "$BIG_DIR/big.zip"
 
 # Create minimal config file
 cat > "$CONFIG_FILE" <<EOF 
@@ -18,6 +23,10 @@ port $PORT;
 location /static1 StaticHandler {
   root /static_files;
 }
+
+location /big StaticHandler {
+  root $BIG_DIR;
+}
 EOF
 
 # Start server in background
@@ -27,7 +36,8 @@ SERVER_PID=$!
 # Ensure server is stopped and temp files are deleted
 cleanup() {
   kill $SERVER_PID 2>/dev/null || true
-  rm -f "$CONFIG_FILE" "$RESPONSE_FILE"
+  rm -f "$CONFIG_FILE" "$RESPONSE_FILE" "$DOWNLOAD_FILE"
+  rm -rf "$BIG_DIR"
 }
 trap cleanup EXIT
 
@@ -55,4 +65,68 @@ else
   exit 1
 fi
 
+# Large file arrives intact
+curl -s -S "http://localhost:$PORT/big/big.zip" -o "$DOWNLOAD_FILE"
+if cmp -s "$BIG_DIR/big.zip" "$DOWNLOAD_FILE"; then
+  echo "Large static file test passed."
+else
+  echo "Static handler test failed: large file differs ($(stat -c %s "$DOWNLOAD_FILE") bytes received)"
+  exit 1
+fi
+
+# Two files on one keep-alive connection both arrive intact
+curl -s -S "http://localhost:$PORT/static1/test.txt" "http://localhost:$PORT/static1/test.txt" -o "$DOWNLOAD_FILE" -o "$RESPONSE_FILE"
+if cmp -s "$DOWNLOAD_FILE" ../static_files/test.txt && cmp -s "$RESPONSE_FILE" ../static_files/test.txt; then
+  echo "Keep-alive static file test passed."
+else
+  echo "Static handler test failed: files on a reused connection differ"
+  exit 1
+fi
+
+# A range of the large file is exactly that slice, sent as a 206
+curl -s -S -D "$RESPONSE_FILE" -r 1000000-1999999 "http://localhost:$PORT/big/big.zip" -o "$DOWNLOAD_FILE"
+if grep -q "HTTP/1.1 206 Partial Content" "$RESPONSE_FILE" && \
+   cmp -s "$DOWNLOAD_FILE" <(tail -c +1000001 "$BIG_DIR/big.zip" | head -c 1000000); then
+  echo "Range request test passed."
+else
+  echo "Static handler test failed: wrong partial response. Headers were:"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+# A client that accepts gzip gets a gzip body that decodes to the file
+curl -s -S -D "$RESPONSE_FILE" -H "Accept-Encoding: gzip" "http://localhost:$PORT/static1/messages.html" -o "$DOWNLOAD_FILE"
+if grep -qi "^Content-Encoding: gzip" "$RESPONSE_FILE" && \
+   cmp -s <(gzip -dc "$DOWNLOAD_FILE") ../static_files/messages.html; then
+  echo "Compressed static file test passed."
+else
+  echo "Static handler test failed: bad gzip response. Headers were:"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+# A conditional GET with the current ETag gets an empty 304
+echo "version one" > "$BIG_DIR/small.txt"
+ETAG=$(curl -s -S -D - -o /dev/null "http://localhost:$PORT/big/small.txt" | tr -d '\r' | sed -n 's/^ETag: //Ip')
+curl -s -S -i -H "If-None-Match: $ETAG" "http://localhost:$PORT/big/small.txt" -o "$RESPONSE_FILE"
+if grep -q "HTTP/1.1 304 Not Modified" "$RESPONSE_FILE" && ! grep -q "version one" "$RESPONSE_FILE"; then
+  echo "Conditional GET test passed."
+else
+  echo "Static handler test failed: expected 304 for ETag $ETAG. Response was:"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
+# Once the file changes, the old ETag no longer matches and the new contents are served
+echo "version two" > "$BIG_DIR/small.txt"
+sleep 0.1
+curl -s -S -i -H "If-None-Match: $ETAG" "http://localhost:$PORT/big/small.txt" -o "$RESPONSE_FILE"
+if grep -q "HTTP/1.1 200 OK" "$RESPONSE_FILE" && grep -q "version two" "$RESPONSE_FILE"; then
+  echo "Modified file test passed."
+else
+  echo "Static handler test failed: stale response after the file changed. Response was:"
+  cat "$RESPONSE_FILE"
+  exit 1
+fi
+
 exit 0
\ No newline at end of file